@@ -14,6 +14,12 @@ typedef struct mc_fhl_struct
 {
     mc_config_t *config;
     GPtrArray *filters;
+    /* extension -> number of the first filter with it + 1 */
+    GHashTable *extensions;
+    /* same for case insensitive filters, keys are lower-cased */
+    GHashTable *extensions_nocase;
+    /* changed each time the rules are parsed to invalidate colors cached in file entries */
+    unsigned int generation;
 } mc_fhl_t;
 
 /*** global variables defined in .c file *********************************************************/
@@ -52,13 +52,13 @@ mc_fhl_is_file (file_entry_t * fe)
 #if HAVE_S_ISREG == 0
     (void) fe;
 #endif
-    return S_ISREG (fe->st.st_mode);
+    return S_ISREG (fe->st.mode);
 }
 
 inline static gboolean
 mc_fhl_is_file_exec (file_entry_t * fe)
 {
-    return is_exe (fe->st.st_mode);
+    return is_exe (fe->st.mode);
 }
 
 inline static gboolean
@@ -67,7 +67,7 @@ mc_fhl_is_dir (file_entry_t * fe)
 #if HAVE_S_ISDIR == 0
     (void) fe;
 #endif
-    return S_ISDIR (fe->st.st_mode);
+    return S_ISDIR (fe->st.mode);
 }
 
 inline static gboolean
@@ -76,13 +76,13 @@ mc_fhl_is_link (file_entry_t * fe)
 #if HAVE_S_ISLNK == 0
     (void) fe;
 #endif
-    return S_ISLNK (fe->st.st_mode);
+    return S_ISLNK (fe->st.mode);
 }
 
 inline static gboolean
 mc_fhl_is_hlink (file_entry_t * fe)
 {
-    return (fe->st.st_nlink > 1);
+    return (fe->st.nlink > 1);
 }
 
 inline static gboolean
@@ -103,7 +103,7 @@ mc_fhl_is_device_char (file_entry_t * fe)
 #if HAVE_S_ISCHR == 0
     (void) fe;
 #endif
-    return S_ISCHR (fe->st.st_mode);
+    return S_ISCHR (fe->st.mode);
 }
 
 inline static gboolean
@@ -112,7 +112,7 @@ mc_fhl_is_device_block (file_entry_t * fe)
 #if HAVE_S_ISBLK == 0
     (void) fe;
 #endif
-    return S_ISBLK (fe->st.st_mode);
+    return S_ISBLK (fe->st.mode);
 }
 
 inline static gboolean
@@ -121,7 +121,7 @@ mc_fhl_is_special_socket (file_entry_t * fe)
 #if HAVE_S_ISSOCK == 0
     (void) fe;
 #endif
-    return S_ISSOCK (fe->st.st_mode);
+    return S_ISSOCK (fe->st.mode);
 }
 
 inline static gboolean
@@ -130,7 +130,7 @@ mc_fhl_is_special_fifo (file_entry_t * fe)
 #if HAVE_S_ISFIFO == 0
     (void) fe;
 #endif
-    return S_ISFIFO (fe->st.st_mode);
+    return S_ISFIFO (fe->st.mode);
 }
 
 inline static gboolean
@@ -140,7 +140,7 @@ mc_fhl_is_special_door (file_entry_t * fe)
     (void) fe;
 #endif
 
-    return S_ISDOOR (fe->st.st_mode);
+    return S_ISDOOR (fe->st.mode);
 }
 
 
@@ -246,25 +246,64 @@ mc_fhl_get_color_regexp (mc_fhl_filter_t * mc_filter, mc_fhl_t * fhl, file_entry
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the first extension filter matching the file name.
+ * Each suffix following a dot is looked up, because extensions may contain dots too.
+ *
+ * @return number of filter or G_MAXUINT if not found
+ */
+
+static guint
+mc_fhl_get_extension_filter (mc_fhl_t * fhl, file_entry_t * fe)
+{
+    guint ret = G_MAXUINT;
+    const char *dot;
+    char *lower = NULL;
+
+    for (dot = strchr (fe->fname, '.'); dot != NULL; dot = strchr (dot + 1, '.'))
+    {
+        gpointer filter_num;
+
+        filter_num = g_hash_table_lookup (fhl->extensions, dot + 1);
+        if (filter_num != NULL)
+            ret = MIN (ret, GPOINTER_TO_UINT (filter_num) - 1);
+
+        if (g_hash_table_size (fhl->extensions_nocase) != 0)
+        {
+            if (lower == NULL)
+                lower = g_ascii_strdown (fe->fname, fe->fnamelen);
+
+            filter_num =
+                g_hash_table_lookup (fhl->extensions_nocase, lower + (dot - fe->fname) + 1);
+            if (filter_num != NULL)
+                ret = MIN (ret, GPOINTER_TO_UINT (filter_num) - 1);
+        }
+    }
+
+    g_free (lower);
+
+    return ret;
+}
 
-/* --------------------------------------------------------------------------------------------- */
-/*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-int
-mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
+static int
+mc_fhl_compute_color (mc_fhl_t * fhl, file_entry_t * fe)
 {
-    guint i;
+    guint i, ext_filter;
     int ret;
 
-    if (fhl == NULL)
-        return NORMAL_COLOR;
+    ext_filter = mc_fhl_get_extension_filter (fhl, fe);
 
     for (i = 0; i < fhl->filters->len; i++)
     {
         mc_fhl_filter_t *mc_filter;
 
         mc_filter = (mc_fhl_filter_t *) g_ptr_array_index (fhl->filters, i);
+
+        if (i == ext_filter)
+            return -mc_filter->color_pair_index;
+
         switch (mc_filter->type)
         {
         case MC_FLHGH_T_FTYPE:
@@ -272,7 +311,6 @@ mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
             if (ret > 0)
                 return -ret;
             break;
-        case MC_FLHGH_T_EXT:
         case MC_FLHGH_T_FREGEXP:
             ret = mc_fhl_get_color_regexp (mc_filter, fhl, fe);
             if (ret > 0)
@@ -286,3 +324,25 @@ mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get color of file. Result is cached in the file entry until the rules are reloaded.
+ */
+
+int
+mc_fhl_get_color (mc_fhl_t * fhl, file_entry_t * fe)
+{
+    if (fhl == NULL || fhl->filters == NULL)
+        return NORMAL_COLOR;
+
+    if (fe->color_generation != fhl->generation)
+    {
+        fe->color = mc_fhl_compute_color (fhl, fe);
+        fe->color_generation = fhl->generation;
+    }
+
+    return fe->color;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -29,7 +29,6 @@
 
 #include "lib/global.h"
 #include "lib/fileloc.h"
-#include "lib/strescape.h"
 #include "lib/skin.h"
 #include "lib/util.h"           /* exist_file() */
 #include "lib/filehighlight.h"
@@ -130,7 +129,9 @@ mc_fhl_parse_get_extensions (mc_fhl_t * fhl, const gchar * group_name)
 {
     mc_fhl_filter_t *mc_filter;
     gchar **exts, **exts_orig;
-    GString *buf;
+    gboolean case_sensitive;
+    GHashTable *extensions;
+    gpointer filter_num;
 
     exts_orig = mc_config_get_string_list (fhl->config, group_name, "extensions", NULL);
     if (exts_orig == NULL || exts_orig[0] == NULL)
@@ -139,33 +140,32 @@ mc_fhl_parse_get_extensions (mc_fhl_t * fhl, const gchar * group_name)
         return FALSE;
     }
 
-    buf = g_string_sized_new (64);
+    mc_filter = g_new0 (mc_fhl_filter_t, 1);
+    mc_filter->type = MC_FLHGH_T_EXT;
+    mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
 
-    for (exts = exts_orig; *exts != NULL; exts++)
-    {
-        char *esc_ext;
+    case_sensitive = mc_config_get_bool (fhl->config, group_name, "extensions_case", FALSE);
+    extensions = case_sensitive ? fhl->extensions : fhl->extensions_nocase;
+    filter_num = GUINT_TO_POINTER (fhl->filters->len + 1);
 
-        esc_ext = strutils_regex_escape (*exts);
-        if (buf->len != 0)
-            g_string_append_c (buf, '|');
-        g_string_append (buf, esc_ext);
-        g_free (esc_ext);
-    }
-    g_strfreev (exts_orig);
+    /* filters without color never match */
+    if (mc_filter->color_pair_index > 0)
+        for (exts = exts_orig; *exts != NULL; exts++)
+        {
+            char *ext;
 
-    g_string_prepend (buf, ".*\\.(");
-    g_string_append (buf, ")$");
+            ext = case_sensitive ? g_strdup (*exts) : g_ascii_strdown (*exts, -1);
 
-    mc_filter = g_new0 (mc_fhl_filter_t, 1);
-    mc_filter->type = MC_FLHGH_T_FREGEXP;
-    mc_filter->search_condition = mc_search_new_len (buf->str, buf->len, DEFAULT_CHARSET);
-    mc_filter->search_condition->is_case_sensitive =
-        mc_config_get_bool (fhl->config, group_name, "extensions_case", FALSE);
-    mc_filter->search_condition->search_type = MC_SEARCH_T_REGEX;
+            /* the first filter wins */
+            if (g_hash_table_lookup (extensions, ext) == NULL)
+                g_hash_table_insert (extensions, ext, filter_num);
+            else
+                g_free (ext);
+        }
+
+    g_strfreev (exts_orig);
 
-    mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
     g_ptr_array_add (fhl->filters, (gpointer) mc_filter);
-    g_string_free (buf, TRUE);
     return TRUE;
 }
 
@@ -222,9 +222,17 @@ mc_fhl_parse_ini_file (mc_fhl_t * fhl)
 {
     gchar **group_names, **orig_group_names;
     gboolean ok;
+    static unsigned int generation = 0;
 
     mc_fhl_array_free (fhl);
     fhl->filters = g_ptr_array_new ();
+    fhl->extensions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    fhl->extensions_nocase = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    /* 0 means "not computed" in file entries */
+    if (++generation == 0)
+        generation++;
+    fhl->generation = generation;
 
     orig_group_names = mc_config_get_groups (fhl->config, NULL);
     ok = (*orig_group_names != NULL);
@@ -45,6 +45,7 @@
 #define FISH_MV_FILE            "mv"
 #define FISH_HARDLINK_FILE      "hardlink"
 #define FISH_GET_FILE           "get"
+#define FISH_GETRANGE_FILE      "getrange"
 #define FISH_SEND_FILE          "send"
 #define FISH_APPEND_FILE        "append"
 #define FISH_INFO_FILE          "info"
@@ -62,6 +63,7 @@
 #define MC_PANELS_FILE          "panels.ini"
 #define MC_FHL_INI_FILE         "filehighlight.ini"
 #define MC_SKINS_SUBDIR         "skins"
+#define MC_VFS_DIRCACHE_DIR     "vfsdir"
 
 /* editor home directory */
 #define EDIT_DIR                "mcedit"
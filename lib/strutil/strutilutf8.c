@@ -38,6 +38,18 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+/* flags of character in str_utf8_char_info () */
+#define UTF8_CHAR_WIDTH_MASK 0x03       /* 0 for combining marks, 2 for wide characters */
+#define UTF8_CHAR_PRINTABLE 0x04
+#define UTF8_CHAR_KNOWN 0x08    /* cached info is valid */
+
+/* characters of Basic Multilingual Plane have cached info */
+#define UTF8_CHAR_PAGE_SHIFT 8
+#define UTF8_CHAR_PAGES (0x10000 >> UTF8_CHAR_PAGE_SHIFT)
+
+#define UTF8_WORD_ONES ((guint64) 0x0101010101010101ULL)
+#define UTF8_WORD_HIGHS ((guint64) 0x8080808080808080ULL)
+
 /*** file scope type declarations ****************************************************************/
 
 struct utf8_tool
@@ -47,6 +59,7 @@ struct utf8_tool
     const char *checked;
     int ident;
     gboolean compose;
+    gboolean ascii;             /* checked contains printable ASCII characters only */
 };
 
 struct term_form
@@ -54,12 +67,16 @@ struct term_form
     char text[BUF_MEDIUM * 6];
     size_t width;
     gboolean compose;
+    gboolean ascii;             /* text contains printable ASCII characters only */
 };
 
 /*** file scope variables ************************************************************************/
 
 static const char replch[] = "\xEF\xBF\xBD";
 
+/* lazily filled pages of character info, see str_utf8_char_info () */
+static guint8 *char_info_pages[UTF8_CHAR_PAGES];
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -76,6 +93,97 @@ str_unichar_iscombiningmark (gunichar uni)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static guint8
+str_utf8_make_char_info (gunichar uni)
+{
+    guint8 info = UTF8_CHAR_KNOWN;
+
+    if (g_unichar_isprint (uni))
+        info |= UTF8_CHAR_PRINTABLE;
+
+    if (!str_unichar_iscombiningmark (uni))
+        info |= g_unichar_iswide (uni) ? 2 : 1;
+
+    return info;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get width and printability of character. Unicode tables of glib are looked up by binary
+ * search, so results for Basic Multilingual Plane are kept in pages of 256 characters.
+ */
+
+static inline guint8
+str_utf8_char_info (gunichar uni)
+{
+    guint8 *page;
+    guint8 info;
+
+    if (uni >= 0x10000)
+        return str_utf8_make_char_info (uni);
+
+    page = char_info_pages[uni >> UTF8_CHAR_PAGE_SHIFT];
+    if (page == NULL)
+    {
+        page = g_new0 (guint8, 1 << UTF8_CHAR_PAGE_SHIFT);
+        char_info_pages[uni >> UTF8_CHAR_PAGE_SHIFT] = page;
+    }
+
+    info = page[uni & ((1 << UTF8_CHAR_PAGE_SHIFT) - 1)];
+    if (info == 0)
+    {
+        info = str_utf8_make_char_info (uni);
+        page[uni & ((1 << UTF8_CHAR_PAGE_SHIFT) - 1)] = info;
+    }
+
+    return info;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline int
+str_utf8_char_width (gunichar uni)
+{
+    return (int) (str_utf8_char_info (uni) & UTF8_CHAR_WIDTH_MASK);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get length of printable ASCII prefix of string. Eight bytes are checked at once.
+ *
+ * @param text string
+ * @param length number of bytes to check, must not exceed the length of string
+ *
+ * @return number of leading bytes in range 0x20...0x7E
+ */
+
+static size_t
+str_utf8_ascii_prefix (const char *text, size_t length)
+{
+    size_t n = 0;
+
+    while (length - n >= sizeof (guint64))
+    {
+        guint64 w;
+
+        memcpy (&w, text + n, sizeof (w));
+
+        /* any byte >= 0x80, < 0x20 (including '\0') or == 0x7F */
+        if ((((w | (w - UTF8_WORD_ONES * 0x20)) | ((w ^ (UTF8_WORD_ONES * 0x7F)) - UTF8_WORD_ONES))
+             & UTF8_WORD_HIGHS) != 0)
+            break;
+
+        n += sizeof (w);
+    }
+
+    while (n < length && (guchar) text[n] >= 0x20 && (guchar) text[n] < 0x7F)
+        n++;
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static void
 str_utf8_insert_replace_char (GString * buffer)
 {
@@ -443,19 +551,34 @@ str_utf8_make_make_term_form (const char *text, size_t length)
     gunichar uni;
     size_t left;
     char *actual;
+    /* longest output of one character is 6 bytes */
+    const char *end = result.text + sizeof (result.text) - 7;
 
     result.text[0] = '\0';
     result.width = 0;
     result.compose = FALSE;
     actual = result.text;
 
+    /* Most strings are plain ASCII: copy leading printable ASCII characters at once */
+    left = strlen (text);
+    if (length < left)
+        left = length;
+    left = str_utf8_ascii_prefix (text, MIN (left, (size_t) (end - actual)));
+    memcpy (actual, text, left);
+    actual += left;
+    text += left;
+    result.width += left;
+    if (length != (size_t) (-1))
+        length -= left;
+
+    result.ascii = length == 0 || text[0] == '\0';
+
     /* check if text start with combining character,
      * add space at begin in this case */
-    if (length != 0 && text[0] != '\0')
+    if (actual == result.text && length != 0 && text[0] != '\0')
     {
         uni = g_utf8_get_char_validated (text, -1);
-        if ((uni != (gunichar) (-1)) && (uni != (gunichar) (-2))
-            && str_unichar_iscombiningmark (uni))
+        if ((uni != (gunichar) (-1)) && (uni != (gunichar) (-2)) && str_utf8_char_width (uni) == 0)
         {
             actual[0] = ' ';
             actual++;
@@ -464,23 +587,31 @@ str_utf8_make_make_term_form (const char *text, size_t length)
         }
     }
 
-    while (length != 0 && text[0] != '\0')
+    while (length != 0 && text[0] != '\0' && actual < end)
     {
+        if ((guchar) text[0] >= 0x20 && (guchar) text[0] < 0x7F)
+        {
+            *actual++ = *text++;
+            result.width++;
+            if (length != (size_t) (-1))
+                length--;
+            continue;
+        }
+
         uni = g_utf8_get_char_validated (text, -1);
         if ((uni != (gunichar) (-1)) && (uni != (gunichar) (-2)))
         {
-            if (g_unichar_isprint (uni))
+            guint8 info;
+
+            info = str_utf8_char_info (uni);
+            if ((info & UTF8_CHAR_PRINTABLE) != 0)
             {
                 left = g_unichar_to_utf8 (uni, actual);
                 actual += left;
-                if (str_unichar_iscombiningmark (uni))
+                if ((info & UTF8_CHAR_WIDTH_MASK) == 0)
                     result.compose = TRUE;
                 else
-                {
-                    result.width++;
-                    if (g_unichar_iswide (uni))
-                        result.width++;
-                }
+                    result.width += info & UTF8_CHAR_WIDTH_MASK;
             }
             else
             {
@@ -538,6 +669,23 @@ utf8_tool_copy_chars_to_end (struct utf8_tool *tool)
 {
     tool->compose = FALSE;
 
+    if (tool->ascii)
+    {
+        size_t n;
+        gboolean ok;
+
+        n = strlen (tool->checked);
+        ok = n < tool->remain;
+        if (!ok)
+            n = tool->remain - 1;
+
+        memcpy (tool->actual, tool->checked, n);
+        tool->actual += n;
+        tool->remain -= n;
+        tool->checked += n;
+        return ok;
+    }
+
     while (tool->checked[0] != '\0')
     {
         gunichar uni;
@@ -566,23 +714,41 @@ utf8_tool_copy_chars_to (struct utf8_tool *tool, int to_ident)
 {
     tool->compose = FALSE;
 
+    if (tool->ascii)
+    {
+        size_t n;
+        gboolean ok;
+
+        n = strlen (tool->checked);
+        if (to_ident <= tool->ident)
+            n = 0;
+        else if ((size_t) (to_ident - tool->ident) < n)
+            n = (size_t) (to_ident - tool->ident);
+
+        ok = n < tool->remain;
+        if (!ok)
+            n = tool->remain - 1;
+
+        memcpy (tool->actual, tool->checked, n);
+        tool->actual += n;
+        tool->remain -= n;
+        tool->checked += n;
+        tool->ident += n;
+        return ok;
+    }
+
     while (tool->checked[0] != '\0')
     {
         gunichar uni;
         size_t left;
-        int w = 0;
+        int w;
 
         uni = g_utf8_get_char (tool->checked);
-        if (str_unichar_iscombiningmark (uni))
+        w = str_utf8_char_width (uni);
+        if (w == 0)
             tool->compose = TRUE;
-        else
-        {
-            w = 1;
-            if (g_unichar_iswide (uni))
-                w++;
-            if (tool->ident + w > to_ident)
-                return TRUE;
-        }
+        else if (tool->ident + w > to_ident)
+            return TRUE;
 
         left = g_unichar_to_utf8 (uni, NULL);
         if (tool->remain <= left)
@@ -638,20 +804,31 @@ utf8_tool_skip_chars_to (struct utf8_tool *tool, int to_ident)
 {
     gunichar uni;
 
+    if (tool->ascii)
+    {
+        size_t n;
+
+        if (to_ident <= tool->ident)
+            return TRUE;
+
+        n = strlen (tool->checked);
+        if ((size_t) (to_ident - tool->ident) < n)
+            n = (size_t) (to_ident - tool->ident);
+
+        tool->checked += n;
+        tool->ident += n;
+        return TRUE;
+    }
+
     while (to_ident > tool->ident && tool->checked[0] != '\0')
     {
         uni = g_utf8_get_char (tool->checked);
-        if (!str_unichar_iscombiningmark (uni))
-        {
-            tool->ident++;
-            if (g_unichar_iswide (uni))
-                tool->ident++;
-        }
+        tool->ident += str_utf8_char_width (uni);
         tool->checked = g_utf8_next_char (tool->checked);
     }
 
     uni = g_utf8_get_char (tool->checked);
-    while (str_unichar_iscombiningmark (uni))
+    while (uni != 0 && str_utf8_char_width (uni) == 0)
     {
         tool->checked = g_utf8_next_char (tool->checked);
         uni = g_utf8_get_char (tool->checked);
@@ -683,6 +860,7 @@ str_utf8_fit_to_term (const char *text, int width, align_crt_t just_mode)
 
     pre_form = str_utf8_make_make_term_form (text, (size_t) (-1));
     tool.checked = pre_form->text;
+    tool.ascii = pre_form->ascii;
     tool.actual = result;
     tool.remain = sizeof (result);
     tool.compose = FALSE;
@@ -763,6 +941,7 @@ str_utf8_term_trim (const char *text, int width)
     pre_form = str_utf8_make_make_term_form (text, (size_t) (-1));
 
     tool.checked = pre_form->text;
+    tool.ascii = pre_form->ascii;
     tool.actual = result;
     tool.remain = sizeof (result);
     tool.compose = FALSE;
@@ -818,8 +997,11 @@ str_utf8_term_char_width (const char *text)
 {
     gunichar uni;
 
+    if ((guchar) text[0] < 0x80)
+        return 1;
+
     uni = g_utf8_get_char_validated (text, -1);
-    return (str_unichar_iscombiningmark (uni)) ? 0 : ((g_unichar_iswide (uni)) ? 2 : 1);
+    return str_utf8_char_width (uni);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -834,6 +1016,7 @@ str_utf8_term_substring (const char *text, int start, int width)
     pre_form = str_utf8_make_make_term_form (text, (size_t) (-1));
 
     tool.checked = pre_form->text;
+    tool.ascii = pre_form->ascii;
     tool.actual = result;
     tool.remain = sizeof (result);
     tool.compose = FALSE;
@@ -865,6 +1048,7 @@ str_utf8_trunc (const char *text, int width)
     pre_form = str_utf8_make_make_term_form (text, (size_t) (-1));
 
     tool.checked = pre_form->text;
+    tool.ascii = pre_form->ascii;
     tool.actual = result;
     tool.remain = sizeof (result);
     tool.compose = FALSE;
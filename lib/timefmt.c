@@ -51,10 +51,30 @@ char *user_old_timeformat = NULL;       /* time format string for older dates */
 
 /*** file scope macro definitions ****************************************************************/
 
+/* Number of formatted dates kept by file_date(). Must be a power of 2 */
+#define FILE_DATE_CACHE_SIZE 256
+
 /*** file scope type declarations ****************************************************************/
 
+typedef struct
+{
+    time_t when;
+    int fmt;                    /* index of format in file_date_fmt plus 1, 0 if slot is empty */
+    char text[MB_LEN_MAX * MAX_I18NTIMELENGTH + 1];
+} file_date_cache_t;
+
 /*** file scope variables ************************************************************************/
 
+/*
+ * Recently formatted dates. localtime() and strftime() are slow enough to dominate
+ * painting of long file listings, and the same dates are formatted again on each repaint.
+ * Slots are addressed by the low bits of time, files created at once get different slots.
+ */
+static file_date_cache_t file_date_cache[FILE_DATE_CACHE_SIZE];
+
+/* copies of recent and old time formats the cached dates were made with */
+static char *file_date_fmt[2] = { NULL, NULL };
+
 /*
  * Cache variable for the i18n_checktimelength function,
  * initially set to a clearly invalid value to show that
@@ -124,12 +144,22 @@ i18n_checktimelength (void)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Format time of file with user_recent_timeformat or user_old_timeformat.
+ * Results are cached until the format is changed.
+ *
+ * @param when time to format
+ *
+ * @return pointer to static buffer that is valid until the next call
+ */
+
 const char *
 file_date (time_t when)
 {
-    static char timebuf[MB_LEN_MAX * MAX_I18NTIMELENGTH + 1];
     time_t current_time = time (NULL);
     const char *fmt;
+    int fmt_index;
+    file_date_cache_t *slot;
 
     if (current_time > when + 6L * 30L * 24L * 60L * 60L        /* Old. */
         || current_time < when - 60L * 60L)     /* In the future. */
@@ -140,13 +170,39 @@ file_date (time_t when)
            to allow for NFS server/client clock disagreement.
            Show the year instead of the time of day.  */
 
+    {
         fmt = user_old_timeformat;
+        fmt_index = 1;
+    }
     else
+    {
         fmt = user_recent_timeformat;
+        fmt_index = 0;
+    }
+
+    if (file_date_fmt[fmt_index] == NULL || strcmp (file_date_fmt[fmt_index], fmt) != 0)
+    {
+        size_t i;
+
+        /* format is changed: forget dates made with the old one */
+        for (i = 0; i < FILE_DATE_CACHE_SIZE; i++)
+            if (file_date_cache[i].fmt == fmt_index + 1)
+                file_date_cache[i].fmt = 0;
 
-    FMT_LOCALTIME (timebuf, sizeof (timebuf), fmt, when);
+        g_free (file_date_fmt[fmt_index]);
+        file_date_fmt[fmt_index] = g_strdup (fmt);
+    }
+
+    slot = &file_date_cache[(guint64) when & (FILE_DATE_CACHE_SIZE - 1)];
+
+    if (slot->fmt != fmt_index + 1 || slot->when != when)
+    {
+        FMT_LOCALTIME (slot->text, sizeof (slot->text), fmt, when);
+        slot->when = when;
+        slot->fmt = fmt_index + 1;
+    }
 
-    return timebuf;
+    return slot->text;
 }
 
 /* --------------------------------------------------------------------------------------------- */
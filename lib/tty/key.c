@@ -53,7 +53,7 @@
 #include "mouse.h"
 #include "key.h"
 
-#include "lib/widget.h"         /* mc_refresh() */
+#include "lib/widget.h"         /* mc_refresh(), mc_refresh_deferred() */
 
 #ifdef HAVE_TEXTMODE_X11_SUPPORT
 #include "x11conn.h"
@@ -521,7 +521,11 @@ static key_def *keys = NULL;
 static int input_fd;
 static int disabled_channels = 0;       /* Disable channels checking */
 
-static GSList *select_list = NULL;
+/* channels by file descriptor */
+static GHashTable *select_channels = NULL;
+/* descriptors of channels, kept ready to be copied into the set for select () */
+static fd_set select_channels_set;
+static int select_channels_max_fd = -1;
 
 static int seq_buffer[SEQ_BUFFER_LEN];
 static int *seq_append = NULL;
@@ -551,48 +555,23 @@ static const key_code_name_t *key_conv_tab_sorted[G_N_ELEMENTS (key_name_conv_ta
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-static int
-select_cmp_by_fd_set (gconstpointer a, gconstpointer b)
-{
-    const select_t *s = (const select_t *) a;
-    const fd_set *f = (const fd_set *) b;
-
-    return (FD_ISSET (s->fd, f) ? 0 : 1);
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-static int
-select_cmp_by_fd (gconstpointer a, gconstpointer b)
-{
-    const select_t *s = (const select_t *) a;
-    const int fd = GPOINTER_TO_INT (b);
-
-    return (s->fd == fd ? 0 : 1);
-}
-
-/* --------------------------------------------------------------------------------------------- */
+/**
+ * Initialize the set of descriptors for select () with descriptors of channels.
+ *
+ * @return highest descriptor in the set or -1 if the set is empty
+ */
 
 static int
 add_selects (fd_set * select_set)
 {
-    int top_fd = 0;
-
-    if (disabled_channels == 0)
+    if (disabled_channels != 0 || select_channels_max_fd < 0)
     {
-        GSList *s;
-
-        for (s = select_list; s != NULL; s = g_slist_next (s))
-        {
-            select_t *p = (select_t *) s->data;
-
-            FD_SET (p->fd, select_set);
-            if (p->fd > top_fd)
-                top_fd = p->fd;
-        }
+        FD_ZERO (select_set);
+        return -1;
     }
 
-    return top_fd;
+    *select_set = select_channels_set;
+    return select_channels_max_fd;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -600,19 +579,18 @@ add_selects (fd_set * select_set)
 static void
 check_selects (fd_set * select_set)
 {
-    while (disabled_channels == 0)
-    {
-        GSList *s;
-        select_t *p;
+    int fd;
 
-        s = g_slist_find_custom (select_list, select_set, select_cmp_by_fd_set);
-        if (s == NULL)
-            break;
+    /* callbacks may add and delete channels, so channel is looked up for every ready descriptor */
+    for (fd = 0; fd <= select_channels_max_fd && disabled_channels == 0; fd++)
+        if (FD_ISSET (fd, select_set) && FD_ISSET (fd, &select_channels_set))
+        {
+            select_t *p;
 
-        p = (select_t *) s->data;
-        FD_CLR (p->fd, select_set);
-        p->callback (p->fd, p->info);
-    }
+            FD_CLR (fd, select_set);
+            p = (select_t *) g_hash_table_lookup (select_channels, GINT_TO_POINTER (fd));
+            p->callback (p->fd, p->info);
+        }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -629,9 +607,8 @@ try_channels (gboolean set_timeout)
         struct timeval *timeptr = NULL;
         int maxfdp, v;
 
-        FD_ZERO (&select_set);
-        FD_SET (input_fd, &select_set); /* Add stdin */
         maxfdp = MAX (add_selects (&select_set), input_fd);
+        FD_SET (input_fd, &select_set); /* Add stdin */
 
         if (set_timeout)
         {
@@ -1382,7 +1359,12 @@ void
 done_key (void)
 {
     k_dispose (keys);
-    g_slist_free_full (select_list, g_free);
+    if (select_channels != NULL)
+    {
+        g_hash_table_destroy (select_channels);
+        select_channels = NULL;
+    }
+    select_channels_max_fd = -1;
 
 #ifdef HAVE_TEXTMODE_X11_SUPPORT
     if (x11_display)
@@ -1392,17 +1374,30 @@ done_key (void)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Watch file descriptor while waiting for input: callback is called when fd is ready for reading.
+ * A new channel replaces the channel with the same descriptor.
+ */
+
 void
 add_select_channel (int fd, select_fn callback, void *info)
 {
     select_t *new;
 
+    if (select_channels == NULL)
+    {
+        select_channels = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+        FD_ZERO (&select_channels_set);
+    }
+
     new = g_new (select_t, 1);
     new->fd = fd;
     new->callback = callback;
     new->info = info;
 
-    select_list = g_slist_prepend (select_list, new);
+    g_hash_table_replace (select_channels, GINT_TO_POINTER (fd), new);
+    FD_SET (fd, &select_channels_set);
+    select_channels_max_fd = MAX (select_channels_max_fd, fd);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1410,11 +1405,15 @@ add_select_channel (int fd, select_fn callback, void *info)
 void
 delete_select_channel (int fd)
 {
-    GSList *p;
+    if (select_channels == NULL || !g_hash_table_remove (select_channels, GINT_TO_POINTER (fd)))
+        return;
+
+    FD_CLR (fd, &select_channels_set);
 
-    p = g_slist_find_custom (select_list, GINT_TO_POINTER (fd), select_cmp_by_fd);
-    if (p != NULL)
-        select_list = g_slist_delete_link (select_list, p);
+    if (fd == select_channels_max_fd)
+        while (select_channels_max_fd >= 0
+               && !FD_ISSET (select_channels_max_fd, &select_channels_set))
+            select_channels_max_fd--;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1943,7 +1942,12 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
     struct timeval *time_addr = NULL;
     static int dirty = 3;
 
-    if ((dirty == 3) || is_idle ())
+    if (!block)
+    {
+        /* caller polls input while doing some work: don't flood the terminal with updates */
+        mc_refresh_deferred ();
+    }
+    else if ((dirty == 3) || is_idle ())
     {
         mc_refresh ();
         dirty = 1;
@@ -1970,9 +1974,8 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
         int nfd;
         fd_set select_set;
 
-        FD_ZERO (&select_set);
-        FD_SET (input_fd, &select_set);
         nfd = MAX (add_selects (&select_set), MAX (0, input_fd)) + 1;
+        FD_SET (input_fd, &select_set);
 
 #ifdef HAVE_LIBGPM
         if (mouse_enabled && (use_mouse_p == MOUSE_GPM))
@@ -2012,16 +2015,12 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
         {
             int seconds;
 
+            /* wake up when the next vfs entry in the stamp list timeouts */
             seconds = vfs_timeouts ();
             time_addr = NULL;
 
             if (seconds != 0)
             {
-                /* the timeout could be improved and actually be
-                 * the number of seconds until the next vfs entry
-                 * timeouts in the stamp list.
-                 */
-
                 time_out.tv_sec = seconds;
                 time_out.tv_usec = 0;
                 time_addr = &time_out;
@@ -2042,7 +2041,7 @@ tty_get_event (struct Gpm_Event *event, gboolean redo_event, gboolean block)
         /* select timed out: it could be for any of the following reasons:
          * redo_event -> it was because of the MOU_REPEAT handler
          * !block     -> we did not block in the select call
-         * else       -> 10 second timeout to check the vfs status.
+         * else       -> timeout of the next vfs entry in the stamp list.
          */
         if (flag == 0)
         {
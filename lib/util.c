@@ -1532,3 +1532,54 @@ mc_time_elapsed (guint64 * timestamp, guint64 delay)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy attributes used in file lists from struct stat.
+ *
+ * @param fst compact file attributes
+ * @param st file stat info
+ */
+
+void
+file_stat_from_stat (file_stat_t * fst, const struct stat *st)
+{
+    fst->size = st->st_size;
+    fst->atime = st->st_atime;
+    fst->mtime = st->st_mtime;
+    fst->ctime = st->st_ctime;
+    fst->ino = st->st_ino;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    fst->rdev = st->st_rdev;
+#endif
+    fst->mode = st->st_mode;
+    fst->uid = st->st_uid;
+    fst->gid = st->st_gid;
+    fst->nlink = (unsigned int) st->st_nlink;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fill struct stat from compact file attributes. Fields not kept in file_stat_t are zeroed.
+ *
+ * @param fst compact file attributes
+ * @param st file stat info
+ */
+
+void
+file_stat_to_stat (const file_stat_t * fst, struct stat *st)
+{
+    memset (st, 0, sizeof (*st));
+    st->st_size = fst->size;
+    st->st_atime = fst->atime;
+    st->st_mtime = fst->mtime;
+    st->st_ctime = fst->ctime;
+    st->st_ino = fst->ino;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    st->st_rdev = fst->rdev;
+#endif
+    st->st_mode = fst->mode;
+    st->st_uid = fst->uid;
+    st->st_gid = fst->gid;
+    st->st_nlink = (nlink_t) fst->nlink;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -97,17 +97,37 @@ typedef struct
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
-/* keys are set only during sorting */
+/* Attributes of file used in file lists: a compact copy of struct stat */
+typedef struct
+{
+    off_t size;
+    time_t atime;
+    time_t mtime;
+    time_t ctime;
+    ino_t ino;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    dev_t rdev;
+#endif
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    unsigned int nlink;
+} file_stat_t;
+
 typedef struct
 {
     /* File attributes */
     size_t fnamelen;
     char *fname;
-    struct stat st;
+    file_stat_t st;
     /* key used for comparing names */
     char *sort_key;
     /* key used for comparing extensions */
     char *second_sort_key;
+    /* cached result of mc_fhl_get_color () */
+    int color;
+    /* generation of highlighting rules the color was computed with, 0 if not computed yet */
+    unsigned int color_generation;
 
     /* Flags */
     struct
@@ -182,7 +202,7 @@ char *load_mc_home_file (const char *from, const char *filename, char **allocate
 /* uid/gid managing */
 void init_groups (void);
 void destroy_groups (void);
-int get_user_permissions (struct stat *buf);
+int get_user_permissions (const file_stat_t * st);
 
 void init_uid_gid_cache (void);
 const char *get_group (gid_t gid);
@@ -258,6 +278,9 @@ void mc_replace_error (GError ** dest, int code, const char *format, ...) G_GNUC
 
 gboolean mc_time_elapsed (guint64 * timestamp, guint64 delay);
 
+void file_stat_from_stat (file_stat_t * fst, const struct stat *st);
+void file_stat_to_stat (const file_stat_t * fst, struct stat *st);
+
 /*** inline functions **************************************************/
 
 static inline gboolean
@@ -1250,7 +1250,7 @@ mc_realpath (const char *path, char *resolved_path)
  */
 
 int
-get_user_permissions (struct stat *st)
+get_user_permissions (const file_stat_t * st)
 {
     static gboolean initialized = FALSE;
     static gid_t *groups;
@@ -1284,11 +1284,11 @@ get_user_permissions (struct stat *st)
         initialized = TRUE;
     }
 
-    if (st->st_uid == uid || uid == 0)
+    if (st->uid == uid || uid == 0)
         return 0;
 
     for (i = 0; i < ngroups; i++)
-        if (st->st_gid == groups[i])
+        if (st->gid == groups[i])
             return 1;
 
     return 2;
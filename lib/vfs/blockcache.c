@@ -0,0 +1,316 @@
+/*
+   Virtual File System: cache of blocks of remote file
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: cache of blocks of remote file
+ *
+ * Network filesystems which are able to read a range of file use this cache to serve
+ * random access reads (e.g. of viewer) without downloading of whole file. Blocks are fetched
+ * on demand, the least recently used blocks are dropped. If blocks are read sequentially,
+ * the number of blocks fetched at once grows to save round trips.
+ *
+ * File size given by stat is a hint only: the file can grow or shrink since it was listed,
+ * so reading goes on until a short block is returned.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "lib/global.h"
+
+#include "blockcache.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define BLOCK_KEY(index) GSIZE_TO_POINTER ((gsize) (index))
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    off_t index;
+    size_t len;
+    GList link;                 /* link in LRU queue, link.data points to block itself */
+    char *data;
+} vfs_block_t;
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_block_free (gpointer data)
+{
+    vfs_block_t *block = (vfs_block_t *) data;
+
+    g_free (block->data);
+    g_free (block);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline vfs_block_t *
+vfs_block_cache_lookup (const vfs_block_cache_t * cache, off_t index)
+{
+    return (vfs_block_t *) g_hash_table_lookup (cache->blocks, BLOCK_KEY (index));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_block_cache_insert (vfs_block_cache_t * cache, off_t index, const char *data, size_t len)
+{
+    vfs_block_t *block;
+
+    block = g_new0 (vfs_block_t, 1);
+    block->index = index;
+    block->len = len;
+    block->link.data = block;
+    block->data = g_memdup (data, len);
+
+    g_hash_table_insert (cache->blocks, BLOCK_KEY (index), block);
+    g_queue_push_head_link (&cache->lru, &block->link);
+
+    while (g_hash_table_size (cache->blocks) > cache->max_blocks)
+    {
+        GList *lru;
+
+        lru = g_queue_pop_tail_link (&cache->lru);
+        g_hash_table_remove (cache->blocks, BLOCK_KEY (((vfs_block_t *) lru->data)->index));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fetch block and, if file is read sequentially, several following blocks.
+ *
+ * @return requested block, NULL on error
+ */
+
+static vfs_block_t *
+vfs_block_cache_fetch (vfs_block_cache_t * cache, off_t index)
+{
+    off_t last;
+    guint count, i;
+    char *buf;
+    ssize_t got;
+
+    if (index == cache->next)
+        cache->readahead = MIN (cache->readahead * 2, MAX (cache->max_blocks / 4, 1));
+    else
+        cache->readahead = 1;
+
+    /* don't fetch blocks which are in the cache already or are beyond end of file */
+    last = (cache->size - 1) / (off_t) cache->block_size;
+    for (count = 1; count < cache->readahead && index + (off_t) count <= last
+         && vfs_block_cache_lookup (cache, index + (off_t) count) == NULL; count++)
+        ;
+
+    buf = g_malloc (count * cache->block_size);
+    got = cache->fetch (cache->data, index * (off_t) cache->block_size, buf,
+                        count * cache->block_size);
+    if (got < 0)
+    {
+        g_free (buf);
+        cache->next = -1;
+        return NULL;
+    }
+
+    if ((size_t) got < count * cache->block_size)
+    {
+        off_t end = index * (off_t) cache->block_size + (off_t) got;
+
+        /* end of file is reached: nothing is known if the read is beyond it */
+        if (got != 0 || end <= cache->size)
+        {
+            cache->size = end;
+            cache->size_known = TRUE;
+        }
+
+        count = MAX ((guint) ((size_t) got / cache->block_size), 1);
+        if ((size_t) got > count * cache->block_size)
+            count++;
+    }
+    else if (index * (off_t) cache->block_size + got > cache->size)
+        cache->size = index * (off_t) cache->block_size + got;  /* file was grown */
+
+    /* insert requested block last to keep it at the head of LRU queue */
+    for (i = count; i-- != 0;)
+    {
+        size_t start = i * cache->block_size;
+        size_t len;
+
+        len = (size_t) got > start ? MIN ((size_t) got - start, cache->block_size) : 0;
+        vfs_block_cache_insert (cache, index + (off_t) i, buf + start, len);
+    }
+
+    g_free (buf);
+    cache->next = index + (off_t) count;
+
+    return vfs_block_cache_lookup (cache, index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create cache of blocks of file.
+ *
+ * @param size       file size
+ * @param block_size size of block
+ * @param max_blocks max number of blocks kept in memory
+ * @param fetch      function to read range of file
+ * @param data       data passed to fetch function
+ *
+ * @return new cache
+ */
+
+vfs_block_cache_t *
+vfs_block_cache_new (off_t size, size_t block_size, guint max_blocks, vfs_block_fetch_fn fetch,
+                     void *data)
+{
+    vfs_block_cache_t *cache;
+
+    cache = g_new0 (vfs_block_cache_t, 1);
+    cache->size = size;
+    cache->block_size = block_size;
+    cache->max_blocks = MAX (max_blocks, 1);
+    cache->fetch = fetch;
+    cache->data = data;
+    cache->blocks = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, vfs_block_free);
+    g_queue_init (&cache->lru);
+    cache->next = -1;
+    cache->readahead = 1;
+
+    return cache;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_block_cache_free (vfs_block_cache_t * cache)
+{
+    if (cache != NULL)
+    {
+        g_hash_table_destroy (cache->blocks);
+        g_free (cache);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read data from file through the cache.
+ *
+ * @param cache  cache
+ * @param offset position in file
+ * @param buf    buffer for data
+ * @param count  size of buffer
+ *
+ * @return number of read bytes, 0 at end of file, -1 on error
+ */
+
+ssize_t
+vfs_block_cache_read (vfs_block_cache_t * cache, off_t offset, char *buf, size_t count)
+{
+    size_t done = 0;
+
+    while (done < count && (offset < cache->size || !cache->size_known))
+    {
+        vfs_block_t *block;
+        off_t index;
+        size_t skip, n;
+
+        index = offset / (off_t) cache->block_size;
+        skip = (size_t) (offset % (off_t) cache->block_size);
+
+        block = vfs_block_cache_lookup (cache, index);
+        if (block == NULL)
+        {
+            block = vfs_block_cache_fetch (cache, index);
+            if (block == NULL)
+                return done != 0 ? (ssize_t) done : -1;
+        }
+        else
+        {
+            g_queue_unlink (&cache->lru, &block->link);
+            g_queue_push_head_link (&cache->lru, &block->link);
+        }
+
+        if (skip >= block->len)
+            break;
+
+        n = MIN (count - done, block->len - skip);
+        memcpy (buf + done, block->data + skip, n);
+        done += n;
+        offset += (off_t) n;
+    }
+
+    return (ssize_t) done;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get actual size of file. Size given by stat is checked by reading from the last block
+ * of file until end of file is reached.
+ *
+ * @param cache  cache
+ *
+ * @return size of file, -1 on error
+ */
+
+off_t
+vfs_block_cache_get_size (vfs_block_cache_t * cache)
+{
+    while (!cache->size_known)
+    {
+        vfs_block_t *block;
+        off_t index;
+
+        index = cache->size / (off_t) cache->block_size;
+
+        block = vfs_block_cache_lookup (cache, index);
+        if (block == NULL)
+        {
+            block = vfs_block_cache_fetch (cache, index);
+            if (block == NULL)
+                return (-1);
+        }
+
+        if (block->len < cache->block_size)
+        {
+            cache->size = index * (off_t) cache->block_size + (off_t) block->len;
+            cache->size_known = TRUE;
+        }
+        else
+            cache->size = MAX (cache->size, (index + 1) * (off_t) cache->block_size);
+    }
+
+    return cache->size;
+}
+
+/* --------------------------------------------------------------------------------------------- */
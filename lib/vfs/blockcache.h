@@ -0,0 +1,57 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: cache of blocks of remote file
+ */
+
+#ifndef MC__VFS_BLOCKCACHE_H
+#define MC__VFS_BLOCKCACHE_H
+
+#include <sys/types.h>
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+#define VFS_BLOCK_CACHE_BLOCK_SIZE (64 * 1024)
+#define VFS_BLOCK_CACHE_MAX_BLOCKS 128
+
+/**
+ * Read range of file. Less than len bytes should be returned at end of file only.
+ *
+ * @return number of read bytes, -1 on error
+ */
+typedef ssize_t (*vfs_block_fetch_fn) (void *data, off_t offset, void *buf, size_t len);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct
+{
+    size_t block_size;
+    guint max_blocks;
+    off_t size;                 /* file size, it is adjusted when end of file is reached */
+    gboolean size_known;        /* end of file was reached, size is not taken from stat */
+
+    vfs_block_fetch_fn fetch;
+    void *data;
+
+    GHashTable *blocks;         /* block number -> block */
+    GQueue lru;                 /* recently used blocks go first */
+    off_t next;                 /* number of block following the last fetched range */
+    guint readahead;            /* number of blocks to fetch at once */
+} vfs_block_cache_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+vfs_block_cache_t *vfs_block_cache_new (off_t size, size_t block_size, guint max_blocks,
+                                        vfs_block_fetch_fn fetch, void *data);
+void vfs_block_cache_free (vfs_block_cache_t * cache);
+ssize_t vfs_block_cache_read (vfs_block_cache_t * cache, off_t offset, char *buf, size_t count);
+off_t vfs_block_cache_get_size (vfs_block_cache_t * cache);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_BLOCKCACHE_H */
@@ -0,0 +1,524 @@
+/*
+   Virtual File System: persistent cache of directory listings
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: persistent cache of directory listings
+ *
+ * Listings of directories loaded from remote servers are saved to the mc cache directory,
+ * one subdirectory per connection and one file per directory, named by checksums of URLs.
+ * When directory is visited first time in mc session, the saved listing is used instead
+ * of request to the server if it is not older than vfs_dircache_max_age and modification
+ * time of directory, if it is known from listing of its parent, is the same as when
+ * the listing was saved.
+ *
+ * The listing taken from the cache is kept in memory until it is vfs_dircache_max_age
+ * seconds old. Then, on next visits in the same session, or when user rereads the panel,
+ * it is loaded from the server. Any change made through the connection drops all listings
+ * saved for it. Files older than vfs_dircache_max_age are removed once per session.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>           /* uintmax_t */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "lib/global.h"
+#include "lib/fileloc.h"
+#include "lib/mcconfig.h"       /* mc_config_get_cache_path() */
+
+#include "vfs.h"
+#include "path.h"
+#include "xdirentry.h"
+
+#include "dircache.h"
+
+/*** global variables ****************************************************************************/
+
+/* max age of saved listing in seconds, 0 disables the cache */
+int vfs_dircache_max_age = 0;
+
+/*** file scope macro definitions ****************************************************************/
+
+#define DIRCACHE_MAGIC "MC VFS directory cache 2"
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* keys of directories which were visited in this session */
+static GHashTable *dircache_visited = NULL;
+
+static gboolean dircache_pruned = FALSE;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+vfs_s_dircache_enabled (const struct vfs_class *me)
+{
+    return vfs_dircache_max_age > 0 && (me->flags & VFS_REMOTE) != 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_dircache_super_key (const struct vfs_class *me, const struct vfs_s_super *super)
+{
+    char *params, *key;
+
+    params = vfs_path_build_url_params_str (super->path_element, FALSE);
+    key = g_strdup_printf ("%s://%s", me->name, params);
+    g_free (params);
+
+    return key;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_dircache_key (const struct vfs_class *me, const struct vfs_s_inode *dir, const char *path)
+{
+    char *super_key, *key;
+
+    super_key = vfs_s_dircache_super_key (me, dir->super);
+    key = g_strconcat (super_key, "/", path, (char *) NULL);
+    g_free (super_key);
+
+    return key;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get name of directory where listings of the connection are saved.
+ */
+
+static char *
+vfs_s_dircache_super_dirname (const struct vfs_class *me, const struct vfs_s_super *super)
+{
+    char *key, *checksum, *dirname;
+
+    key = vfs_s_dircache_super_key (me, super);
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+    dirname =
+        g_build_filename (mc_config_get_cache_path (), MC_VFS_DIRCACHE_DIR, checksum,
+                          (char *) NULL);
+    g_free (checksum);
+    g_free (key);
+
+    return dirname;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_s_dircache_filename (const struct vfs_class *me, const struct vfs_s_inode *dir,
+                         const char *key)
+{
+    char *dirname, *checksum, *filename;
+
+    dirname = vfs_s_dircache_super_dirname (me, dir->super);
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+    filename = g_build_filename (dirname, checksum, (char *) NULL);
+    g_free (checksum);
+    g_free (dirname);
+
+    return filename;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove files in directory. If max_age is not negative, only files older than max_age
+ * seconds are removed, directories are processed recursively.
+ */
+
+static void
+vfs_s_dircache_clean_dir (const char *dirname, time_t now, int max_age)
+{
+    GDir *d;
+    const char *name;
+
+    d = g_dir_open (dirname, 0, NULL);
+    if (d == NULL)
+        return;
+
+    while ((name = g_dir_read_name (d)) != NULL)
+    {
+        char *filename;
+        struct stat st;
+
+        filename = g_build_filename (dirname, name, (char *) NULL);
+
+        if (lstat (filename, &st) == 0)
+        {
+            if (S_ISDIR (st.st_mode))
+            {
+                if (max_age >= 0)
+                {
+                    vfs_s_dircache_clean_dir (filename, now, max_age);
+                    /* fails if directory isn't empty */
+                    (void) rmdir (filename);
+                }
+            }
+            else if (max_age < 0 || now - st.st_mtime > max_age)
+                (void) unlink (filename);
+        }
+
+        g_free (filename);
+    }
+
+    g_dir_close (d);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember that directory is visited in this session.
+ *
+ * @return TRUE if directory was visited already
+ */
+
+static gboolean
+vfs_s_dircache_visit (const char *key)
+{
+    char *k;
+
+    if (dircache_visited == NULL)
+        dircache_visited = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    else if (g_hash_table_lookup (dircache_visited, key) != NULL)
+        return TRUE;
+
+    k = g_strdup (key);
+    g_hash_table_insert (dircache_visited, k, k);
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_s_dircache_prune (void)
+{
+    char *dirname;
+
+    if (dircache_pruned)
+        return;
+
+    dircache_pruned = TRUE;
+
+    dirname = g_build_filename (mc_config_get_cache_path (), MC_VFS_DIRCACHE_DIR, (char *) NULL);
+    vfs_s_dircache_clean_dir (dirname, time (NULL), vfs_dircache_max_age);
+    g_free (dirname);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get modification time of directory from listing of its parent directory if it is in memory.
+ *
+ * @return modification time, -1 if it is unknown
+ */
+
+static time_t
+vfs_s_dircache_dir_mtime (const struct vfs_s_inode *dir, const char *path)
+{
+    char *parent, *name;
+    GList *iter;
+    time_t mtime = (time_t) (-1);
+
+    if (*path == '\0')
+        return mtime;
+
+    parent = g_path_get_dirname (path);
+    name = g_path_get_basename (path);
+
+    iter = g_list_find_custom (dir->super->root->subdir,
+                               strcmp (parent, ".") == 0 ? "" : parent,
+                               (GCompareFunc) vfs_s_entry_compare);
+    if (iter != NULL)
+    {
+        iter = g_list_find_custom (VFS_ENTRY (iter->data)->ino->subdir, name,
+                                   (GCompareFunc) vfs_s_entry_compare);
+        if (iter != NULL)
+            mtime = VFS_ENTRY (iter->data)->ino->st.st_mtime;
+    }
+
+    g_free (parent);
+    g_free (name);
+
+    return mtime;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Parse entry saved by vfs_s_dircache_save() and insert it into directory.
+ *
+ * @return FALSE if line is malformed
+ */
+
+static gboolean
+vfs_s_dircache_parse_entry (struct vfs_class *me, struct vfs_s_inode *dir, char *line)
+{
+    struct stat st;
+    char **fields;
+    char *p;
+    struct vfs_s_inode *ino;
+    struct vfs_s_entry *ent;
+
+    fields = g_strsplit (line, "\t", 3);
+    if (fields[0] == NULL || fields[1] == NULL || *fields[1] == '\0')
+    {
+        g_strfreev (fields);
+        return FALSE;
+    }
+
+    st = *vfs_s_default_stat (me, 0);
+
+    p = fields[0];
+    st.st_mode = (mode_t) g_ascii_strtoull (p, &p, 10);
+    st.st_uid = (uid_t) g_ascii_strtoull (p, &p, 10);
+    st.st_gid = (gid_t) g_ascii_strtoull (p, &p, 10);
+    st.st_size = (off_t) g_ascii_strtoll (p, &p, 10);
+    st.st_mtime = (time_t) g_ascii_strtoll (p, &p, 10);
+    st.st_atime = (time_t) g_ascii_strtoll (p, &p, 10);
+    st.st_ctime = (time_t) g_ascii_strtoll (p, &p, 10);
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    st.st_rdev = (dev_t) g_ascii_strtoull (p, &p, 10);
+#else
+    (void) g_ascii_strtoull (p, &p, 10);
+#endif
+    if (*p != '\0')
+    {
+        g_strfreev (fields);
+        return FALSE;
+    }
+    vfs_adjust_stat (&st);
+
+    ino = vfs_s_new_inode (me, dir->super, &st);
+    if (fields[2] != NULL)
+        ino->linkname = g_strcompress (fields[2]);
+
+    p = g_strcompress (fields[1]);
+    ent = vfs_s_new_entry (me, p, ino);
+    g_free (p);
+    vfs_s_insert_entry (me, dir, ent);
+
+    g_strfreev (fields);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load listing of directory from the cache.
+ *
+ * @param me   class of filesystem
+ * @param dir  new empty directory inode
+ * @param path path of directory
+ *
+ * @return TRUE if directory is filled, FALSE if directory should be loaded from server
+ */
+
+gboolean
+vfs_s_dircache_load (struct vfs_class *me, struct vfs_s_inode *dir, const char *path)
+{
+    char *key, *escaped_key, *filename;
+    char *contents = NULL;
+    char **lines;
+    time_t saved = 0;
+    gboolean ok;
+    int i;
+
+    if (!vfs_s_dircache_enabled (me))
+        return FALSE;
+
+    vfs_s_dircache_prune ();
+
+    key = vfs_s_dircache_key (me, dir, path);
+
+    /* the cache is used for the first visit in session only */
+    if (vfs_s_dircache_visit (key))
+    {
+        g_free (key);
+        return FALSE;
+    }
+
+    filename = vfs_s_dircache_filename (me, dir, key);
+    ok = g_file_get_contents (filename, &contents, NULL, NULL);
+    g_free (filename);
+    if (!ok)
+    {
+        g_free (key);
+        return FALSE;
+    }
+
+    lines = g_strsplit (contents, "\n", -1);
+    g_free (contents);
+
+    escaped_key = g_strescape (key, NULL);
+    g_free (key);
+
+    ok = lines[0] != NULL && strcmp (lines[0], DIRCACHE_MAGIC) == 0
+        && lines[1] != NULL && strcmp (lines[1], escaped_key) == 0 && lines[2] != NULL;
+    g_free (escaped_key);
+
+    if (ok)
+    {
+        char *p = lines[2];
+        time_t saved_mtime, mtime, age;
+
+        saved_mtime = (time_t) g_ascii_strtoll (p, &p, 10);
+        saved = (time_t) g_ascii_strtoll (p, &p, 10);
+        mtime = vfs_s_dircache_dir_mtime (dir, path);
+        age = time (NULL) - saved;
+
+        /* mtime of directory doesn't change when files are rewritten, so age is always checked */
+        ok = age >= 0 && age <= vfs_dircache_max_age
+            && (mtime == (time_t) (-1) || mtime == saved_mtime);
+    }
+
+    for (i = 3; ok && lines[i] != NULL; i++)
+        if (*lines[i] != '\0')
+            ok = vfs_s_dircache_parse_entry (me, dir, lines[i]);
+
+    g_strfreev (lines);
+
+    if (!ok)
+    {
+        while (dir->subdir != NULL)
+            vfs_s_free_entry (me, VFS_ENTRY (dir->subdir->data));
+        return FALSE;
+    }
+
+    dir->timestamp.tv_sec = saved + vfs_dircache_max_age;
+    dir->timestamp.tv_usec = 0;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save listing of directory loaded from server to the cache.
+ *
+ * @param me   class of filesystem
+ * @param dir  directory inode
+ * @param path path of directory
+ */
+
+void
+vfs_s_dircache_save (struct vfs_class *me, struct vfs_s_inode *dir, const char *path)
+{
+    char *key, *escaped, *filename, *dirname;
+    GString *buf;
+    GList *iter;
+
+    if (!vfs_s_dircache_enabled (me))
+        return;
+
+    key = vfs_s_dircache_key (me, dir, path);
+    (void) vfs_s_dircache_visit (key);
+    escaped = g_strescape (key, NULL);
+
+    buf = g_string_sized_new (64 * (g_list_length (dir->subdir) + 1));
+    g_string_append_printf (buf, "%s\n%s\n%" PRIdMAX " %" PRIdMAX "\n", DIRCACHE_MAGIC, escaped,
+                            (intmax_t) vfs_s_dircache_dir_mtime (dir, path),
+                            (intmax_t) time (NULL));
+    g_free (escaped);
+
+    for (iter = dir->subdir; iter != NULL; iter = g_list_next (iter))
+    {
+        const struct vfs_s_entry *ent = VFS_ENTRY (iter->data);
+        const struct stat *st = &ent->ino->st;
+        uintmax_t rdev = 0;
+
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+        rdev = (uintmax_t) st->st_rdev;
+#endif
+        escaped = g_strescape (ent->name, NULL);
+        g_string_append_printf (buf, "%u %u %u %" PRIdMAX " %" PRIdMAX " %" PRIdMAX " %" PRIdMAX
+                                " %" PRIuMAX "\t%s", (unsigned int) st->st_mode,
+                                (unsigned int) st->st_uid, (unsigned int) st->st_gid,
+                                (intmax_t) st->st_size, (intmax_t) st->st_mtime,
+                                (intmax_t) st->st_atime, (intmax_t) st->st_ctime, rdev, escaped);
+        g_free (escaped);
+
+        if (ent->ino->linkname != NULL)
+        {
+            escaped = g_strescape (ent->ino->linkname, NULL);
+            g_string_append_printf (buf, "\t%s", escaped);
+            g_free (escaped);
+        }
+
+        g_string_append_c (buf, '\n');
+    }
+
+    dirname = vfs_s_dircache_super_dirname (me, dir->super);
+    filename = vfs_s_dircache_filename (me, dir, key);
+
+    if (g_mkdir_with_parents (dirname, 0700) == 0)
+        (void) g_file_set_contents (filename, buf->str, buf->len, NULL);
+
+    g_free (filename);
+    g_free (dirname);
+    g_string_free (buf, TRUE);
+    g_free (key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop all listings saved for the connection. Called when anything is changed on the server
+ * through the connection: saved listings can't be trusted anymore.
+ *
+ * @param me    class of filesystem
+ * @param super superblock of connection
+ */
+
+void
+vfs_s_dircache_forget (struct vfs_class *me, struct vfs_s_super *super)
+{
+    char *dirname;
+
+    if (!vfs_s_dircache_enabled (me) || super->path_element == NULL)
+        return;
+
+    dirname = vfs_s_dircache_super_dirname (me, super);
+    vfs_s_dircache_clean_dir (dirname, 0, -1);
+    g_free (dirname);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_s_dircache_done (void)
+{
+    if (dircache_visited != NULL)
+    {
+        g_hash_table_destroy (dircache_visited);
+        dircache_visited = NULL;
+    }
+    dircache_pruned = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
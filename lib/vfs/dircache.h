@@ -0,0 +1,30 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: persistent cache of directory listings
+ */
+
+#ifndef MC__VFS_DIRCACHE_H
+#define MC__VFS_DIRCACHE_H
+
+#include "xdirentry.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+extern int vfs_dircache_max_age;
+
+/*** declarations of public functions ************************************************************/
+
+gboolean vfs_s_dircache_load (struct vfs_class *me, struct vfs_s_inode *dir, const char *path);
+void vfs_s_dircache_save (struct vfs_class *me, struct vfs_s_inode *dir, const char *path);
+void vfs_s_dircache_forget (struct vfs_class *me, struct vfs_s_super *super);
+void vfs_s_dircache_done (void);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_DIRCACHE_H */
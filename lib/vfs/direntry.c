@@ -75,6 +75,9 @@
 #include "utilvfs.h"
 #include "xdirentry.h"
 #include "gc.h"                 /* vfs_rmstamp */
+#ifdef ENABLE_VFS_NET
+#include "dircache.h"
+#endif
 
 /*** global variables ****************************************************************************/
 
@@ -228,6 +231,34 @@ vfs_s_find_entry_tree (struct vfs_class *me, struct vfs_s_inode *root,
     return NULL;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fill directory inode.
+ *
+ * @param reload TRUE if listing in memory was expired
+ * @return TRUE on success, FALSE otherwise
+ */
+
+static gboolean
+vfs_s_load_dir (struct vfs_class *me, struct vfs_s_inode *ino, char *path, gboolean reload)
+{
+#ifdef ENABLE_VFS_NET
+    /* directory which was not visited yet can be taken from the disk cache */
+    if (!reload && vfs_s_dircache_load (me, ino, path))
+        return TRUE;
+#else
+    (void) reload;
+#endif
+
+    if (VFS_SUBCLASS (me)->dir_load (me, ino, path) == -1)
+        return FALSE;
+
+#ifdef ENABLE_VFS_NET
+    vfs_s_dircache_save (me, ino, path);
+#endif
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static struct vfs_s_entry *
@@ -237,6 +268,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
     struct vfs_s_entry *ent = NULL;
     char *const path = g_strdup (a_path);
     GList *iter;
+    gboolean reload = FALSE;
 
     if (root->super->root != root)
         vfs_die ("We have to use _real_ root. Always. Sorry.");
@@ -269,6 +301,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 #endif
         vfs_s_free_entry (me, ent);
         ent = NULL;
+        reload = TRUE;
     }
 
     if (ent == NULL)
@@ -277,7 +310,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 
         ino = vfs_s_new_inode (me, root->super, vfs_s_default_stat (me, S_IFDIR | 0755));
         ent = vfs_s_new_entry (me, path, ino);
-        if (VFS_SUBCLASS (me)->dir_load (me, ino, path) == -1)
+        if (!vfs_s_load_dir (me, ino, path, reload))
         {
             vfs_s_free_entry (me, ent);
             g_free (path);
@@ -374,6 +407,8 @@ vfs_s_new_fh (struct vfs_s_inode *ino, gboolean changed)
 static void
 vfs_s_free_fh (struct vfs_s_subclass *s, vfs_file_handler_t * fh)
 {
+    vfs_block_cache_free (fh->cache);
+
     if (s->fh_free != NULL)
         s->fh_free (fh);
 
@@ -555,6 +590,16 @@ vfs_s_read (void *fh, char *buffer, size_t count)
     vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
     struct vfs_class *me = VFS_FILE_HANDLER_SUPER (fh)->me;
 
+    if (file->cache != NULL)
+    {
+        ssize_t n;
+
+        n = vfs_block_cache_read (file->cache, file->pos, buffer, count);
+        if (n > 0)
+            file->pos += n;
+        return n;
+    }
+
     if (file->linear == LS_LINEAR_PREOPEN)
     {
         if (VFS_SUBCLASS (me)->linear_start (me, file, file->pos) == 0)
@@ -582,6 +627,17 @@ vfs_s_read (void *fh, char *buffer, size_t count)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static ssize_t
+vfs_s_read_range (void *data, off_t offset, void *buf, size_t len)
+{
+    vfs_file_handler_t *fh = VFS_FILE_HANDLER (data);
+    struct vfs_class *me = VFS_FILE_HANDLER_SUPER (fh)->me;
+
+    return VFS_SUBCLASS (me)->read_range (me, fh, offset, buf, len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static ssize_t
 vfs_s_write (void *fh, const char *buffer, size_t count)
 {
@@ -591,6 +647,12 @@ vfs_s_write (void *fh, const char *buffer, size_t count)
     if (file->linear != LS_NOT_LINEAR)
         vfs_die ("no writing to linear files, please");
 
+    if (file->cache != NULL)
+    {
+        me->verrno = EBADF;
+        return (-1);
+    }
+
     file->changed = TRUE;
     if (file->handle != -1)
     {
@@ -626,6 +688,14 @@ vfs_s_lseek (void *fh, off_t offset, int whence)
         return retval;
     }
 
+    /* size from directory listing can be out of date */
+    if (file->cache != NULL)
+    {
+        size = vfs_block_cache_get_size (file->cache);
+        if (size == -1)
+            return (-1);
+    }
+
     switch (whence)
     {
     case SEEK_CUR:
@@ -757,11 +827,17 @@ vfs_s_getlocalcopy (const vfs_path_t * vpath)
 
     if (fh != NULL)
     {
-        const struct vfs_class *me;
+        struct vfs_class *me;
 
         me = vfs_path_get_by_index (vpath, -1)->class;
         if ((me->flags & VFS_USETMP) != 0 && fh->ino != NULL)
-            local = vfs_path_from_str_flags (fh->ino->localname, VPF_NO_CANON);
+        {
+            /* file opened for range reads has no local copy yet */
+            if (fh->cache != NULL && fh->ino->localname == NULL)
+                vfs_s_retrieve_file (me, fh->ino);
+            if (fh->ino->localname != NULL)
+                local = vfs_path_from_str_flags (fh->ino->localname, VPF_NO_CANON);
+        }
 
         vfs_s_close (fh);
     }
@@ -817,6 +893,17 @@ vfs_s_setctl (const vfs_path_t * vpath, int ctlop, void *arg)
     case VFS_SETCTL_FLUSH:
         path_element->class->flush = TRUE;
         return 1;
+    case VFS_SETCTL_BATCH:
+        {
+            struct vfs_s_super *super;
+
+            if (VFS_SUBCLASS (path_element->class)->batch == NULL
+                || vfs_s_get_path (vpath, &super, arg != NULL ? 0 : FL_NO_OPEN) == NULL)
+                return 0;
+
+            return VFS_SUBCLASS (path_element->class)->batch (path_element->class, super,
+                                                               arg != NULL);
+        }
     default:
         return 0;
     }
@@ -1219,6 +1306,11 @@ vfs_s_get_path (const vfs_path_t * vpath, struct vfs_s_super **archive, int flag
 void
 vfs_s_invalidate (struct vfs_class *me, struct vfs_s_super *super)
 {
+#ifdef ENABLE_VFS_NET
+    /* saved listings are out of date too */
+    vfs_s_dircache_forget (me, super);
+#endif
+
     if (!super->want_stale)
     {
         vfs_s_free_inode (me, super->root);
@@ -1272,6 +1364,7 @@ vfs_s_init_fh (vfs_file_handler_t * fh, struct vfs_s_inode *ino, gboolean change
     fh->handle = -1;
     fh->changed = changed;
     fh->linear = LS_NOT_LINEAR;
+    fh->cache = NULL;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1364,6 +1457,13 @@ vfs_s_open (const vfs_path_t * vpath, int flags, mode_t mode)
             fh->linear = LS_LINEAR_PREOPEN;
         }
     }
+    else if (s->read_range != NULL && (flags & O_ACCMODE) == O_RDONLY && ino->localname == NULL)
+    {
+        /* fetch only those parts of file which are read */
+        fh->cache =
+            vfs_block_cache_new (ino->st.st_size, VFS_BLOCK_CACHE_BLOCK_SIZE,
+                                 VFS_BLOCK_CACHE_MAX_BLOCKS, vfs_s_read_range, fh);
+    }
     else
     {
         if (s->fh_open != NULL && s->fh_open (path_element->class, fh, flags, mode) != 0)
@@ -1412,7 +1512,20 @@ vfs_s_lstat (const vfs_path_t * vpath, struct stat *buf)
 int
 vfs_s_fstat (void *fh, struct stat *buf)
 {
-    *buf = VFS_FILE_HANDLER (fh)->ino->st;
+    vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
+
+    *buf = file->ino->st;
+
+    /* file can be changed since directory was listed */
+    if (file->cache != NULL)
+    {
+        off_t size;
+
+        size = vfs_block_cache_get_size (file->cache);
+        if (size != -1)
+            buf->st_size = size;
+    }
+
     return 0;
 }
 
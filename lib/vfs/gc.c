@@ -105,6 +105,8 @@ struct vfs_stamping
 /*** file scope variables ************************************************************************/
 
 static GSList *stamps = NULL;
+/* No stamp is older than this time (in seconds), so nothing expires before it plus vfs_timeout */
+static time_t stamps_oldest = 0;
 
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
@@ -144,6 +146,10 @@ vfs_addstamp (struct vfs_class *v, vfsid id)
         stamp->id = id;
         gettimeofday (&(stamp->time), NULL);
 
+        /* existing stamps are not newer than the current time */
+        if (stamps == NULL)
+            stamps_oldest = stamp->time.tv_sec;
+
         stamps = g_slist_append (stamps, stamp);
     }
 }
@@ -299,28 +305,69 @@ vfs_expire (gboolean now)
     /* then remove NULLized stamps */
     stamps = g_slist_remove_all (stamps, NULL);
 
+    /* find time of the next expiration */
+    for (stamp = stamps; stamp != NULL; stamp = g_slist_next (stamp))
+    {
+        const struct vfs_stamping *stamping = VFS_STAMPING (stamp->data);
+
+        if (stamp == stamps || stamping->time.tv_sec < stamps_oldest)
+            stamps_oldest = stamping->time.tv_sec;
+    }
+
     locked = FALSE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 /*
- * Return the number of seconds remaining to the vfs timeout.
- * FIXME: The code should be improved to actually return the number of
- * seconds until the next item times out.
+ * Return the number of seconds remaining to the timeout of the next stamp,
+ * or 0 if there are no stamps that can expire.
+ * Stamps of filesystems with open files are skipped: they can't be freed, so
+ * waking up for them is useless. Closing of the last file renews the stamp.
  */
 
 int
 vfs_timeouts (void)
 {
-    return stamps != NULL ? 10 : 0;
+    struct timeval curr_time;
+    const struct timeval *next = NULL;
+    GSList *stamp;
+    time_t left;
+
+    for (stamp = stamps; stamp != NULL; stamp = g_slist_next (stamp))
+    {
+        const struct vfs_stamping *stamping = VFS_STAMPING (stamp->data);
+
+        if ((stamping->v->nothingisopen == NULL || stamping->v->nothingisopen (stamping->id))
+            && (next == NULL || timeoutcmp (&stamping->time, next)))
+            next = &stamping->time;
+    }
+
+    if (next == NULL)
+        return 0;
+
+    gettimeofday (&curr_time, NULL);
+    left = next->tv_sec + vfs_timeout - curr_time.tv_sec;
+    /* round up: stamp doesn't expire before the end of its second */
+    if (next->tv_usec > curr_time.tv_usec)
+        left++;
+
+    return left > 0 ? (int) left : 1;
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/* Free expired filesystems. Cheap if nothing is expired yet, so it can be called often */
 
 void
 vfs_timeout_handler (void)
 {
-    vfs_expire (FALSE);
+    struct timeval curr_time;
+
+    if (stamps == NULL)
+        return;
+
+    gettimeofday (&curr_time, NULL);
+    if (curr_time.tv_sec >= stamps_oldest + vfs_timeout)
+        vfs_expire (FALSE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,314 @@
+/*
+   Routines for parsing machine-readable directory listings (RFC 3659).
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: parsing of MLSD/MLST output
+ *
+ * Each entry of MLSD listing is a line of facts followed by the file name:
+ *
+ *     type=file;size=1024;modify=20190102030405;UNIX.mode=0644; name
+ *
+ * Unlike output of 'ls', the format does not depend on locale and operating system
+ * of the server, sizes and times (in UTC) are exact.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/global.h"
+
+#include "vfs.h"                /* vfs_adjust_stat() */
+#include "utilvfs.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define FACT_IS(fact, len, name) \
+    ((len) == sizeof (name) - 1 && g_ascii_strncasecmp ((fact), (name), (len)) == 0)
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+vfs_parse_mlsd_number (const char *s, size_t len, int base, guint64 * value)
+{
+    size_t i;
+
+    if (len == 0)
+        return FALSE;
+
+    *value = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        int digit;
+
+        digit = g_ascii_xdigit_value (s[i]);
+        if (digit < 0 || digit >= base)
+            return FALSE;
+        *value = *value * (guint64) base + (guint64) digit;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Parse time value "YYYYMMDDHHMMSS[.sss]" (UTC).
+ */
+
+static gboolean
+vfs_parse_mlsd_time (const char *s, size_t len, time_t * t)
+{
+    guint64 v[6];
+    static const size_t width[6] = { 4, 2, 2, 2, 2, 2 };
+    gint64 y, m, era, yoe, doy, doe, days;
+    size_t i;
+
+    if (len < 14 || (len > 14 && s[14] != '.'))
+        return FALSE;
+
+    for (i = 0; i < 6; s += width[i], i++)
+        if (!vfs_parse_mlsd_number (s, width[i], 10, &v[i]))
+            return FALSE;
+
+    if (v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > 31 || v[3] > 23 || v[4] > 59 || v[5] > 60)
+        return FALSE;
+
+    /* days since 1970-01-01 in proleptic Gregorian calendar, no timegm() is needed */
+    y = (gint64) v[0] - (v[1] <= 2 ? 1 : 0);
+    m = (gint64) v[1];
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + (gint64) v[2] - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+
+    *t = (time_t) (days * 86400 + (gint64) (v[3] * 3600 + v[4] * 60 + v[5]));
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get permission bits from "perm" fact if there is no "UNIX.mode" one.
+ */
+
+static mode_t
+vfs_parse_mlsd_perm (const char *s, size_t len, gboolean is_dir)
+{
+    mode_t mode = 0;
+
+    if (is_dir)
+    {
+        if (memchr (s, 'l', len) != NULL || memchr (s, 'e', len) != NULL)
+            mode |= S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+        if (memchr (s, 'c', len) != NULL || memchr (s, 'm', len) != NULL)
+            mode |= S_IWUSR;
+    }
+    else
+    {
+        if (memchr (s, 'r', len) != NULL)
+            mode |= S_IRUSR | S_IRGRP | S_IROTH;
+        if (memchr (s, 'w', len) != NULL || memchr (s, 'a', len) != NULL)
+            mode |= S_IWUSR;
+    }
+
+    return mode;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Parse line of MLSD listing.
+ *
+ * @param p        line of listing
+ * @param s        stat structure to fill
+ * @param filename pointer to store allocated name of file
+ * @param linkname pointer to store allocated target of symlink, NULL if file is not a symlink
+ *
+ * @return TRUE on success, FALSE if line is malformed or describes the listed directory
+ *         itself or its parent ("cdir" and "pdir" types)
+ */
+
+gboolean
+vfs_parse_mlsd (const char *p, struct stat * s, char **filename, char **linkname)
+{
+    const char *name;
+    const char *perm = NULL;
+    size_t perm_len = 0;
+    const char *slink = NULL;
+    size_t slink_len = 0;
+    gboolean have_type = FALSE, have_mode = FALSE;
+    mode_t type = S_IFREG;
+    size_t len;
+
+    name = strchr (p, ' ');
+    if (name == NULL || name[1] == '\0')
+        return FALSE;
+
+    s->st_mode = 0;
+    s->st_size = 0;
+    s->st_mtime = 0;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    s->st_rdev = 0;
+#endif
+
+    while (p < name)
+    {
+        const char *end, *eq, *value;
+        size_t fact_len, value_len;
+        guint64 num;
+
+        end = memchr (p, ';', (size_t) (name - p));
+        if (end == NULL)
+            end = name;
+
+        eq = memchr (p, '=', (size_t) (end - p));
+        if (eq == NULL)
+            return FALSE;
+
+        fact_len = (size_t) (eq - p);
+        value = eq + 1;
+        value_len = (size_t) (end - value);
+
+        if (FACT_IS (p, fact_len, "type"))
+        {
+            have_type = TRUE;
+
+            if (FACT_IS (value, value_len, "cdir") || FACT_IS (value, value_len, "pdir"))
+                return FALSE;
+
+            if (FACT_IS (value, value_len, "dir"))
+                type = S_IFDIR;
+            else if (value_len > 13 && g_ascii_strncasecmp (value, "OS.unix=slink", 13) == 0)
+            {
+                type = S_IFLNK;
+                if (value[13] == ':' && value_len > 14)
+                {
+                    slink = value + 14;
+                    slink_len = value_len - 14;
+                }
+            }
+            else if (FACT_IS (value, value_len, "OS.unix=slink")
+                     || FACT_IS (value, value_len, "OS.unix=symlink"))
+                type = S_IFLNK;
+        }
+        else if (FACT_IS (p, fact_len, "size") || FACT_IS (p, fact_len, "sizd"))
+        {
+            if (vfs_parse_mlsd_number (value, value_len, 10, &num))
+                s->st_size = (off_t) num;
+        }
+        else if (FACT_IS (p, fact_len, "modify"))
+            (void) vfs_parse_mlsd_time (value, value_len, &s->st_mtime);
+        else if (FACT_IS (p, fact_len, "perm"))
+        {
+            perm = value;
+            perm_len = value_len;
+        }
+        else if (FACT_IS (p, fact_len, "UNIX.mode"))
+        {
+            have_mode = vfs_parse_mlsd_number (value, value_len, 8, &num);
+            if (have_mode)
+                s->st_mode = (mode_t) num & 07777;
+        }
+        else if (FACT_IS (p, fact_len, "UNIX.owner") || FACT_IS (p, fact_len, "UNIX.uid")
+                 || FACT_IS (p, fact_len, "UNIX.ownername"))
+        {
+            if (vfs_parse_mlsd_number (value, value_len, 10, &num))
+                s->st_uid = (uid_t) num;
+            else
+            {
+                char *owner;
+
+                owner = g_strndup (value, value_len);
+                s->st_uid = (uid_t) vfs_finduid (owner);
+                g_free (owner);
+            }
+        }
+        else if (FACT_IS (p, fact_len, "UNIX.group") || FACT_IS (p, fact_len, "UNIX.gid")
+                 || FACT_IS (p, fact_len, "UNIX.groupname"))
+        {
+            if (vfs_parse_mlsd_number (value, value_len, 10, &num))
+                s->st_gid = (gid_t) num;
+            else
+            {
+                char *group;
+
+                group = g_strndup (value, value_len);
+                s->st_gid = (gid_t) vfs_findgid (group);
+                g_free (group);
+            }
+        }
+
+        p = end + 1;
+    }
+
+    if (!have_type)
+        return FALSE;
+
+    if (have_mode)
+        s->st_mode |= type;
+    else if (type == S_IFLNK)
+        s->st_mode = type | S_IRWXU | S_IRWXG | S_IRWXO;
+    else if (perm != NULL)
+        s->st_mode = type | vfs_parse_mlsd_perm (perm, perm_len, type == S_IFDIR);
+    else if (type == S_IFDIR)
+        s->st_mode = type | S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+    else
+        s->st_mode = type | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+    s->st_atime = s->st_ctime = s->st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    s->st_atim.tv_nsec = s->st_mtim.tv_nsec = s->st_ctim.tv_nsec = 0;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
+    s->st_blksize = 512;
+#endif
+    vfs_adjust_stat (s);
+
+    /* skip the space separating facts and name */
+    name++;
+    len = strlen (name);
+    while (len != 0 && (name[len - 1] == '\r' || name[len - 1] == '\n'))
+        len--;
+    if (len == 0)
+        return FALSE;
+
+    if (filename != NULL)
+        *filename = g_strndup (name, len);
+    if (linkname != NULL)
+        *linkname = slink != NULL ? g_strndup (slink, slink_len) : NULL;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -67,6 +67,9 @@
 #include "vfs.h"
 #include "utilvfs.h"
 #include "gc.h"
+#ifdef ENABLE_VFS_NET
+#include "dircache.h"
+#endif
 
 /* TODO: move it to the separate .h */
 extern struct dirent *mc_readdir_result;
@@ -498,6 +501,9 @@ vfs_shut (void)
     guint i;
 
     vfs_gc_done ();
+#ifdef ENABLE_VFS_NET
+    vfs_s_dircache_done ();
+#endif
 
     vfs_set_raw_current_dir (NULL);
 
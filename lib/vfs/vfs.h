@@ -123,7 +123,8 @@ typedef enum
 /* Operations for mc_ctl - on open file */
 enum
 {
-    VFS_CTL_IS_NOTREADY
+    VFS_CTL_IS_NOTREADY,
+    VFS_CTL_WINDOW              /* set number of outstanding requests, arg is the number */
 };
 
 /* Operations for mc_setctl - on path */
@@ -133,6 +134,8 @@ enum
     VFS_SETCTL_RUN,
     VFS_SETCTL_LOGFILE,
     VFS_SETCTL_FLUSH,           /* invalidate directory cache */
+    VFS_SETCTL_BATCH,           /* queue metadata operations if arg is not NULL, send queued
+                                   ones otherwise and return number of failed of them */
 
     /* Setting this makes vfs layer give out potentially incorrect data,
        but it also makes some operations much faster. Use with caution. */
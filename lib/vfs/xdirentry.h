@@ -13,6 +13,7 @@
 
 #include "lib/global.h"         /* GList */
 #include "lib/vfs/path.h"       /* vfs_path_t */
+#include "lib/vfs/blockcache.h" /* vfs_block_cache_t */
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -103,6 +104,7 @@ typedef struct
     int handle;                 /* This is for module's use, but if != -1, will be mc_close()d */
     gboolean changed;           /* Did this file change? */
     vfs_linear_state_t linear;  /* Is that file open with O_LINEAR? */
+    vfs_block_cache_t *cache;   /* Blocks of remote file read by read_range() */
 } vfs_file_handler_t;
 
 /*
@@ -145,6 +147,13 @@ struct vfs_s_subclass
     int (*linear_start) (struct vfs_class * me, vfs_file_handler_t * fh, off_t from);
     ssize_t (*linear_read) (struct vfs_class * me, vfs_file_handler_t * fh, void *buf, size_t len);
     void (*linear_close) (struct vfs_class * me, vfs_file_handler_t * fh);
+
+    /* optional, used to read files opened read only instead of retrieving them */
+    ssize_t (*read_range) (struct vfs_class * me, vfs_file_handler_t * fh, off_t offset,
+                           void *buf, size_t len);
+    /* optional, start queuing of metadata operations or send queued ones and
+       return number of failed of them */
+    int (*batch) (struct vfs_class * me, struct vfs_s_super * super, gboolean start);
     /* *INDENT-ON* */
 };
 
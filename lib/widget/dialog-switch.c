@@ -44,6 +44,9 @@ WDialog *midnight_dlg = NULL;
 
 /*** file scope macro definitions ****************************************************************/
 
+/* Minimal interval between screen updates of mc_refresh_deferred(), in microseconds */
+#define MC_REFRESH_INTERVAL (G_USEC_PER_SEC / 25)
+
 /*** file scope type declarations ****************************************************************/
 
 /*** file scope variables ************************************************************************/
@@ -54,6 +57,8 @@ static GList *mc_dialogs = NULL;
 static GList *mc_current = NULL;
 /* Is there any dialogs that we have to run after returning to the manager from another dialog */
 static gboolean dialog_switch_pending = FALSE;
+/* Time of the last screen update */
+static guint64 last_refresh = 0;
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -339,7 +344,11 @@ mc_refresh (void)
         return;
 #endif /* ENABLE_BACKGROUND */
     if (mc_global.tty.winch_flag == 0)
+    {
         tty_refresh ();
+        if (mc_global.timer != NULL)
+            last_refresh = mc_timer_elapsed (mc_global.timer);
+    }
     else
     {
         /* if winch was caugth, we should do not only redraw screen, but
@@ -348,6 +357,31 @@ mc_refresh (void)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update the screen if the previous update was done long enough ago. Intended for operations
+ * that report progress often: sending each intermediate state to the terminal costs more
+ * than the operation itself, especially over slow connections. A skipped update is shown by
+ * the next call of this function or mc_refresh(); mc_refresh() is called anyway before waiting
+ * for user input.
+ */
+
+void
+mc_refresh_deferred (void)
+{
+    guint64 now;
+
+    if (mc_global.tty.winch_flag == 0 && mc_global.timer != NULL)
+    {
+        now = mc_timer_elapsed (mc_global.timer);
+        /* the clock may go backwards */
+        if (now >= last_refresh && now - last_refresh < MC_REFRESH_INTERVAL)
+            return;
+    }
+
+    mc_refresh ();
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -32,6 +32,7 @@ void dialog_switch_shutdown (void);
 void clr_scr (void);
 void repaint_screen (void);
 void mc_refresh (void);
+void mc_refresh_deferred (void);
 void dialog_change_screen_size (void);
 
 /*** inline functions ****************************************************************************/
@@ -18,6 +18,8 @@ m4_include([m4.include/vfs/mc-vfs-undelfs.m4])
 m4_include([m4.include/vfs/mc-vfs-tarfs.m4])
 m4_include([m4.include/vfs/mc-vfs-cpiofs.m4])
 m4_include([m4.include/vfs/mc-vfs-samba.m4])
+m4_include([m4.include/vfs/mc-vfs-zipfs.m4])
+m4_include([m4.include/vfs/mc-vfs-decompress.m4])
 
 dnl mc_VFS_CHECKS
 dnl   Check for various functions needed by libvfs.
@@ -70,6 +72,7 @@ AC_DEFUN([mc_VFS_CHECKS],
     fi
 
     mc_VFS_CPIOFS
+    mc_VFS_DECOMPRESS
     mc_VFS_EXTFS
     mc_VFS_FISH
     mc_VFS_FTP
@@ -78,6 +81,7 @@ AC_DEFUN([mc_VFS_CHECKS],
     mc_VFS_SMB
     mc_VFS_TARFS
     mc_VFS_UNDELFS
+    mc_VFS_ZIPFS
 
     AM_CONDITIONAL(ENABLE_VFS, [test x"$enable_vfs" = x"yes"])
 
@@ -0,0 +1,43 @@
+dnl In-process decompression of single files
+AC_DEFUN([mc_VFS_DECOMPRESS],
+[
+    AC_ARG_ENABLE([vfs-decompress],
+		    AS_HELP_STRING([--enable-vfs-decompress], [Support for in-process decompression of gzip, bzip2, xz and zstd files [auto]]))
+    if test "$enable_vfs" = "yes" -a x"$enable_vfs_decompress" != x"no"; then
+	PKG_CHECK_MODULES(ZLIB, [zlib], [found_zlib=yes], [:])
+	if test x"$found_zlib" = "xyes"; then
+	    mc_VFS_ADDNAME([decompress])
+	    AC_DEFINE([ENABLE_VFS_DECOMPRESS], [1], [Support for in-process decompression of files])
+	    DECOMPRESS_CFLAGS="$ZLIB_CFLAGS"
+	    DECOMPRESS_LIBS="$ZLIB_LIBS"
+
+	    dnl other formats are optional, sfs handles them if library is not found
+	    AC_CHECK_HEADER([bzlib.h],
+		[AC_CHECK_LIB([bz2], [BZ2_bzDecompressInit],
+		    [AC_DEFINE([HAVE_LIBBZ2], [1], [Define if libbz2 is available])
+		     DECOMPRESS_LIBS="$DECOMPRESS_LIBS -lbz2"])])
+
+	    PKG_CHECK_MODULES(LZMA, [liblzma],
+		[AC_DEFINE([HAVE_LIBLZMA], [1], [Define if liblzma is available])
+		 DECOMPRESS_CFLAGS="$DECOMPRESS_CFLAGS $LZMA_CFLAGS"
+		 DECOMPRESS_LIBS="$DECOMPRESS_LIBS $LZMA_LIBS"], [:])
+
+	    dnl ZSTD_DCtx_reset() is stable since 1.4.0
+	    PKG_CHECK_MODULES(ZSTD, [libzstd >= 1.4.0],
+		[AC_DEFINE([HAVE_LIBZSTD], [1], [Define if libzstd is available])
+		 DECOMPRESS_CFLAGS="$DECOMPRESS_CFLAGS $ZSTD_CFLAGS"
+		 DECOMPRESS_LIBS="$DECOMPRESS_LIBS $ZSTD_LIBS"], [:])
+
+	    MCLIBS="$MCLIBS $DECOMPRESS_LIBS"
+	    enable_vfs_decompress="yes"
+	else
+	    if test x"$enable_vfs_decompress" = x"yes"; then
+		dnl user explicitly requested feature
+		AC_MSG_ERROR([zlib library not found])
+	    fi
+	    enable_vfs_decompress="no"
+	fi
+    fi
+    AC_SUBST(DECOMPRESS_CFLAGS)
+    AM_CONDITIONAL(ENABLE_VFS_DECOMPRESS, [test "$enable_vfs" = "yes" -a x"$enable_vfs_decompress" = x"yes"])
+])
@@ -0,0 +1,26 @@
+dnl ZIP filesystem support
+AC_DEFUN([mc_VFS_ZIPFS],
+[
+    AC_ARG_ENABLE([vfs-zip],
+		    AS_HELP_STRING([--enable-vfs-zip], [Support for zip filesystem [auto]]))
+    ZIP_VFS_PREFIX="uzip"
+    if test "$enable_vfs" = "yes" -a x"$enable_vfs_zip" != x"no"; then
+	PKG_CHECK_MODULES(ZLIB, [zlib], [found_zlib=yes], [:])
+	if test x"$found_zlib" = "xyes"; then
+	    mc_VFS_ADDNAME([zip])
+	    AC_DEFINE([ENABLE_VFS_ZIP], [1], [Support for zip filesystem])
+	    MCLIBS="$MCLIBS $ZLIB_LIBS"
+	    dnl open zip archives with zipfs instead of extfs helper
+	    ZIP_VFS_PREFIX="zip"
+	    enable_vfs_zip="yes"
+	else
+	    if test x"$enable_vfs_zip" = x"yes"; then
+		dnl user explicitly requested feature
+		AC_MSG_ERROR([zlib library not found])
+	    fi
+	    enable_vfs_zip="no"
+	fi
+    fi
+    AC_SUBST(ZIP_VFS_PREFIX)
+    AM_CONDITIONAL(ENABLE_VFS_ZIP, [test "$enable_vfs" = "yes" -a x"$enable_vfs_zip" = x"yes"])
+])
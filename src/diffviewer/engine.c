@@ -0,0 +1,869 @@
+/*
+   Built-in diff engine for diffviewer.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: built-in diff engine for diffviewer.
+ *
+ * Files are mapped into memory and split into lines once. For each combination of
+ * comparison options, hashes of normalized lines are computed on demand and kept
+ * together with the file, so re-diffing after an option change does not touch the
+ * file again. Lines are reduced to equivalence classes, lines without a pair in the
+ * other file are discarded, and the rest is compared with the Myers O(ND) algorithm
+ * in linear space, like GNU diff does.
+ */
+
+#include <config.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#include <unistd.h>
+
+#include "lib/global.h"
+
+#include "internal.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define DFF_TAB_WIDTH 8
+
+/* Lower bound of edit steps in one search before the result is approximated */
+#define DFF_MIN_EXPENSIVE 4096
+#define DFF_MIN_EXPENSIVE_FAST 256
+
+/*** file scope type declarations ****************************************************************/
+
+/* iterator over the normalized characters of line */
+typedef struct
+{
+    const char *p;
+    const char *end;
+    int col;
+    int pending;
+    int flags;
+} dff_line_iter_t;
+
+typedef struct
+{
+    const int *xv;
+    const int *yv;
+    char *xchg;
+    char *ychg;
+    int *fdiag;
+    int *bdiag;
+    int too_expensive;
+    guint64 deadline;           /* time to stop at (see mc_timer_elapsed()), 0 if unlimited */
+} dff_ctx_t;
+
+typedef struct
+{
+    int xmid;
+    int ymid;
+    gboolean lo_minimal;
+    gboolean hi_minimal;
+} dff_partition_t;
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline size_t
+dff_line_start (const DIFFFILE * df, int line)
+{
+    return g_array_index (df->lines, size_t, line);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dff_line_iter_init (dff_line_iter_t * it, const DIFFFILE * df, int line, int flags)
+{
+    it->p = df->data + dff_line_start (df, line);
+    it->end = df->data + dff_line_start (df, line + 1);
+    if (it->end > it->p && it->end[-1] == '\n')
+        it->end--;
+    if ((flags & DFF_STRIP_TRAILING_CR) != 0 && it->end > it->p && it->end[-1] == '\r')
+        it->end--;
+    it->col = 0;
+    it->pending = 0;
+    it->flags = flags;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get next character of line as it is seen with the comparison options.
+ *
+ * @return character or -1 at the end of line
+ */
+
+static int
+dff_line_iter_next (dff_line_iter_t * it)
+{
+    if (it->pending != 0)
+    {
+        it->pending--;
+        it->col++;
+        return ' ';
+    }
+
+    while (it->p < it->end)
+    {
+        unsigned char c = (unsigned char) *it->p++;
+
+        if (!isspace (c))
+        {
+            it->col++;
+            return (it->flags & DFF_IGNORE_CASE) != 0 ? tolower (c) : c;
+        }
+
+        if ((it->flags & DFF_IGNORE_ALL_SPACE) != 0)
+            continue;
+
+        if ((it->flags & DFF_IGNORE_SPACE_CHANGE) != 0)
+        {
+            /* any run of spaces is one space, trailing spaces are ignored */
+            while (it->p < it->end && isspace ((unsigned char) *it->p))
+                it->p++;
+            if (it->p == it->end)
+                return -1;
+            it->col++;
+            return ' ';
+        }
+
+        if (c == '\t' && (it->flags & DFF_IGNORE_TAB_EXPANSION) != 0)
+        {
+            it->pending = DFF_TAB_WIDTH - 1 - it->col % DFF_TAB_WIDTH;
+            it->col++;
+            return ' ';
+        }
+
+        it->col++;
+        return c;
+    }
+
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline gboolean
+dff_line_has_eol (const DIFFFILE * df, int line)
+{
+    size_t end = dff_line_start (df, line + 1);
+
+    return end > dff_line_start (df, line) && df->data[end - 1] == '\n';
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dff_line_equal (const DIFFFILE * df1, int line1, const DIFFFILE * df2, int line2, int flags)
+{
+    dff_line_iter_t it1, it2;
+    int c1, c2;
+
+    /* like diff, last line without newline differs from the same line with it */
+    if (dff_line_has_eol (df1, line1) != dff_line_has_eol (df2, line2))
+        return FALSE;
+
+    dff_line_iter_init (&it1, df1, line1, flags);
+    dff_line_iter_init (&it2, df2, line2, flags);
+
+    do
+    {
+        c1 = dff_line_iter_next (&it1);
+        c2 = dff_line_iter_next (&it2);
+    }
+    while (c1 == c2 && c1 != -1);
+
+    return (c1 == c2);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get line hashes for the comparison options. Hashes are computed once for each
+ * combination of options and kept until the file is freed.
+ */
+
+static const guint32 *
+dff_file_hashes (DIFFFILE * df, int flags)
+{
+    int n, i;
+    guint32 *hash;
+
+    if (df->hash[flags] != NULL)
+        return df->hash[flags];
+
+    n = df->lines->len - 1;
+    hash = g_new (guint32, MAX (n, 1));
+
+    for (i = 0; i < n; i++)
+    {
+        dff_line_iter_t it;
+        guint32 h = 2166136261U;        /* FNV-1a */
+        int c;
+
+        dff_line_iter_init (&it, df, i, flags);
+        while ((c = dff_line_iter_next (&it)) != -1)
+            h = (h ^ (guint32) c) * 16777619U;
+
+        if (!dff_line_has_eol (df, i))
+            h = ~h;
+
+        hash[i] = h;
+    }
+
+    df->hash[flags] = hash;
+    return hash;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the midpoint of the shortest edit script for a specified portion of the two
+ * sequences. If it is too expensive to find the real one, find a good approximation.
+ * See "An O(ND) Difference Algorithm and its Variations" by Eugene W. Myers.
+ */
+
+static void
+dff_diag (const dff_ctx_t * ctx, int xoff, int xlim, int yoff, int ylim, gboolean find_minimal,
+          dff_partition_t * part)
+{
+    int *const fd = ctx->fdiag;
+    int *const bd = ctx->bdiag;
+    const int *const xv = ctx->xv;
+    const int *const yv = ctx->yv;
+    const int dmin = xoff - ylim;       /* minimum valid diagonal */
+    const int dmax = xlim - yoff;       /* maximum valid diagonal */
+    const int fmid = xoff - yoff;       /* center diagonal of top-down search */
+    const int bmid = xlim - ylim;       /* center diagonal of bottom-up search */
+    int fmin = fmid, fmax = fmid;
+    int bmin = bmid, bmax = bmid;
+    gboolean odd = ((fmid - bmid) & 1) != 0;
+    int c;
+
+    fd[fmid] = xoff;
+    bd[bmid] = xlim;
+
+    for (c = 1;; c++)
+    {
+        int d;
+
+        /* extend the top-down search by an edit step in each diagonal */
+        if (fmin > dmin)
+            fd[--fmin - 1] = -1;
+        else
+            fmin++;
+        if (fmax < dmax)
+            fd[++fmax + 1] = -1;
+        else
+            fmax--;
+
+        for (d = fmax; d >= fmin; d -= 2)
+        {
+            int x, y;
+            int tlo = fd[d - 1], thi = fd[d + 1];
+
+            x = tlo < thi ? thi : tlo + 1;
+            for (y = x - d; x < xlim && y < ylim && xv[x] == yv[y]; x++, y++)
+                ;
+            fd[d] = x;
+
+            if (odd && bmin <= d && d <= bmax && bd[d] <= x)
+            {
+                part->xmid = x;
+                part->ymid = y;
+                part->lo_minimal = part->hi_minimal = TRUE;
+                return;
+            }
+        }
+
+        /* similarly extend the bottom-up search */
+        if (bmin > dmin)
+            bd[--bmin - 1] = INT_MAX;
+        else
+            bmin++;
+        if (bmax < dmax)
+            bd[++bmax + 1] = INT_MAX;
+        else
+            bmax--;
+
+        for (d = bmax; d >= bmin; d -= 2)
+        {
+            int x, y;
+            int tlo = bd[d - 1], thi = bd[d + 1];
+
+            x = tlo < thi ? tlo : thi - 1;
+            for (y = x - d; xoff < x && yoff < y && xv[x - 1] == yv[y - 1]; x--, y--)
+                ;
+            bd[d] = x;
+
+            if (!odd && fmin <= d && d <= fmax && x <= fd[d])
+            {
+                part->xmid = x;
+                part->ymid = y;
+                part->lo_minimal = part->hi_minimal = TRUE;
+                return;
+            }
+        }
+
+        if (find_minimal || c < ctx->too_expensive)
+            continue;
+
+        /* we've gone well beyond the call of duty: give up and report
+           the best of the results so far */
+        {
+            int fxybest = -1, fxbest = 0;
+            int bxybest = INT_MAX, bxbest = 0;
+
+            /* find forward diagonal that maximizes x + y */
+            for (d = fmax; d >= fmin; d -= 2)
+            {
+                int x, y;
+
+                x = MIN (fd[d], xlim);
+                y = x - d;
+                if (ylim < y)
+                {
+                    x = ylim + d;
+                    y = ylim;
+                }
+                if (fxybest < x + y)
+                {
+                    fxybest = x + y;
+                    fxbest = x;
+                }
+            }
+
+            /* find backward diagonal that minimizes x + y */
+            for (d = bmax; d >= bmin; d -= 2)
+            {
+                int x, y;
+
+                x = MAX (xoff, bd[d]);
+                y = x - d;
+                if (y < yoff)
+                {
+                    x = yoff + d;
+                    y = yoff;
+                }
+                if (x + y < bxybest)
+                {
+                    bxybest = x + y;
+                    bxbest = x;
+                }
+            }
+
+            if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff))
+            {
+                part->xmid = fxbest;
+                part->ymid = fxybest - fxbest;
+                part->lo_minimal = TRUE;
+                part->hi_minimal = FALSE;
+            }
+            else
+            {
+                part->xmid = bxbest;
+                part->ymid = bxybest - bxbest;
+                part->lo_minimal = FALSE;
+                part->hi_minimal = TRUE;
+            }
+            return;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare in detail contiguous subsequences of the two sequences and mark changed elements.
+ */
+
+static void
+dff_compareseq (const dff_ctx_t * ctx, int xoff, int xlim, int yoff, int ylim,
+                gboolean find_minimal)
+{
+    const int *const xv = ctx->xv;
+    const int *const yv = ctx->yv;
+
+    /* slide down the bottom initial diagonal */
+    while (xoff < xlim && yoff < ylim && xv[xoff] == yv[yoff])
+    {
+        xoff++;
+        yoff++;
+    }
+
+    /* slide up the top initial diagonal */
+    while (xlim > xoff && ylim > yoff && xv[xlim - 1] == yv[ylim - 1])
+    {
+        xlim--;
+        ylim--;
+    }
+
+    if (xoff == xlim)
+        memset (ctx->ychg + yoff, 1, ylim - yoff);
+    else if (yoff == ylim)
+        memset (ctx->xchg + xoff, 1, xlim - xoff);
+    else if (ctx->deadline != 0 && mc_timer_elapsed (mc_global.timer) > ctx->deadline)
+    {
+        /* out of time: the rest is reported as changed */
+        memset (ctx->xchg + xoff, 1, xlim - xoff);
+        memset (ctx->ychg + yoff, 1, ylim - yoff);
+    }
+    else
+    {
+        dff_partition_t part;
+
+        dff_diag (ctx, xoff, xlim, yoff, ylim, find_minimal, &part);
+        dff_compareseq (ctx, xoff, part.xmid, yoff, part.ymid, part.lo_minimal);
+        dff_compareseq (ctx, part.xmid, xlim, part.ymid, ylim, part.hi_minimal);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move each group of changed lines as far down as possible, so that equal hunks
+ * are reported at the same place regardless of the way they were found.
+ * This never changes the set of unchanged lines, only which one of equal lines is used.
+ */
+
+static void
+dff_shift_boundaries (const int *cls, char *chg, int n)
+{
+    int i = 0;
+
+    while (i < n)
+    {
+        int start, end;
+
+        for (; i < n && chg[i] == 0; i++)
+            ;
+        if (i == n)
+            break;
+
+        start = i;
+        for (end = start; end < n && chg[end] != 0; end++)
+            ;
+
+        /* move group down while its first line equals the line after it */
+        while (end < n && cls[start] == cls[end])
+        {
+            chg[start++] = 0;
+            chg[end++] = 1;
+            /* merge with the following group */
+            for (; end < n && chg[end] != 0; end++)
+                ;
+        }
+
+        i = end;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dff_add_op (GArray * ops, int cmd, int f1, int f2, int t1, int t2)
+{
+    DIFFCMD op;
+
+    op.a[0][0] = f1;
+    op.a[0][1] = f2;
+    op.cmd = cmd;
+    op.a[1][0] = t1;
+    op.a[1][1] = t2;
+    g_array_append_val (ops, op);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Convert arrays of changed lines to diff statements in the format of "diff" normal output.
+ */
+
+static int
+dff_build_ops (const char *xchg, int nx, const char *ychg, int ny, GArray * ops)
+{
+    int i = 0, j = 0;
+
+    while (i < nx || j < ny)
+    {
+        int i0, j0;
+
+        if (i < nx && j < ny && xchg[i] == 0 && ychg[j] == 0)
+        {
+            i++;
+            j++;
+            continue;
+        }
+
+        for (i0 = i; i < nx && xchg[i] != 0; i++)
+            ;
+        for (j0 = j; j < ny && ychg[j] != 0; j++)
+            ;
+
+        if (i == i0 && j == j0)
+            return -1;          /* unchanged lines don't match: must not happen */
+
+        if (j == j0)
+            dff_add_op (ops, 'd', i0 + 1, i, j0, j0);
+        else if (i == i0)
+            dff_add_op (ops, 'a', i0, i0, j0 + 1, j);
+        else
+            dff_add_op (ops, 'c', i0 + 1, i, j0 + 1, j);
+    }
+
+    return ops->len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Map lines of both files to equivalence classes: equal lines get the same number.
+ *
+ * @return number of classes
+ */
+
+static int
+dff_classify (DIFFFILE * const *df, const guint32 * const *hash, const int *nl, int flags,
+              int **cls)
+{
+    guint32 size = 1;
+    guint32 *table;             /* class number + 1, or 0 if slot is empty */
+    int *rep_file, *rep_line;
+    int nclasses = 0;
+    int k;
+
+    while (size < 2 * (guint32) (nl[DIFF_LEFT] + nl[DIFF_RIGHT]) + 1)
+        size <<= 1;
+
+    table = g_new0 (guint32, size);
+    rep_file = g_new (int, nl[DIFF_LEFT] + nl[DIFF_RIGHT] + 1);
+    rep_line = g_new (int, nl[DIFF_LEFT] + nl[DIFF_RIGHT] + 1);
+
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+    {
+        int i;
+
+        for (i = 0; i < nl[k]; i++)
+        {
+            guint32 slot;
+
+            for (slot = hash[k][i] & (size - 1);; slot = (slot + 1) & (size - 1))
+            {
+                int c = (int) table[slot] - 1;
+
+                if (c < 0)
+                {
+                    /* new class */
+                    c = nclasses++;
+                    rep_file[c] = k;
+                    rep_line[c] = i;
+                    table[slot] = c + 1;
+                    cls[k][i] = c;
+                    break;
+                }
+
+                if (hash[rep_file[c]][rep_line[c]] == hash[k][i]
+                    && dff_line_equal (df[rep_file[c]], rep_line[c], df[k], i, flags))
+                {
+                    cls[k][i] = c;
+                    break;
+                }
+            }
+        }
+    }
+
+    g_free (rep_line);
+    g_free (rep_file);
+    g_free (table);
+
+    return nclasses;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load file for comparison and split it into lines.
+ *
+ * @param filename name of file
+ *
+ * @return file data or NULL on error
+ */
+
+DIFFFILE *
+dff_file_load (const char *filename)
+{
+    DIFFFILE *df;
+    struct stat st;
+    int fd;
+    size_t i;
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || (off_t) (size_t) st.st_size != st.st_size)
+    {
+        close (fd);
+        return NULL;
+    }
+
+    df = g_new0 (DIFFFILE, 1);
+    df->size = (size_t) st.st_size;
+
+#ifdef HAVE_MMAP
+    if (df->size != 0)
+    {
+        df->data = mmap (0, df->size, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, 0);
+        if (df->data == (char *) -1)
+            df->data = NULL;
+        else
+            df->mapped = TRUE;
+    }
+#endif
+
+    if (df->data == NULL)
+    {
+        size_t done = 0;
+
+        df->data = g_malloc (df->size + 1);
+
+        while (done < df->size)
+        {
+            ssize_t n;
+
+            n = read (fd, df->data + done, df->size - done);
+            if (n == -1 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            done += (size_t) n;
+        }
+
+        /* file was truncated while reading */
+        df->size = done;
+    }
+
+    close (fd);
+
+    df->lines = g_array_new (FALSE, FALSE, sizeof (size_t));
+
+    for (i = 0; i < df->size;)
+    {
+        const char *eol;
+
+        g_array_append_val (df->lines, i);
+        eol = memchr (df->data + i, '\n', df->size - i);
+        i = eol == NULL ? df->size : (size_t) (eol - df->data) + 1;
+    }
+
+    /* end of the last line */
+    g_array_append_val (df->lines, df->size);
+
+    return df;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+dff_file_free (DIFFFILE * df)
+{
+    int i;
+
+    if (df == NULL)
+        return;
+
+#ifdef HAVE_MMAP
+    if (df->mapped)
+        munmap (df->data, df->size);
+    else
+#endif
+        g_free (df->data);
+
+    for (i = 0; i < DFF_FLAGS_COUNT; i++)
+        g_free (df->hash[i]);
+
+    g_array_free (df->lines, TRUE);
+    g_free (df);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare two sequences and mark elements which are not in their common subsequence.
+ *
+ * @param xv first sequence
+ * @param nx length of first sequence
+ * @param yv second sequence
+ * @param ny length of second sequence
+ * @param xchg zero-filled array of nx elements to mark changes of first sequence
+ * @param ychg zero-filled array of ny elements to mark changes of second sequence
+ * @param quality 0 for normal diff, 1 for fast diff of large files, 2 for minimal diff
+ * @param deadline value of mc_timer_elapsed() after which the rest is marked as changed,
+ *                 0 to compare without time limit
+ */
+
+void
+dff_compare_seq (const int *xv, int nx, const int *yv, int ny, char *xchg, char *ychg,
+                 int quality, guint64 deadline)
+{
+    dff_ctx_t ctx;
+    int *diag;
+    int ndiags;
+    int d;
+
+    ndiags = nx + ny + 3;
+    diag = g_new (int, 2 * ndiags);
+
+    ctx.xv = xv;
+    ctx.yv = yv;
+    ctx.xchg = xchg;
+    ctx.ychg = ychg;
+    ctx.fdiag = diag + ny + 1;
+    ctx.bdiag = ctx.fdiag + ndiags;
+    ctx.deadline = deadline;
+
+    /* about square root of the total length, as in GNU diff */
+    for (ctx.too_expensive = 1, d = ndiags; d != 0; d >>= 2)
+        ctx.too_expensive <<= 1;
+    if (quality == 1)
+        ctx.too_expensive = DFF_MIN_EXPENSIVE_FAST;
+    else
+        ctx.too_expensive = MAX (ctx.too_expensive, DFF_MIN_EXPENSIVE);
+
+    dff_compareseq (&ctx, 0, nx, 0, ny, quality == 2);
+
+    g_free (diag);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare two files and extract diff statements.
+ *
+ * @param df loaded files
+ * @param flags comparison options
+ * @param quality 0 for normal diff, 1 for fast diff of large files, 2 for minimal diff
+ * @param ops list of diff statements to fill
+ *
+ * @return positive number indicating number of hunks, otherwise negative
+ */
+
+int
+dff_compute (DIFFFILE * const *df, int flags, int quality, GArray * ops)
+{
+    const guint32 *hash[DIFF_COUNT];
+    int nl[DIFF_COUNT];
+    int *cls[DIFF_COUNT];
+    char *chg[DIFF_COUNT];
+    int *count[DIFF_COUNT];
+    int *idx[DIFF_COUNT];       /* numbers of lines which have a pair in other file */
+    int *seq[DIFF_COUNT];       /* classes of these lines */
+    int nseq[DIFF_COUNT];
+    int nclasses;
+    int k, rv;
+
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+    {
+        if (df[k]->lines->len - 1 > INT_MAX / 4)
+            return -1;
+        nl[k] = df[k]->lines->len - 1;
+        hash[k] = dff_file_hashes (df[k], flags);
+        cls[k] = g_new (int, nl[k] + 1);
+        chg[k] = g_new0 (char, nl[k] + 1);
+    }
+
+    nclasses = dff_classify (df, hash, nl, flags, cls);
+
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+    {
+        int i;
+
+        count[k] = g_new0 (int, nclasses + 1);
+        for (i = 0; i < nl[k]; i++)
+            count[k][cls[k][i]]++;
+    }
+
+    /* lines without pair in the other file are changed anyway */
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+    {
+        int i;
+
+        idx[k] = g_new (int, nl[k] + 1);
+        seq[k] = g_new (int, nl[k] + 1);
+        nseq[k] = 0;
+
+        for (i = 0; i < nl[k]; i++)
+        {
+            if (count[k ^ 1][cls[k][i]] == 0)
+                chg[k][i] = 1;
+            else
+            {
+                idx[k][nseq[k]] = i;
+                seq[k][nseq[k]] = cls[k][i];
+                nseq[k]++;
+            }
+        }
+    }
+
+    {
+        char *xchg, *ychg;
+
+        xchg = g_new0 (char, nseq[DIFF_LEFT] + 1);
+        ychg = g_new0 (char, nseq[DIFF_RIGHT] + 1);
+
+        dff_compare_seq (seq[DIFF_LEFT], nseq[DIFF_LEFT], seq[DIFF_RIGHT], nseq[DIFF_RIGHT],
+                         xchg, ychg, quality, 0);
+
+        for (k = 0; k < nseq[DIFF_LEFT]; k++)
+            chg[DIFF_LEFT][idx[DIFF_LEFT][k]] = xchg[k];
+        for (k = 0; k < nseq[DIFF_RIGHT]; k++)
+            chg[DIFF_RIGHT][idx[DIFF_RIGHT][k]] = ychg[k];
+
+        g_free (ychg);
+        g_free (xchg);
+    }
+
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+        dff_shift_boundaries (cls[k], chg[k], nl[k]);
+
+    rv = dff_build_ops (chg[DIFF_LEFT], nl[DIFF_LEFT], chg[DIFF_RIGHT], nl[DIFF_RIGHT], ops);
+
+    for (k = DIFF_LEFT; k < DIFF_COUNT; k++)
+    {
+        g_free (seq[k]);
+        g_free (idx[k]);
+        g_free (count[k]);
+        g_free (chg[k]);
+        g_free (cls[k]);
+    }
+
+    return rv;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -10,10 +10,12 @@
 /*** typedefs(not structures) and defined constants **********************************************/
 
 typedef int (*DFUNC) (void *ctx, int ch, int line, off_t off, size_t sz, const char *str);
-typedef int PAIR[2];
 
 #define error_dialog(h, s) query_dialog(h, s, D_ERROR, 1, _("&Dismiss"))
 
+/* number of combinations of dff_flags_t */
+#define DFF_FLAGS_COUNT 32
+
 /*** enums ***************************************************************************************/
 
 typedef enum
@@ -38,6 +40,16 @@ typedef enum
     DIFF_CHG = 3
 } DiffState;
 
+/* comparison options of built-in diff engine */
+typedef enum
+{
+    DFF_IGNORE_CASE = 1 << 0,
+    DFF_IGNORE_TAB_EXPANSION = 1 << 1,
+    DFF_IGNORE_SPACE_CHANGE = 1 << 2,
+    DFF_IGNORE_ALL_SPACE = 1 << 3,
+    DFF_STRIP_TRAILING_CR = 1 << 4
+} dff_flags_t;
+
 /*** structures declarations (and typedefs of structures)*****************************************/
 
 typedef struct
@@ -56,6 +68,15 @@ typedef struct
     int cmd;
 } DIFFCMD;
 
+typedef struct
+{
+    char *data;                 /* file content */
+    size_t size;
+    gboolean mapped;            /* data is mmapped */
+    GArray *lines;              /* offsets of line beginnings (size_t) and the file size */
+    guint32 *hash[DFF_FLAGS_COUNT];     /* line hashes for each combination of options */
+} DIFFFILE;
+
 
 typedef struct
 {
@@ -86,8 +107,8 @@ typedef struct WDiff
 {
     Widget widget;
 
-    const char *args;           /* Args passed to diff */
     const char *file[DIFF_COUNT];       /* filenames */
+    DIFFFILE *df[DIFF_COUNT];   /* files loaded by diff engine */
     char *label[DIFF_COUNT];
     FBUF *f[DIFF_COUNT];
     const char *backup_sufix;
@@ -146,6 +167,13 @@ typedef struct WDiff
 
 /*** declarations of public functions ************************************************************/
 
+/* engine.c */
+DIFFFILE *dff_file_load (const char *filename);
+void dff_file_free (DIFFFILE * df);
+void dff_compare_seq (const int *xv, int nx, const int *yv, int ny, char *xchg, char *ychg,
+                      int quality, guint64 deadline);
+int dff_compute (DIFFFILE * const *df, int flags, int quality, GArray * ops);
+
 /* search.c */
 void dview_search_cmd (WDiff * dview);
 void dview_continue_search_cmd (WDiff * dview);
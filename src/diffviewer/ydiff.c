@@ -33,7 +33,6 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
@@ -44,7 +43,6 @@
 #include "lib/util.h"
 #include "lib/widget.h"
 #include "lib/strutil.h"
-#include "lib/strescape.h"      /* strutils_glob_escape() */
 #ifdef HAVE_CHARSET
 #include "lib/charsets.h"
 #endif
@@ -91,7 +89,8 @@ do { \
 
 #define HDIFF_ENABLE 1
 #define HDIFF_MINCTX 5
-#define HDIFF_DEPTH 10
+/* time limit to compare one line, in microseconds */
+#define HDIFF_TIME_LIMIT 50000
 
 #define FILE_DIRTY(fs) \
 do \
@@ -488,71 +487,6 @@ f_close (FBUF * fs)
 
 /* --------------------------------------------------------------------------------------------- */
 
-/**
- * Create pipe stream to process.
- *
- * @param cmd shell command line
- * @param flags open mode, either O_RDONLY or O_WRONLY
- *
- * @return file structure
- */
-
-static FBUF *
-p_open (const char *cmd, int flags)
-{
-    FILE *f;
-    FBUF *fs;
-    const char *type = NULL;
-
-    if (flags == O_RDONLY)
-        type = "r";
-    else if (flags == O_WRONLY)
-        type = "w";
-
-    if (type == NULL)
-        return NULL;
-
-    fs = f_dopen (0);
-    if (fs == NULL)
-        return NULL;
-
-    f = popen (cmd, type);
-    if (f == NULL)
-    {
-        f_free (fs);
-        return NULL;
-    }
-
-    fs->fd = fileno (f);
-    fs->data = f;
-    return fs;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Close pipe stream.
- *
- * @param fs structure
- * @return 0 on success, non-zero on error
- */
-
-static int
-p_close (FBUF * fs)
-{
-    int rv = -1;
-
-    if (fs != NULL)
-    {
-        rv = pclose (fs->data);
-        f_free (fs);
-    }
-
-    return rv;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 /**
  * Get one char (byte) from string
  *
@@ -672,174 +606,6 @@ scan_deci (const char **str, int *n)
 
 /* --------------------------------------------------------------------------------------------- */
 
-/**
- * Parse line for diff statement.
- *
- * @param p string to parse
- * @param ops list of diff statements
- * @return 0 if success, otherwise non-zero
- */
-
-static int
-scan_line (const char *p, GArray * ops)
-{
-    DIFFCMD op;
-
-    int f1, f2;
-    int t1, t2;
-    int cmd;
-    int range;
-
-    /* handle the following cases:
-     *  NUMaNUM[,NUM]
-     *  NUM[,NUM]cNUM[,NUM]
-     *  NUM[,NUM]dNUM
-     * where NUM is a positive integer
-     */
-
-    if (scan_deci (&p, &f1) != 0 || f1 < 0)
-        return -1;
-
-    f2 = f1;
-    range = 0;
-    if (*p == ',')
-    {
-        p++;
-        if (scan_deci (&p, &f2) != 0 || f2 < f1)
-            return -1;
-
-        range = 1;
-    }
-
-    cmd = *p++;
-    if (cmd == 'a')
-    {
-        if (range != 0)
-            return -1;
-    }
-    else if (cmd != 'c' && cmd != 'd')
-        return -1;
-
-    if (scan_deci (&p, &t1) != 0 || t1 < 0)
-        return -1;
-
-    t2 = t1;
-    range = 0;
-    if (*p == ',')
-    {
-        p++;
-        if (scan_deci (&p, &t2) != 0 || t2 < t1)
-            return -1;
-
-        range = 1;
-    }
-
-    if (cmd == 'd' && range != 0)
-        return -1;
-
-    op.a[0][0] = f1;
-    op.a[0][1] = f2;
-    op.cmd = cmd;
-    op.a[1][0] = t1;
-    op.a[1][1] = t2;
-    g_array_append_val (ops, op);
-    return 0;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Parse diff output and extract diff statements.
- *
- * @param f stream to read from
- * @param ops list of diff statements to fill
- * @return positive number indicating number of hunks, otherwise negative
- */
-
-static int
-scan_diff (FBUF * f, GArray * ops)
-{
-    int sz;
-    char buf[BUFSIZ];
-
-    while ((sz = f_gets (buf, sizeof (buf) - 1, f)) != 0)
-    {
-        if (isdigit (buf[0]))
-        {
-            if (buf[sz - 1] != '\n')
-                return -1;
-
-            buf[sz] = '\0';
-            if (scan_line (buf, ops) != 0)
-                return -1;
-
-            continue;
-        }
-
-        while (buf[sz - 1] != '\n' && (sz = f_gets (buf, sizeof (buf), f)) != 0)
-            ;
-    }
-
-    return ops->len;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-/**
- * Invoke diff and extract diff statements.
- *
- * @param args extra arguments to be passed to diff
- * @param extra more arguments to be passed to diff
- * @param file1 first file to compare
- * @param file2 second file to compare
- * @param ops list of diff statements to fill
- *
- * @return positive number indicating number of hunks, otherwise negative
- */
-
-static int
-dff_execute (const char *args, const char *extra, const char *file1, const char *file2,
-             GArray * ops)
-{
-    static const char *opt =
-        " --old-group-format='%df%(f=l?:,%dl)d%dE\n'"
-        " --new-group-format='%dea%dF%(F=L?:,%dL)\n'"
-        " --changed-group-format='%df%(f=l?:,%dl)c%dF%(F=L?:,%dL)\n'"
-        " --unchanged-group-format=''";
-
-    int rv;
-    FBUF *f;
-    char *cmd;
-    int code;
-    char *file1_esc, *file2_esc;
-
-    /* escape potential $ to avoid shell variable substitutions in popen() */
-    file1_esc = strutils_shell_escape (file1);
-    file2_esc = strutils_shell_escape (file2);
-    cmd = g_strdup_printf ("diff %s %s %s %s %s", args, extra, opt, file1_esc, file2_esc);
-    g_free (file1_esc);
-    g_free (file2_esc);
-
-    if (cmd == NULL)
-        return -1;
-
-    f = p_open (cmd, O_RDONLY);
-    g_free (cmd);
-
-    if (f == NULL)
-        return -1;
-
-    rv = scan_diff (f, ops);
-    code = p_close (f);
-
-    if (rv < 0 || code == -1 || !WIFEXITED (code) || WEXITSTATUS (code) == 2)
-        rv = -1;
-
-    return rv;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 /**
  * Reparse and display file according to diff statements.
  *
@@ -1017,214 +783,154 @@ dff_reparse (diff_place_t ord, const char *filename, const GArray * ops, DFUNC p
 /* horizontal diff ********************************************************** */
 
 /**
- * Longest common substring.
- *
- * @param s first string
- * @param m length of first string
- * @param t second string
- * @param n length of second string
- * @param ret list of offsets for longest common substrings inside each string
- * @param min minimum length of common substrings
- *
- * @return 0 if success, nonzero otherwise
+ * Add range of changed characters to the list of horizontal diff ranges.
+ * Ranges separated by too short common text are joined.
  */
 
-static int
-lcsubstr (const char *s, int m, const char *t, int n, GArray * ret, int min)
+static void
+hdiff_add (GArray * hdiff, int off1, int len1, int off2, int len2, int min)
 {
-    int i, j;
-    int *Lprev, *Lcurr;
-    int z = 0;
-
-    if (m < min || n < min)
+    if (hdiff->len != 0)
     {
-        /* XXX early culling */
-        return 0;
-    }
+        BRACKET *last;
 
-    Lprev = g_try_new0 (int, n + 1);
-    if (Lprev == NULL)
-        return -1;
-
-    Lcurr = g_try_new0 (int, n + 1);
-    if (Lcurr == NULL)
-    {
-        g_free (Lprev);
-        return -1;
+        last = &g_array_index (hdiff, BRACKET, hdiff->len - 1);
+        if (off1 - ((*last)[DIFF_LEFT].off + (*last)[DIFF_LEFT].len) < min)
+        {
+            (*last)[DIFF_LEFT].len = off1 + len1 - (*last)[DIFF_LEFT].off;
+            (*last)[DIFF_RIGHT].len = off2 + len2 - (*last)[DIFF_RIGHT].off;
+            return;
+        }
     }
 
-    for (i = 0; i < m; i++)
     {
-        int *L;
-
-        L = Lprev;
-        Lprev = Lcurr;
-        Lcurr = L;
-#ifdef USE_MEMSET_IN_LCS
-        memset (Lcurr, 0, (n + 1) * sizeof (*Lcurr));
-#endif
-        for (j = 0; j < n; j++)
-        {
-#ifndef USE_MEMSET_IN_LCS
-            Lcurr[j + 1] = 0;
-#endif
-            if (s[i] == t[j])
-            {
-                int v;
-
-                v = Lprev[j] + 1;
-                Lcurr[j + 1] = v;
-                if (z < v)
-                {
-                    z = v;
-                    g_array_set_size (ret, 0);
-                }
-                if (z == v && z >= min)
-                {
-                    int off0, off1;
-                    size_t k;
-
-                    off0 = i - z + 1;
-                    off1 = j - z + 1;
-
-                    for (k = 0; k < ret->len; k++)
-                    {
-                        PAIR *p = (PAIR *) g_array_index (ret, PAIR, k);
-                        if ((*p)[0] == off0 || (*p)[1] >= off1)
-                            break;
-                    }
-                    if (k == ret->len)
-                    {
-                        PAIR p2;
+        BRACKET b;
 
-                        p2[0] = off0;
-                        p2[1] = off1;
-                        g_array_append_val (ret, p2);
-                    }
-                }
-            }
-        }
+        b[DIFF_LEFT].off = off1;
+        b[DIFF_LEFT].len = len1;
+        b[DIFF_RIGHT].off = off2;
+        b[DIFF_RIGHT].len = len2;
+        g_array_append_val (hdiff, b);
     }
-
-    g_free (Lcurr);
-    g_free (Lprev);
-    return z;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
 /**
- * Scan recursively for common substrings and build ranges.
+ * Build list of horizontal diff ranges.
+ *
+ * Common prefix and suffix are skipped, the rest is compared character by character
+ * with the diff engine. If comparison takes too long, the rest of line is highlighted
+ * as a single change.
  *
  * @param s first string
+ * @param m length of first string
  * @param t second string
- * @param bracket current limits for both of the strings
+ * @param n length of second string
  * @param min minimum length of common substrings
  * @param hdiff list of horizontal diff ranges to fill
- * @param depth recursion depth
- *
- * @return 0 if success, nonzero otherwise
  */
 
-static gboolean
-hdiff_multi (const char *s, const char *t, const BRACKET bracket, int min, GArray * hdiff,
-             unsigned int depth)
+static void
+hdiff_scan (const char *s, int m, const char *t, int n, int min, GArray * hdiff)
 {
-    BRACKET p;
+    int i, j, k;
+    int *xv, *yv;
+    char *xchg, *ychg;
 
-    if (depth-- != 0)
+    /* dumbscan (single horizontal diff) -- does not compress whitespace */
+    for (i = 0; i < m && i < n && s[i] == t[i]; i++)
+        ;
+    for (; m > i && n > i && s[m - 1] == t[n - 1]; m--, n--)
+        ;
+
+    if (m == i || n == i)
     {
-        GArray *ret;
-        BRACKET b;
-        int len;
+        hdiff_add (hdiff, i, m - i, i, n - i, min);
+        return;
+    }
+
+    /* smartscan (multiple horizontal diff) */
+    xv = g_new (int, m - i);
+    yv = g_new (int, n - i);
+    xchg = g_new0 (char, m - i);
+    ychg = g_new0 (char, n - i);
+
+    for (k = i; k < m; k++)
+        xv[k - i] = (unsigned char) s[k];
+    for (k = i; k < n; k++)
+        yv[k - i] = (unsigned char) t[k];
 
-        ret = g_array_new (FALSE, TRUE, sizeof (PAIR));
-        if (ret == NULL)
-            return FALSE;
+    dff_compare_seq (xv, m - i, yv, n - i, xchg, ychg, 0,
+                     mc_timer_elapsed (mc_global.timer) + HDIFF_TIME_LIMIT);
 
-        len = lcsubstr (s + bracket[DIFF_LEFT].off, bracket[DIFF_LEFT].len,
-                        t + bracket[DIFF_RIGHT].off, bracket[DIFF_RIGHT].len, ret, min);
-        if (ret->len != 0)
+    /* convert changed characters to ranges */
+    m -= i;
+    n -= i;
+    for (j = 0, k = 0; j < m || k < n;)
+    {
+        int j0, k0;
+
+        if (j < m && k < n && xchg[j] == 0 && ychg[k] == 0)
         {
-            size_t k = 0;
-            const PAIR *data = (const PAIR *) &g_array_index (ret, PAIR, 0);
-            const PAIR *data2;
-
-            b[DIFF_LEFT].off = bracket[DIFF_LEFT].off;
-            b[DIFF_LEFT].len = (*data)[0];
-            b[DIFF_RIGHT].off = bracket[DIFF_RIGHT].off;
-            b[DIFF_RIGHT].len = (*data)[1];
-            if (!hdiff_multi (s, t, b, min, hdiff, depth))
-                return FALSE;
-
-            for (k = 0; k < ret->len - 1; k++)
-            {
-                data = (const PAIR *) &g_array_index (ret, PAIR, k);
-                data2 = (const PAIR *) &g_array_index (ret, PAIR, k + 1);
-                b[DIFF_LEFT].off = bracket[DIFF_LEFT].off + (*data)[0] + len;
-                b[DIFF_LEFT].len = (*data2)[0] - (*data)[0] - len;
-                b[DIFF_RIGHT].off = bracket[DIFF_RIGHT].off + (*data)[1] + len;
-                b[DIFF_RIGHT].len = (*data2)[1] - (*data)[1] - len;
-                if (!hdiff_multi (s, t, b, min, hdiff, depth))
-                    return FALSE;
-            }
-            data = (const PAIR *) &g_array_index (ret, PAIR, k);
-            b[DIFF_LEFT].off = bracket[DIFF_LEFT].off + (*data)[0] + len;
-            b[DIFF_LEFT].len = bracket[DIFF_LEFT].len - (*data)[0] - len;
-            b[DIFF_RIGHT].off = bracket[DIFF_RIGHT].off + (*data)[1] + len;
-            b[DIFF_RIGHT].len = bracket[DIFF_RIGHT].len - (*data)[1] - len;
-            if (!hdiff_multi (s, t, b, min, hdiff, depth))
-                return FALSE;
-
-            g_array_free (ret, TRUE);
-            return TRUE;
+            j++;
+            k++;
+            continue;
         }
-    }
 
-    p[DIFF_LEFT].off = bracket[DIFF_LEFT].off;
-    p[DIFF_LEFT].len = bracket[DIFF_LEFT].len;
-    p[DIFF_RIGHT].off = bracket[DIFF_RIGHT].off;
-    p[DIFF_RIGHT].len = bracket[DIFF_RIGHT].len;
-    g_array_append_val (hdiff, p);
+        for (j0 = j; j < m && xchg[j] != 0; j++)
+            ;
+        for (k0 = k; k < n && ychg[k] != 0; k++)
+            ;
+
+        if (j == j0 && k == k0)
+            break;
 
-    return TRUE;
+        hdiff_add (hdiff, i + j0, j - j0, i + k0, k - k0, min);
+    }
+
+    g_free (ychg);
+    g_free (xchg);
+    g_free (yv);
+    g_free (xv);
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
 /**
- * Build list of horizontal diff ranges.
+ * Get list of horizontal diff ranges for line. Ranges are built on first request and kept
+ * in dview->hdiff, so each changed line is compared once.
  *
- * @param s first string
- * @param m length of first string
- * @param t second string
- * @param n length of second string
- * @param min minimum length of common substrings
- * @param hdiff list of horizontal diff ranges to fill
- * @param depth recursion depth
+ * @param dview WDiff widget
+ * @param i line number in dview->a
  *
- * @return 0 if success, nonzero otherwise
+ * @return list of ranges or NULL if the line has no horizontal diff
  */
 
-static gboolean
-hdiff_scan (const char *s, int m, const char *t, int n, int min, GArray * hdiff, unsigned int depth)
+static GArray *
+hdiff_get (WDiff * dview, size_t i)
 {
-    int i;
-    BRACKET b;
+    GArray *h;
+    const DIFFLN *p;
+    const DIFFLN *q;
 
-    /* dumbscan (single horizontal diff) -- does not compress whitespace */
-    for (i = 0; i < m && i < n && s[i] == t[i]; i++)
-        ;
-    for (; m > i && n > i && s[m - 1] == t[n - 1]; m--, n--)
-        ;
+    if (dview->hdiff == NULL || i >= dview->hdiff->len)
+        return NULL;
 
-    b[DIFF_LEFT].off = i;
-    b[DIFF_LEFT].len = m - i;
-    b[DIFF_RIGHT].off = i;
-    b[DIFF_RIGHT].len = n - i;
+    h = (GArray *) g_ptr_array_index (dview->hdiff, i);
+    if (h != NULL)
+        return h;
 
-    /* smartscan (multiple horizontal diff) */
-    return hdiff_multi (s, t, b, min, hdiff, depth);
+    p = &g_array_index (dview->a[DIFF_LEFT], DIFFLN, i);
+    q = &g_array_index (dview->a[DIFF_RIGHT], DIFFLN, i);
+    if (p->line == 0 || q->line == 0 || p->ch != CHG_CH)
+        return NULL;
+
+    h = g_array_new (FALSE, FALSE, sizeof (BRACKET));
+    hdiff_scan (p->p, p->u.len, q->p, q->u.len, HDIFF_MINCTX, h);
+    g_ptr_array_index (dview->hdiff, i) = h;
+
+    return h;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1244,19 +950,22 @@ hdiff_scan (const char *s, int m, const char *t, int n, int min, GArray * hdiff,
 static gboolean
 is_inside (int k, GArray * hdiff, diff_place_t ord)
 {
-    size_t i;
-    BRACKET *b;
+    size_t lo = 0, hi = hdiff->len;
 
-    for (i = 0; i < hdiff->len; i++)
+    /* ranges are sorted and not overlapped */
+    while (lo < hi)
     {
-        int start, end;
+        size_t mid = (lo + hi) / 2;
+        const BRACKET *b = &g_array_index (hdiff, BRACKET, mid);
 
-        b = &g_array_index (hdiff, BRACKET, i);
-        start = (*b)[ord].off;
-        end = start + (*b)[ord].len;
-        if (k >= start && k < end)
+        if (k < (*b)[ord].off)
+            hi = mid;
+        else if (k >= (*b)[ord].off + (*b)[ord].len)
+            lo = mid + 1;
+        else
             return TRUE;
     }
+
     return FALSE;
 }
 
@@ -1736,23 +1445,19 @@ redo_diff (WDiff * dview)
     GArray *ops;
     int ndiff;
     int rv;
-    char extra[256];
+    int flags = 0;
+    diff_place_t ord;
 
-    extra[0] = '\0';
-    if (dview->opt.quality == 2)
-        strcat (extra, " -d");
-    if (dview->opt.quality == 1)
-        strcat (extra, " --speed-large-files");
     if (dview->opt.strip_trailing_cr)
-        strcat (extra, " --strip-trailing-cr");
+        flags |= DFF_STRIP_TRAILING_CR;
     if (dview->opt.ignore_tab_expansion)
-        strcat (extra, " -E");
+        flags |= DFF_IGNORE_TAB_EXPANSION;
     if (dview->opt.ignore_space_change)
-        strcat (extra, " -b");
+        flags |= DFF_IGNORE_SPACE_CHANGE;
     if (dview->opt.ignore_all_space)
-        strcat (extra, " -w");
+        flags |= DFF_IGNORE_ALL_SPACE;
     if (dview->opt.ignore_case)
-        strcat (extra, " -i");
+        flags |= DFF_IGNORE_CASE;
 
     if (dview->dsrc != DATA_SRC_MEM)
     {
@@ -1760,8 +1465,17 @@ redo_diff (WDiff * dview)
         f_reset (f[DIFF_RIGHT]);
     }
 
+    /* files are kept loaded until they can be changed: see dview_redo() */
+    for (ord = DIFF_LEFT; ord < DIFF_COUNT; ord++)
+        if (dview->df[ord] == NULL)
+        {
+            dview->df[ord] = dff_file_load (dview->file[ord]);
+            if (dview->df[ord] == NULL)
+                return -1;
+        }
+
     ops = g_array_new (FALSE, FALSE, sizeof (DIFFCMD));
-    ndiff = dff_execute (dview->args, extra, dview->file[DIFF_LEFT], dview->file[DIFF_RIGHT], ops);
+    ndiff = dff_compute (dview->df, flags, dview->opt.quality, ops);
     if (ndiff < 0)
     {
         if (ops != NULL)
@@ -1792,41 +1506,11 @@ redo_diff (WDiff * dview)
         f_trunc (f[DIFF_RIGHT]);
     }
 
+    /* horizontal diff is built on demand: see hdiff_get() */
     if (dview->dsrc == DATA_SRC_MEM && HDIFF_ENABLE)
     {
         dview->hdiff = g_ptr_array_new ();
-        if (dview->hdiff != NULL)
-        {
-            size_t i;
-
-            for (i = 0; i < dview->a[DIFF_LEFT]->len; i++)
-            {
-                GArray *h = NULL;
-                const DIFFLN *p;
-                const DIFFLN *q;
-
-                p = &g_array_index (dview->a[DIFF_LEFT], DIFFLN, i);
-                q = &g_array_index (dview->a[DIFF_RIGHT], DIFFLN, i);
-                if (p->line && q->line && p->ch == CHG_CH)
-                {
-                    h = g_array_new (FALSE, FALSE, sizeof (BRACKET));
-                    if (h != NULL)
-                    {
-                        gboolean runresult;
-
-                        runresult =
-                            hdiff_scan (p->p, p->u.len, q->p, q->u.len, HDIFF_MINCTX, h,
-                                        HDIFF_DEPTH);
-                        if (!runresult)
-                        {
-                            g_array_free (h, TRUE);
-                            h = NULL;
-                        }
-                    }
-                }
-                g_ptr_array_add (dview->hdiff, h);
-            }
-        }
+        g_ptr_array_set_size (dview->hdiff, dview->a[DIFF_LEFT]->len);
     }
     return ndiff;
 }
@@ -2387,7 +2071,7 @@ dview_diff_options (WDiff * dview)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-dview_init (WDiff * dview, const char *args, const char *file1, const char *file2,
+dview_init (WDiff * dview, const char *file1, const char *file2,
             const char *label1, const char *label2, DSRC dsrc)
 {
     int ndiff;
@@ -2423,7 +2107,6 @@ dview_init (WDiff * dview, const char *args, const char *file1, const char *file
         }
     }
 
-    dview->args = args;
     dview->file[DIFF_LEFT] = file1;
     dview->file[DIFF_RIGHT] = file2;
     dview->label[DIFF_LEFT] = g_strdup (label1);
@@ -2432,6 +2115,8 @@ dview_init (WDiff * dview, const char *args, const char *file1, const char *file
     dview->f[DIFF_RIGHT] = f[1];
     dview->merged[DIFF_LEFT] = FALSE;
     dview->merged[DIFF_RIGHT] = FALSE;
+    dview->df[DIFF_LEFT] = NULL;
+    dview->df[DIFF_RIGHT] = NULL;
     dview->hdiff = NULL;
     dview->dsrc = dsrc;
 #ifdef HAVE_CHARSET
@@ -2512,6 +2197,11 @@ dview_fini (WDiff * dview)
         dview->a[DIFF_RIGHT] = NULL;
     }
 
+    dff_file_free (dview->df[DIFF_LEFT]);
+    dff_file_free (dview->df[DIFF_RIGHT]);
+    dview->df[DIFF_LEFT] = NULL;
+    dview->df[DIFF_RIGHT] = NULL;
+
     g_free (dview->label[DIFF_LEFT]);
     g_free (dview->label[DIFF_RIGHT]);
 }
@@ -2519,7 +2209,7 @@ dview_fini (WDiff * dview)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-dview_display_file (const WDiff * dview, diff_place_t ord, int r, int c, int height, int width)
+dview_display_file (WDiff * dview, diff_place_t ord, int r, int c, int height, int width)
 {
     size_t i, k;
     int j;
@@ -2568,6 +2258,7 @@ dview_display_file (const WDiff * dview, diff_place_t ord, int r, int c, int hei
     {
         int ch, next_ch = 0, col;
         size_t cnt;
+        GArray *h;
 
         p = (DIFFLN *) & g_array_index (dview->a[ord], DIFFLN, i);
         ch = p->ch;
@@ -2593,7 +2284,7 @@ dview_display_file (const WDiff * dview, diff_place_t ord, int r, int c, int hei
             {
                 if (i == (size_t) dview->search.last_found_line)
                     tty_setcolor (MARKED_SELECTED_COLOR);
-                else if (dview->hdiff != NULL && g_ptr_array_index (dview->hdiff, i) != NULL)
+                else if ((h = hdiff_get (dview, i)) != NULL)
                 {
                     char att[BUFSIZ];
 
@@ -2604,8 +2295,7 @@ dview_display_file (const WDiff * dview, diff_place_t ord, int r, int c, int hei
 #endif
                         k = width;
 
-                    cvt_mgeta (p->p, p->u.len, buf, k, skip, tab_size, show_cr,
-                               g_ptr_array_index (dview->hdiff, i), ord, att);
+                    cvt_mgeta (p->p, p->u.len, buf, k, skip, tab_size, show_cr, h, ord, att);
                     tty_gotoyx (r + j, c);
                     col = 0;
 
@@ -2795,6 +2485,13 @@ dview_redo (WDiff * dview)
         dview->display_numbers = calc_nwidth ((const GArray * const *) dview->a);
         dview->new_frame = (old != dview->display_numbers);
     }
+
+    /* files could be changed by editor or merge */
+    dff_file_free (dview->df[DIFF_LEFT]);
+    dff_file_free (dview->df[DIFF_RIGHT]);
+    dview->df[DIFF_LEFT] = NULL;
+    dview->df[DIFF_RIGHT] = NULL;
+
     dview_reread (dview);
 }
 
@@ -3474,7 +3171,7 @@ diff_view (const char *file1, const char *file2, const char *label1, const char
 
     dview_dlg->get_title = dview_get_title;
 
-    error = dview_init (dview, "-a", file1, file2, label1, label2, DATA_SRC_MEM);       /* XXX binary diff? */
+    error = dview_init (dview, file1, file2, label1, label2, DATA_SRC_MEM);
 
     /* Please note that if you add another widget,
      * you have to modify dview_adjust_size to
@@ -3548,7 +3245,7 @@ dview_diff_cmd (const void *f0, const void *f1)
 
             file0 =
                 vfs_path_append_new (panel0->cwd_vpath, selection (panel0)->fname, (char *) NULL);
-            is_dir0 = S_ISDIR (selection (panel0)->st.st_mode);
+            is_dir0 = S_ISDIR (selection (panel0)->st.mode);
             if (is_dir0)
             {
                 message (D_ERROR, MSG_ERROR, _("\"%s\" is a directory"),
@@ -3558,7 +3255,7 @@ dview_diff_cmd (const void *f0, const void *f1)
 
             file1 =
                 vfs_path_append_new (panel1->cwd_vpath, selection (panel1)->fname, (char *) NULL);
-            is_dir1 = S_ISDIR (selection (panel1)->st.st_mode);
+            is_dir1 = S_ISDIR (selection (panel1)->st.mode);
             if (is_dir1)
             {
                 message (D_ERROR, MSG_ERROR, _("\"%s\" is a directory"),
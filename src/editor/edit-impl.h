@@ -54,6 +54,8 @@
 #define COLUMN_OFF      609
 #define DELCHAR_BR      610
 #define BACKSPACE_BR    611
+#define JOURNAL_INSERT  612
+#define JOURNAL_INSERT_AHEAD 613
 #define MARK_1          1000
 #define MARK_2          500000000
 #define MARK_CURS       1000000000
@@ -107,6 +109,15 @@ typedef struct edit_search_options_t
     gboolean all_codepages;
 } edit_search_options_t;
 
+/* piece of text replaced by edit_replace_spans() */
+typedef struct edit_replace_span_t
+{
+    off_t start;                /* offset of the old text */
+    off_t len;                  /* length of the old text */
+    gsize repl_start;           /* offset of the new text in the replacement buffer */
+    gsize repl_len;             /* length of the new text */
+} edit_replace_span_t;
+
 typedef struct edit_stack_type
 {
     long line;
@@ -171,6 +182,7 @@ int edit_delete (WEdit * edit, gboolean byte_delete);
 int edit_backspace (WEdit * edit, gboolean byte_delete);
 void edit_insert (WEdit * edit, int c);
 void edit_insert_over (WEdit * edit);
+void edit_replace_spans (WEdit * edit, const GArray * spans, const char *repl);
 void edit_cursor_move (WEdit * edit, off_t increment);
 void edit_push_undo_action (WEdit * edit, long c);
 void edit_push_redo_action (WEdit * edit, long c);
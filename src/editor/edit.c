@@ -98,6 +98,7 @@ gboolean show_right_margin = FALSE;
 
 char *option_backup_ext = NULL;
 char *option_filesize_threshold = NULL;
+char *option_undo_memory_limit = NULL;
 
 unsigned int edit_stack_iterator = 0;
 edit_stack_type edit_history_moveto[MAX_HISTORY_MOVETO];
@@ -627,6 +628,139 @@ edit_modification (WEdit * edit)
     edit->modified = 1;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save a deleted byte for undo.
+ * The byte goes to the undo journal, the undo stack gets a single code for the whole span.
+ * While undo is running, the redo stack keeps the byte itself as before.
+ *
+ * @param edit editor object
+ * @param c deleted byte
+ * @param ahead TRUE if byte was deleted after cursor, FALSE if before it
+ */
+
+static void
+edit_push_undo_char (WEdit * edit, int c, gboolean ahead)
+{
+    if (edit->undo_stack_disable)
+        edit_push_undo_action (edit, ahead ? c + 256 : c);
+    else
+    {
+        edit_undo_journal_push (&edit->undo_journal, c);
+        edit_push_undo_action (edit, ahead ? JOURNAL_INSERT_AHEAD : JOURNAL_INSERT);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of journal bytes referenced by the undo stack entry
+ *
+ * @param c code of the entry
+ * @param prev code of the previous entry
+ */
+
+static long
+edit_undo_journal_entry_len (long c, long prev)
+{
+    if (c == JOURNAL_INSERT || c == JOURNAL_INSERT_AHEAD)
+        return 1;
+
+    /* run-length counter: the previous entry is repeated -c times including itself */
+    if (c < 0 && (prev == JOURNAL_INSERT || prev == JOURNAL_INSERT_AHEAD))
+        return -c - 1;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push the same undo action several times.
+ * Uses the run-length counter of the undo stack directly instead of pushing one by one.
+ *
+ * @param edit editor object
+ * @param c code of the action
+ * @param count number of pushes
+ */
+
+static void
+edit_push_undo_action_repeat (WEdit * edit, long c, off_t count)
+{
+    while (count > 0)
+    {
+        unsigned long spm1;
+        off_t n;
+
+        edit_push_undo_action (edit, c);
+        if (--count == 0)
+            break;
+
+        edit_push_undo_action (edit, c);
+        count--;
+
+        spm1 = (edit->undo_stack_pointer - 1) & edit->undo_stack_size_mask;
+        if (edit->undo_stack_disable || edit->undo_stack[spm1] >= 0)
+            continue;           /* not compressed: go on one by one */
+
+        n = MIN (count, (off_t) (edit->undo_stack[spm1] + 1000000000L));
+        edit->undo_stack[spm1] -= (long) n;
+        count -= n;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get new offset of text after edit_replace_spans().
+ *
+ * @param spans sorted array of replaced spans
+ * @param offset offset in the old text
+ *
+ * @return offset in the new text
+ */
+
+static off_t
+edit_replace_spans_map_offset (const GArray * spans, off_t offset)
+{
+    off_t delta = 0;
+    guint i;
+
+    for (i = 0; i < spans->len; i++)
+    {
+        const edit_replace_span_t *span = &g_array_index (spans, edit_replace_span_t, i);
+
+        if (offset < span->start)
+            break;
+
+        if (offset < span->start + span->len)
+            return span->start + delta + MIN (offset - span->start, (off_t) span->repl_len);
+
+        delta += (off_t) span->repl_len - span->len;
+    }
+
+    return offset + delta;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the amount of memory the undo journal of each file may use before spilling to disk.
+ */
+
+static gsize
+edit_get_undo_memory_limit (void)
+{
+    static uintmax_t limit = UINTMAX_MAX;
+
+    if (limit == UINTMAX_MAX)
+    {
+        gboolean err = FALSE;
+
+        limit = parse_integer (option_undo_memory_limit, &err);
+        if (err)
+            limit = EDIT_UNDO_JOURNAL_DEFAULT_LIMIT;
+    }
+
+    return (gsize) limit;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* high level cursor movement commands */
 /* --------------------------------------------------------------------------------------------- */
@@ -1173,6 +1307,20 @@ edit_do_undo (WEdit * edit)
         case COLUMN_OFF:
             edit->column_highlight = 0;
             break;
+        case JOURNAL_INSERT:
+        case JOURNAL_INSERT_AHEAD:
+            {
+                int c;
+
+                c = edit_undo_journal_pop (&edit->undo_journal);
+                if (c == -1)
+                    break;
+                if (ac == JOURNAL_INSERT)
+                    edit_insert (edit, c);
+                else
+                    edit_insert_ahead (edit, c);
+            }
+            break;
         default:
             break;
         }
@@ -2131,6 +2279,7 @@ edit_init (WEdit * edit, int y, int x, int lines, int cols, const vfs_path_t * f
     edit->undo_stack_size = START_STACK_SIZE;
     edit->undo_stack_size_mask = START_STACK_SIZE - 1;
     edit->undo_stack = g_malloc0 ((edit->undo_stack_size + 10) * sizeof (long));
+    edit_undo_journal_init (&edit->undo_journal, edit_get_undo_memory_limit ());
 
     edit->redo_stack_size = START_STACK_SIZE;
     edit->redo_stack_size_mask = START_STACK_SIZE - 1;
@@ -2202,6 +2351,8 @@ edit_clean (WEdit * edit)
     edit_buffer_clean (&edit->buffer);
 
     g_free (edit->undo_stack);
+    edit_undo_journal_clean (&edit->undo_journal);
+    edit_word_index_free (edit->word_index);
     g_free (edit->redo_stack);
     vfs_path_free (edit->filename_vpath);
     vfs_path_free (edit->dir_vpath);
@@ -2309,9 +2460,11 @@ edit_set_codeset (WEdit * edit)
  *
  * If the stack long int is 0-255 it represents a normal insert (from a backspace),
  * 256-512 is an insert ahead (from a delete), If it is betwen 600 and 700 it is one
- * of the cursor functions define'd in edit-impl.h. 1000 through 700'000'000 is to
- * set edit->mark1 position. 700'000'000 through 1400'000'000 is to set edit->mark2
- * position.
+ * of the cursor functions define'd in edit-impl.h. Deleted text is normally not stored
+ * in the stack itself: JOURNAL_INSERT and JOURNAL_INSERT_AHEAD take the next byte from
+ * the undo journal (see editundo.c), so a deleted span costs two stack entries at most.
+ * 1000 through 700'000'000 is to set edit->mark1 position. 700'000'000 through
+ * 1400'000'000 is to set edit->mark2 position.
  *
  * The only way the cursor moves or the buffer is changed is through the routines:
  * insert, backspace, insert_ahead, delete, and cursor_move.
@@ -2402,18 +2555,32 @@ edit_push_undo_action (WEdit * edit, long c)
     c = (edit->undo_stack_pointer + 2) & edit->undo_stack_size_mask;
     if ((unsigned long) c == edit->undo_stack_bottom ||
         (((unsigned long) c + 1) & edit->undo_stack_size_mask) == edit->undo_stack_bottom)
+    {
+        long prev = KEY_PRESS;
+        off_t dropped = 0;
+
         do
         {
+            long cur = edit->undo_stack[edit->undo_stack_bottom];
+
+            /* forget the text of the erased actions too */
+            dropped += edit_undo_journal_entry_len (cur, prev);
+            prev = cur;
             edit->undo_stack_bottom = (edit->undo_stack_bottom + 1) & edit->undo_stack_size_mask;
         }
         while (edit->undo_stack[edit->undo_stack_bottom] < KEY_PRESS
                && edit->undo_stack_bottom != edit->undo_stack_pointer);
 
+        if (dropped != 0)
+            edit_undo_journal_drop (&edit->undo_journal, dropped);
+    }
+
     /*If a single key produced enough pushes to wrap all the way round then we would notice that the [undo_stack_bottom] does not contain KEY_PRESS. The stack is then initialised: */
     if (edit->undo_stack_pointer != edit->undo_stack_bottom
         && edit->undo_stack[edit->undo_stack_bottom] < KEY_PRESS)
     {
         edit->undo_stack_bottom = edit->undo_stack_pointer = 0;
+        edit_undo_journal_reset (&edit->undo_journal);
     }
 }
 
@@ -2539,7 +2706,15 @@ edit_insert (WEdit * edit, int c)
     edit->mark2 += (edit->mark2 > edit->buffer.curs1) ? 1 : 0;
     edit->last_get_rule += (edit->last_get_rule > edit->buffer.curs1) ? 1 : 0;
 
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                edit->buffer.curs1, -1);
+
     edit_buffer_insert (&edit->buffer, c);
+
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1 - 1,
+                                edit->buffer.curs1, 1);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -2571,7 +2746,159 @@ edit_insert_ahead (WEdit * edit, int c)
     edit->mark2 += (edit->mark2 >= edit->buffer.curs1) ? 1 : 0;
     edit->last_get_rule += (edit->last_get_rule >= edit->buffer.curs1) ? 1 : 0;
 
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                edit->buffer.curs1, -1);
+
     edit_buffer_insert_ahead (&edit->buffer, c);
+
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                edit->buffer.curs1 + 1, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Replace several pieces of text at once.
+ *
+ * The text between the start of the first span and the end of the last one is streamed
+ * once through the cursor gap. Line counters, bookmarks and markers are updated once
+ * for the whole operation, and the operation is recorded in the undo stack as a single
+ * key press: delete of the old text followed by insert of the new one.
+ * The cursor is left after the last replacement.
+ *
+ * @param edit editor object
+ * @param spans array of edit_replace_span_t sorted by offset, not overlapped
+ * @param repl buffer with the new text of all spans
+ */
+
+void
+edit_replace_spans (WEdit * edit, const GArray * spans, const char *repl)
+{
+    const edit_replace_span_t *first, *last;
+    edit_book_mark_t *bm = NULL;
+    off_t region_start, region_end, pos;
+    off_t new_len = 0;
+    long start_line, old_lines = 0, new_lines = 0;
+    guint i;
+
+    if (spans->len == 0)
+        return;
+
+    first = &g_array_index (spans, edit_replace_span_t, 0);
+    last = &g_array_index (spans, edit_replace_span_t, spans->len - 1);
+    region_start = first->start;
+    region_end = last->start + last->len;
+
+    if (region_end > edit->buffer.size)
+        return;
+
+    edit_push_key_press (edit);
+    if (edit->mark2 != edit->mark1)
+        edit_push_markers (edit);
+
+    edit_cursor_move (edit, region_start - edit->buffer.curs1);
+    start_line = edit->buffer.curs_line;
+
+    /* syntax state before the region is still valid, drop the rest */
+    edit_get_syntax_color (edit, region_start - 1);
+
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, region_start, region_end, -1);
+
+    if (edit->book_mark != NULL)
+    {
+        for (bm = edit->book_mark; bm->prev != NULL; bm = bm->prev)
+            ;
+        while (bm != NULL && bm->line < 0)
+            bm = bm->next;
+    }
+
+    /* old text goes from the right side of the gap to the undo journal,
+       new text goes to the left side of the gap */
+    for (i = 0, pos = region_start; i < spans->len; i++)
+    {
+        const edit_replace_span_t *span = &g_array_index (spans, edit_replace_span_t, i);
+        long span_lines = 0, repl_lines = 0;
+        long s_line;
+        gsize j;
+
+        for (; pos < span->start; pos++)
+        {
+            int c;
+
+            c = edit_buffer_delete (&edit->buffer);
+            edit_undo_journal_push (&edit->undo_journal, c);
+            edit_buffer_insert (&edit->buffer, c);
+            new_len++;
+            if (c == '\n')
+            {
+                old_lines++;
+                new_lines++;
+            }
+        }
+
+        for (; pos < span->start + span->len; pos++)
+        {
+            int c;
+
+            c = edit_buffer_delete (&edit->buffer);
+            edit_undo_journal_push (&edit->undo_journal, c);
+            if (c == '\n')
+                span_lines++;
+        }
+
+        for (j = 0; j < span->repl_len; j++)
+        {
+            edit_buffer_insert (&edit->buffer, repl[span->repl_start + j]);
+            if (repl[span->repl_start + j] == '\n')
+                repl_lines++;
+        }
+
+        new_len += (off_t) span->repl_len;
+
+        /* shift bookmarks: lines inside the span collapse to the lines of the new text */
+        s_line = start_line + old_lines;
+        for (; bm != NULL && bm->line <= s_line + span_lines; bm = bm->next)
+        {
+            if (bm->line <= s_line)
+                bm->line += new_lines - old_lines;
+            else
+                bm->line = s_line + new_lines - old_lines + MIN (bm->line - s_line, repl_lines);
+        }
+
+        old_lines += span_lines;
+        new_lines += repl_lines;
+    }
+
+    for (; bm != NULL; bm = bm->next)
+        bm->line += new_lines - old_lines;
+
+    if (edit->word_index != NULL)
+        edit_word_index_update (edit->word_index, &edit->buffer, region_start,
+                                region_start + new_len, 1);
+
+    edit_push_undo_action_repeat (edit, JOURNAL_INSERT_AHEAD, region_end - region_start);
+    edit_push_undo_action_repeat (edit, BACKSPACE, new_len);
+
+    edit->buffer.lines += new_lines - old_lines;
+    edit->buffer.curs_line += new_lines;
+
+    if (edit->mark1 >= 0)
+        edit->mark1 = edit_replace_spans_map_offset (spans, edit->mark1);
+    if (edit->mark2 >= 0)
+        edit->mark2 = edit_replace_spans_map_offset (spans, edit->mark2);
+    if (edit->end_mark_curs >= 0)
+        edit->end_mark_curs = edit_replace_spans_map_offset (spans, edit->end_mark_curs);
+
+    if (edit->start_display > region_start)
+    {
+        edit->start_display = edit_buffer_get_bol (&edit->buffer, region_start);
+        edit->start_line = start_line;
+    }
+
+    edit_modification (edit);
+    edit->force |= REDRAW_PAGE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -2626,9 +2953,17 @@ edit_delete (WEdit * edit, gboolean byte_delete)
         if (edit->last_get_rule > edit->buffer.curs1)
             edit->last_get_rule--;
 
+        if (edit->word_index != NULL)
+            edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                    edit->buffer.curs1 + 1, -1);
+
         p = edit_buffer_delete (&edit->buffer);
 
-        edit_push_undo_action (edit, p + 256);
+        if (edit->word_index != NULL)
+            edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                    edit->buffer.curs1, 1);
+
+        edit_push_undo_char (edit, p, TRUE);
     }
 
     edit_modification (edit);
@@ -2686,9 +3021,17 @@ edit_backspace (WEdit * edit, gboolean byte_delete)
         if (edit->last_get_rule >= edit->buffer.curs1)
             edit->last_get_rule--;
 
+        if (edit->word_index != NULL)
+            edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1 - 1,
+                                    edit->buffer.curs1, -1);
+
         p = edit_buffer_backspace (&edit->buffer);
 
-        edit_push_undo_action (edit, p);
+        if (edit->word_index != NULL)
+            edit_word_index_update (edit->word_index, &edit->buffer, edit->buffer.curs1,
+                                    edit->buffer.curs1, 1);
+
+        edit_push_undo_char (edit, p, FALSE);
     }
     edit_modification (edit);
     if (p == '\n')
@@ -941,6 +941,81 @@ edit_show_search_error (const WEdit * edit, const char *title)
         edit_query_dialog (title, edit->search->error_str);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Replace the current match and all following ones without asking.
+ * All matches are collected from the unchanged text first, then the text is rebuilt in one pass.
+ *
+ * @param esm search status message
+ * @param replace_tmpl replacement template
+ * @param len length of the current match
+ *
+ * @return number of replacements or -1 on error
+ */
+
+static long
+edit_replace_all (edit_search_status_msg_t * esm, GString * replace_tmpl, gsize len)
+{
+    WEdit *edit = esm->edit;
+    GArray *spans;
+    GString *repl;
+    long n = -1;
+
+    spans = g_array_new (FALSE, FALSE, sizeof (edit_replace_span_t));
+    repl = g_string_sized_new (replace_tmpl->len);
+
+    while (TRUE)
+    {
+        edit_replace_span_t span;
+        GString *repl_str;
+
+        repl_str = mc_search_prepare_replace_str (edit->search, replace_tmpl);
+        if (edit->search->error != MC_SEARCH_E_OK)
+        {
+            edit_show_search_error (edit, _("Replace"));
+            g_string_free (repl_str, TRUE);
+            goto ret;
+        }
+
+        span.start = edit->search_start;
+        span.len = (off_t) len;
+        span.repl_start = repl->len;
+        span.repl_len = repl_str->len;
+        g_string_append_len (repl, repl_str->str, repl_str->len);
+        g_string_free (repl_str, TRUE);
+        g_array_append_val (spans, span);
+
+        /* so that we don't find the same string again */
+        edit->search_start += (off_t) len + (len == 0 ? 1 : 0);
+        if (edit->search_start >= edit->buffer.size)
+            break;
+
+        if (!editcmd_find (esm, &len))
+        {
+            if (edit->search->error != MC_SEARCH_E_OK
+                && edit->search->error != MC_SEARCH_E_NOTFOUND)
+                edit_show_search_error (edit, _("Search"));
+            break;
+        }
+
+        edit->search_start = edit->search->normal_offset;
+        if (edit->search_start < 0 || edit->search_start >= edit->buffer.size)
+            break;
+    }
+
+    edit_replace_spans (edit, spans, repl->str);
+
+    edit->found_len = g_array_index (spans, edit_replace_span_t, spans->len - 1).repl_len;
+    edit->found_start = edit->buffer.curs1 - (off_t) edit->found_len;
+    edit->search_start = edit->buffer.curs1;
+    n = (long) spans->len;
+
+  ret:
+    g_string_free (repl, TRUE);
+    g_array_free (spans, TRUE);
+    return n;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -1202,6 +1277,51 @@ edit_collect_completions_get_current_word (edit_search_status_msg_t * esm, mc_se
     return g_string_free (temp, temp->len == 0);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** collect the possible completions from the word index of entire file */
+
+static gsize
+edit_collect_completions_from_index (WEdit * edit, off_t word_start, gsize word_len,
+                                     const char *current_word, GString ** compl, gsize * num)
+{
+    gsize max_len = 0;
+    gsize i;
+    GString *prefix;
+
+    if (edit->word_index == NULL)
+        edit->word_index = edit_word_index_new (&edit->buffer);
+
+    prefix = g_string_sized_new (word_len);
+    for (i = 0; i < word_len; i++)
+        g_string_append_c (prefix, edit_buffer_get_byte (&edit->buffer, word_start + i));
+
+    *num = edit_word_index_complete (edit->word_index, prefix->str, prefix->len, current_word,
+                                     compl, MAX_WORD_COMPLETIONS);
+
+    for (i = 0; i < *num; i++)
+    {
+        /* note the maximal length needed for the completion dialog */
+        if (compl[i]->len > max_len)
+            max_len = compl[i]->len;
+
+#ifdef HAVE_CHARSET
+        {
+            GString *recoded;
+
+            recoded = str_convert_to_display (compl[i]->str);
+            if (recoded->len != 0)
+                g_string_assign (compl[i], recoded->str);
+
+            g_string_free (recoded, TRUE);
+        }
+#endif
+    }
+
+    g_string_free (prefix, TRUE);
+
+    return max_len;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** collect the possible completions */
 
@@ -1250,8 +1370,13 @@ edit_collect_completions (WEdit * edit, off_t word_start, gsize word_len,
 
     temp = g_string_new ("");
 
+    if (entire_file)
+        max_len =
+            edit_collect_completions_from_index (edit, word_start, word_len, current_word, compl,
+                                                 num);
+
     /* collect max MAX_WORD_COMPLETIONS completions */
-    while (mc_search_run (srch, (void *) &esm, start + 1, last_byte, &len))
+    while (!entire_file && mc_search_run (srch, (void *) &esm, start + 1, last_byte, &len))
     {
         g_string_set_size (temp, 0);
         start = srch->normal_offset;
@@ -2699,6 +2824,16 @@ edit_replace_cmd (WEdit * edit, gboolean again)
                 }
             }
 
+            if (edit->replace_mode == 1 && !edit_search_options.backwards)
+            {
+                long n;
+
+                n = edit_replace_all (&esm, input2_str, len);
+                if (n > 0)
+                    times_replaced += n;
+                break;
+            }
+
             repl_str = mc_search_prepare_replace_str (edit->search, input2_str);
 
             if (edit->search->error != MC_SEARCH_E_OK)
@@ -0,0 +1,314 @@
+/*
+   Editor undo journal.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: editor undo journal.
+ *
+ * The undo stack of WEdit keeps only action codes. The text removed by delete and
+ * backspace is kept here as a plain stack of bytes, one byte per deleted character,
+ * while the undo stack keeps a run-length compressed JOURNAL_INSERT code for the whole span.
+ *
+ * The newest part of the journal lives in memory. When it grows beyond the configured
+ * limit, the oldest half is appended to an unlinked temporary file, and it is read back
+ * in chunks when undo reaches it. When the undo stack wraps and forgets its oldest key
+ * presses, the corresponding oldest bytes are dropped from the head of the journal.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+
+#include "lib/vfs/vfs.h"        /* mc_mkstemps() */
+
+#include "editundo.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* Lower bound of the memory limit, to avoid spilling on each push */
+#define EDIT_UNDO_JOURNAL_MIN_LIMIT (64 * 1024)
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+edit_undo_journal_open_file (edit_undo_journal_t * journal)
+{
+    vfs_path_t *tmp_vpath = NULL;
+
+    if (journal->fd != -1)
+        return TRUE;
+
+    journal->fd = mc_mkstemps (&tmp_vpath, "mcundo", NULL);
+    if (journal->fd == -1)
+        return FALSE;
+
+    /* nobody needs the name: file will be removed automatically on close */
+    unlink (vfs_path_as_str (tmp_vpath));
+    vfs_path_free (tmp_vpath);
+
+    journal->file_head = 0;
+    journal->file_len = 0;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move the oldest half of the in-memory part of the journal to the temporary file.
+ * If the file cannot be created or written, the data is kept in memory.
+ */
+
+static void
+edit_undo_journal_spill (edit_undo_journal_t * journal)
+{
+    const guint8 *p;
+    gsize len, done = 0;
+
+    if (!edit_undo_journal_open_file (journal))
+        return;
+
+    len = journal->mem->len / 2;
+    p = journal->mem->data;
+
+    if (lseek (journal->fd, journal->file_len, SEEK_SET) != journal->file_len)
+        return;
+
+    while (done < len)
+    {
+        ssize_t n;
+
+        n = write (journal->fd, p + done, len - done);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += (gsize) n;
+    }
+
+    if (done == 0)
+        return;
+
+    journal->file_len += (off_t) done;
+    g_byte_array_remove_range (journal->mem, 0, (guint) done);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read the newest chunk of spilled data back into memory. Must be called with empty memory part.
+ */
+
+static gboolean
+edit_undo_journal_unspill (edit_undo_journal_t * journal)
+{
+    off_t chunk;
+    gsize done = 0;
+
+    chunk = MIN ((off_t) (journal->mem_limit / 2), journal->file_len - journal->file_head);
+    if (chunk <= 0)
+        return FALSE;
+
+    if (lseek (journal->fd, journal->file_len - chunk, SEEK_SET) != journal->file_len - chunk)
+        return FALSE;
+
+    g_byte_array_set_size (journal->mem, (guint) chunk);
+
+    while (done < (gsize) chunk)
+    {
+        ssize_t n;
+
+        n = read (journal->fd, journal->mem->data + done, (gsize) chunk - done);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += (gsize) n;
+    }
+
+    if (done != (gsize) chunk)
+    {
+        /* spilled history is lost: forget it completely */
+        g_byte_array_set_size (journal->mem, 0);
+        journal->file_head = journal->file_len = 0;
+        return FALSE;
+    }
+
+    journal->file_len -= chunk;
+    if (journal->file_len == journal->file_head)
+        journal->file_head = journal->file_len = 0;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Initialize the undo journal.
+ *
+ * @param journal pointer to journal
+ * @param mem_limit max amount of bytes kept in memory
+ */
+
+void
+edit_undo_journal_init (edit_undo_journal_t * journal, gsize mem_limit)
+{
+    journal->mem = g_byte_array_new ();
+    journal->mem_limit = MAX (mem_limit, EDIT_UNDO_JOURNAL_MIN_LIMIT);
+    journal->fd = -1;
+    journal->file_head = 0;
+    journal->file_len = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free the undo journal and remove its temporary file.
+ *
+ * @param journal pointer to journal
+ */
+
+void
+edit_undo_journal_clean (edit_undo_journal_t * journal)
+{
+    if (journal->mem != NULL)
+    {
+        g_byte_array_free (journal->mem, TRUE);
+        journal->mem = NULL;
+    }
+
+    if (journal->fd != -1)
+    {
+        close (journal->fd);
+        journal->fd = -1;
+    }
+
+    journal->file_head = 0;
+    journal->file_len = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Put a byte on the top of the journal.
+ *
+ * @param journal pointer to journal
+ * @param c byte to save
+ */
+
+void
+edit_undo_journal_push (edit_undo_journal_t * journal, int c)
+{
+    guint8 b = (guint8) c;
+
+    g_byte_array_append (journal->mem, &b, 1);
+
+    if (journal->mem->len > journal->mem_limit)
+    {
+        edit_undo_journal_spill (journal);
+
+        /* temporary file is not available: don't try to spill on each push */
+        if (journal->mem->len > journal->mem_limit)
+            journal->mem_limit *= 2;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take a byte from the top of the journal.
+ *
+ * @param journal pointer to journal
+ *
+ * @return byte value or -1 if journal is empty
+ */
+
+int
+edit_undo_journal_pop (edit_undo_journal_t * journal)
+{
+    int c;
+
+    if (journal->mem->len == 0 && !edit_undo_journal_unspill (journal))
+        return -1;
+
+    c = journal->mem->data[journal->mem->len - 1];
+    g_byte_array_set_size (journal->mem, journal->mem->len - 1);
+
+    return c;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget the oldest bytes of the journal.
+ *
+ * @param journal pointer to journal
+ * @param count number of bytes to drop
+ */
+
+void
+edit_undo_journal_drop (edit_undo_journal_t * journal, off_t count)
+{
+    off_t n;
+
+    n = MIN (count, journal->file_len - journal->file_head);
+    journal->file_head += n;
+    count -= n;
+
+    if (journal->file_head == journal->file_len)
+        journal->file_head = journal->file_len = 0;
+
+    if (count > 0)
+        g_byte_array_remove_range (journal->mem, 0, (guint) MIN (count, (off_t) journal->mem->len));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget the whole content of the journal.
+ *
+ * @param journal pointer to journal
+ */
+
+void
+edit_undo_journal_reset (edit_undo_journal_t * journal)
+{
+    g_byte_array_set_size (journal->mem, 0);
+    journal->file_head = 0;
+    journal->file_len = 0;
+
+    /* drop spilled data, the file will be recreated on demand */
+    if (journal->fd != -1)
+    {
+        close (journal->fd);
+        journal->fd = -1;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,48 @@
+/** \file
+ *  \brief Header: undo journal for WEdit
+ */
+
+#ifndef MC__EDIT_UNDO_H
+#define MC__EDIT_UNDO_H
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* Default amount of deleted text kept in memory before older history goes to disk */
+#define EDIT_UNDO_JOURNAL_DEFAULT_LIMIT (4 * 1024 * 1024)
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct edit_undo_journal_struct
+{
+    GByteArray *mem;            /* most recent part of the journal */
+    gsize mem_limit;            /* max size of mem before the oldest half is spilled */
+    int fd;                     /* temporary file for spilled history, -1 if not created yet */
+    off_t file_head;            /* offset of the oldest still used byte in the file */
+    off_t file_len;             /* offset of the end of spilled data */
+} edit_undo_journal_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+void edit_undo_journal_init (edit_undo_journal_t * journal, gsize mem_limit);
+void edit_undo_journal_clean (edit_undo_journal_t * journal);
+
+void edit_undo_journal_push (edit_undo_journal_t * journal, int c);
+int edit_undo_journal_pop (edit_undo_journal_t * journal);
+void edit_undo_journal_drop (edit_undo_journal_t * journal, off_t count);
+void edit_undo_journal_reset (edit_undo_journal_t * journal);
+
+/*** inline functions ****************************************************************************/
+
+static inline off_t
+edit_undo_journal_length (const edit_undo_journal_t * journal)
+{
+    return journal->file_len - journal->file_head + (off_t) journal->mem->len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#endif /* MC__EDIT_UNDO_H */
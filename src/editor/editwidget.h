@@ -10,6 +10,8 @@
 
 #include "edit-impl.h"
 #include "editbuffer.h"
+#include "editundo.h"
+#include "editwords.h"
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -140,6 +142,9 @@ struct WEdit
     unsigned long undo_stack_size_mask;
     unsigned long undo_stack_bottom;
     unsigned int undo_stack_disable:1;  /* If not 0, don't save events in the undo stack */
+    edit_undo_journal_t undo_journal;   /* text removed by actions recorded in the undo stack */
+
+    edit_word_index_t *word_index;      /* words for completion, NULL until first used */
 
     unsigned long redo_stack_pointer;
     long *redo_stack;
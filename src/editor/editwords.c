@@ -0,0 +1,377 @@
+/*
+   Editor word index for word completion.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: editor word index for word completion.
+ *
+ * All words of the buffer are kept in a ternary search tree together with the number
+ * of their occurrences. The tree is built once on the first completion request, and then
+ * it is kept up to date by the low level insert and delete functions: before the buffer
+ * is changed, the words touching the changed area are removed from the index, and after
+ * the change the words touching the new text are added again.
+ *
+ * Words have the same definition as in the regular expression used by word completion.
+ * Too long words are not indexed at all, this limits both memory usage and amount of
+ * bytes scanned on each buffer change.
+ */
+
+#include <config.h>
+
+#include <ctype.h>
+#include <string.h>
+
+#include "lib/global.h"
+
+#include "edit-impl.h"
+#include "editwords.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* Words longer than this are not indexed */
+#define EDIT_WORD_MAX_LEN 128
+
+#define NODE(index, n) (&g_array_index ((index)->nodes, edit_word_node_t, (n)))
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    guint32 lo;                 /* subtree of smaller characters at this position */
+    guint32 eq;                 /* subtree of the next position */
+    guint32 hi;                 /* subtree of greater characters at this position */
+    gint32 count;               /* number of occurrences of the word ending here */
+    guchar ch;
+} edit_word_node_t;
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline gboolean
+edit_word_is_char (int c)
+{
+    return (c != '\0' && !isspace (c) && strchr (".=+[](),;:\"'-?/|\\{}*&^%$#@!", c) == NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+edit_word_node_new (edit_word_index_t * index, guchar ch)
+{
+    edit_word_node_t node;
+
+    memset (&node, 0, sizeof (node));
+    node.ch = ch;
+    g_array_append_val (index->nodes, node);
+
+    return index->nodes->len - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the node of the last character of the word.
+ *
+ * @return node number or 0 if not found
+ */
+
+static guint32
+edit_word_index_find (const edit_word_index_t * index, const char *word, gsize len)
+{
+    guint32 n = index->root;
+    gsize i = 0;
+
+    while (n != 0)
+    {
+        const edit_word_node_t *node = NODE (index, n);
+        guchar ch = (guchar) word[i];
+
+        if (ch < node->ch)
+            n = node->lo;
+        else if (ch > node->ch)
+            n = node->hi;
+        else if (++i == len)
+            return n;
+        else
+            n = node->eq;
+    }
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Collect words of subtree in lexical order.
+ *
+ * @return FALSE if the limit is reached
+ */
+
+static gboolean
+edit_word_index_collect (const edit_word_index_t * index, guint32 n, GString * word,
+                         const char *skip, GString ** compl, gsize * num, gsize max)
+{
+    while (n != 0)
+    {
+        const edit_word_node_t *node = NODE (index, n);
+
+        if (node->lo != 0
+            && !edit_word_index_collect (index, node->lo, word, skip, compl, num, max))
+            return FALSE;
+
+        g_string_append_c (word, (char) node->ch);
+
+        if (node->count > 0 && (skip == NULL || strcmp (skip, word->str) != 0))
+        {
+            if (*num == max)
+                return FALSE;
+            compl[(*num)++] = g_string_new_len (word->str, word->len);
+        }
+
+        if (node->eq != 0
+            && !edit_word_index_collect (index, node->eq, word, skip, compl, num, max))
+            return FALSE;
+
+        g_string_truncate (word, word->len - 1);
+
+        /* tail call */
+        n = node->hi;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create word index of the buffer.
+ *
+ * @param buf editor buffer
+ *
+ * @return new word index
+ */
+
+edit_word_index_t *
+edit_word_index_new (const edit_buffer_t * buf)
+{
+    edit_word_index_t *index;
+
+    index = g_new (edit_word_index_t, 1);
+    index->nodes = g_array_new (FALSE, FALSE, sizeof (edit_word_node_t));
+    /* node 0 is reserved as "no node" */
+    edit_word_node_new (index, '\0');
+    index->root = 0;
+
+    edit_word_index_update (index, buf, 0, buf->size, 1);
+
+    return index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+edit_word_index_free (edit_word_index_t * index)
+{
+    if (index != NULL)
+    {
+        g_array_free (index->nodes, TRUE);
+        g_free (index);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change number of occurrences of the word.
+ *
+ * @param index word index
+ * @param word word, not null-terminated
+ * @param len length of word
+ * @param delta value to be added to the counter
+ */
+
+void
+edit_word_index_add (edit_word_index_t * index, const char *word, gsize len, int delta)
+{
+    guint32 n, parent = 0;
+    int dir = 0;
+    gsize i = 0;
+    guchar ch;
+
+    if (len == 0 || len > EDIT_WORD_MAX_LEN)
+        return;
+
+    if (delta < 0)
+    {
+        n = edit_word_index_find (index, word, len);
+        if (n != 0)
+            NODE (index, n)->count = MAX (NODE (index, n)->count + delta, 0);
+        return;
+    }
+
+    for (n = index->root, ch = (guchar) word[0];;)
+    {
+        edit_word_node_t *node;
+
+        if (n == 0)
+        {
+            /* node array may be reallocated here, so link is set via parent number */
+            n = edit_word_node_new (index, ch);
+
+            if (parent == 0)
+                index->root = n;
+            else
+            {
+                node = NODE (index, parent);
+                if (dir < 0)
+                    node->lo = n;
+                else if (dir > 0)
+                    node->hi = n;
+                else
+                    node->eq = n;
+            }
+        }
+
+        node = NODE (index, n);
+        parent = n;
+
+        if (ch < node->ch)
+        {
+            n = node->lo;
+            dir = -1;
+        }
+        else if (ch > node->ch)
+        {
+            n = node->hi;
+            dir = 1;
+        }
+        else if (++i == len)
+        {
+            node->count += delta;
+            return;
+        }
+        else
+        {
+            n = node->eq;
+            dir = 0;
+            ch = (guchar) word[i];
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add or remove words touching the area of the buffer.
+ *
+ * The area is extended to the word boundaries, so this function should be called with
+ * negative delta before the area is changed and with positive delta after that.
+ *
+ * @param index word index
+ * @param buf editor buffer
+ * @param start start of area
+ * @param end end of area (not included)
+ * @param delta 1 to add words, -1 to remove them
+ */
+
+void
+edit_word_index_update (edit_word_index_t * index, const edit_buffer_t * buf, off_t start,
+                        off_t end, int delta)
+{
+    char word[EDIT_WORD_MAX_LEN];
+    gsize len = 0;
+    gboolean too_long = FALSE;
+    off_t i;
+
+    /* extend area to word boundaries, but not farther than max word length:
+       a word cut by this limit is too long anyway */
+    for (i = 0; i <= EDIT_WORD_MAX_LEN && start > 0
+         && edit_word_is_char (edit_buffer_get_byte (buf, start - 1)); i++)
+        start--;
+    for (i = 0; i <= EDIT_WORD_MAX_LEN && end < buf->size
+         && edit_word_is_char (edit_buffer_get_byte (buf, end)); i++)
+        end++;
+
+    for (i = start; i <= end; i++)
+    {
+        int c;
+
+        c = i < end ? edit_buffer_get_byte (buf, i) : ' ';
+
+        if (edit_word_is_char (c))
+        {
+            if (len < EDIT_WORD_MAX_LEN)
+                word[len++] = (char) c;
+            else
+                too_long = TRUE;
+        }
+        else
+        {
+            if (!too_long)
+                edit_word_index_add (index, word, len, delta);
+            len = 0;
+            too_long = FALSE;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find words starting with the prefix in lexical order.
+ *
+ * @param index word index
+ * @param prefix beginning of word
+ * @param prefix_len length of prefix
+ * @param skip word to be excluded from result, may be NULL
+ * @param compl array to store found words
+ * @param max size of compl array
+ *
+ * @return number of found words
+ */
+
+gsize
+edit_word_index_complete (const edit_word_index_t * index, const char *prefix, gsize prefix_len,
+                          const char *skip, GString ** compl, gsize max)
+{
+    GString *word;
+    guint32 n;
+    gsize num = 0;
+
+    if (prefix_len == 0)
+        n = index->root;
+    else
+    {
+        n = edit_word_index_find (index, prefix, prefix_len);
+        if (n == 0)
+            return 0;
+        n = NODE (index, n)->eq;
+    }
+
+    word = g_string_new_len (prefix, prefix_len);
+    edit_word_index_collect (index, n, word, skip, compl, &num, max);
+    g_string_free (word, TRUE);
+
+    return num;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,37 @@
+/** \file
+ *  \brief Header: word index for word completion in WEdit
+ */
+
+#ifndef MC__EDIT_WORDS_H
+#define MC__EDIT_WORDS_H
+
+#include "editbuffer.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct edit_word_index_struct
+{
+    GArray *nodes;              /* ternary search tree, node 0 is not used */
+    guint32 root;
+} edit_word_index_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+edit_word_index_t *edit_word_index_new (const edit_buffer_t * buf);
+void edit_word_index_free (edit_word_index_t * index);
+
+void edit_word_index_add (edit_word_index_t * index, const char *word, gsize len, int delta);
+void edit_word_index_update (edit_word_index_t * index, const edit_buffer_t * buf, off_t start,
+                             off_t end, int delta);
+gsize edit_word_index_complete (const edit_word_index_t * index, const char *prefix,
+                                gsize prefix_len, const char *skip, GString ** compl, gsize max);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__EDIT_WORDS_H */
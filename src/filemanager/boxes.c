@@ -48,6 +48,9 @@
 #include "lib/strutil.h"
 
 #include "lib/vfs/vfs.h"
+#ifdef ENABLE_VFS_NET
+#include "lib/vfs/dircache.h"
+#endif /* ENABLE_VFS_NET */
 #ifdef ENABLE_VFS_FTP
 #include "src/vfs/ftpfs/ftpfs.h"
 #endif /* ENABLE_VFS_FTP */
@@ -676,6 +679,7 @@ panel_options_box (void)
                 QUICK_START_GROUPBOX (N_("Quick search")),
                     QUICK_RADIO (QSEARCH_NUM, qsearch_options, (int *) &panels_options.qsearch_mode,
                                  NULL),
+                    QUICK_CHECKBOX (N_("Fuzzy m&atch"), &panels_options.qsearch_fuzzy, NULL),
                 QUICK_STOP_GROUPBOX,
             QUICK_STOP_COLUMNS,
             QUICK_BUTTONS_OK_CANCEL,
@@ -1063,6 +1067,9 @@ void
 configure_vfs (void)
 {
     char buffer2[BUF_TINY];
+#ifdef ENABLE_VFS_NET
+    char buffer4[BUF_TINY];
+#endif
 #ifdef ENABLE_VFS_FTP
     char buffer3[BUF_TINY];
 
@@ -1070,9 +1077,15 @@ configure_vfs (void)
 #endif
 
     g_snprintf (buffer2, sizeof (buffer2), "%i", vfs_timeout);
+#ifdef ENABLE_VFS_NET
+    g_snprintf (buffer4, sizeof (buffer4), "%i", vfs_dircache_max_age);
+#endif
 
     {
         char *ret_timeout;
+#ifdef ENABLE_VFS_NET
+        char *ret_dircache_max_age;
+#endif
 #ifdef ENABLE_VFS_FTP
         char *ret_passwd;
         char *ret_ftp_proxy;
@@ -1084,6 +1097,11 @@ configure_vfs (void)
             QUICK_LABELED_INPUT (N_("Timeout for freeing VFSs (sec):"), input_label_left,
                                  buffer2, "input-timo-vfs", &ret_timeout, NULL, FALSE, FALSE,
                                  INPUT_COMPLETE_NONE),
+#ifdef ENABLE_VFS_NET
+            QUICK_LABELED_INPUT (N_("Saved directory listings max age (sec):"),
+                                 input_label_left, buffer4, "input-dircache-age",
+                                 &ret_dircache_max_age, NULL, FALSE, FALSE, INPUT_COMPLETE_NONE),
+#endif
 #ifdef ENABLE_VFS_FTP
             QUICK_SEPARATOR (TRUE),
             QUICK_LABELED_INPUT (N_("FTP anonymous password:"), input_label_left,
@@ -1120,7 +1138,7 @@ configure_vfs (void)
 
 #ifdef ENABLE_VFS_FTP
         if (!ftpfs_always_use_proxy)
-            quick_widgets[5].state = WST_DISABLED;
+            quick_widgets[6].state = WST_DISABLED;
 #endif
 
         if (quick_dialog (&qdlg) != B_CANCEL)
@@ -1131,6 +1149,14 @@ configure_vfs (void)
 
             if (vfs_timeout < 0 || vfs_timeout > 10000)
                 vfs_timeout = 10;
+#ifdef ENABLE_VFS_NET
+            /* cppcheck-suppress uninitvar */
+            vfs_dircache_max_age = atoi (ret_dircache_max_age);
+            g_free (ret_dircache_max_age);
+
+            if (vfs_dircache_max_age < 0)
+                vfs_dircache_max_age = 0;
+#endif
 #ifdef ENABLE_VFS_FTP
             g_free (ftpfs_anonymous_passwd);
             /* cppcheck-suppress uninitvar */
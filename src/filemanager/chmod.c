@@ -459,9 +459,13 @@ static void
 apply_mask (vfs_path_t * vpath, struct stat *sf)
 {
     gboolean ok;
+    int failed;
+
+    /* network filesystems may send chmod's of all marked files in batches */
+    mc_setctl (current_panel->cwd_vpath, VFS_SETCTL_BATCH, GUINT_TO_POINTER (1));
 
     if (!do_chmod (vpath, sf))
-        return;
+        goto done;
 
     do
     {
@@ -490,6 +494,12 @@ apply_mask (vfs_path_t * vpath, struct stat *sf)
         vfs_path_free (vpath);
     }
     while (ok && current_panel->marked != 0);
+
+  done:
+    failed = mc_setctl (current_panel->cwd_vpath, VFS_SETCTL_BATCH, NULL);
+    if (failed > 0)
+        message (D_ERROR, MSG_ERROR,
+                 ngettext ("Cannot chmod %d file", "Cannot chmod %d files", failed), failed);
 }
 
 /* --------------------------------------------------------------------------------------------- */
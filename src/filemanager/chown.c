@@ -355,9 +355,13 @@ static void
 apply_chowns (vfs_path_t * vpath, uid_t u, gid_t g)
 {
     gboolean ok;
+    int failed;
+
+    /* network filesystems may send chown's of all marked files in batches */
+    mc_setctl (current_panel->cwd_vpath, VFS_SETCTL_BATCH, GUINT_TO_POINTER (1));
 
     if (!do_chown (vpath, u, g))
-        return;
+        goto done;
 
     do
     {
@@ -383,6 +387,12 @@ apply_chowns (vfs_path_t * vpath, uid_t u, gid_t g)
         vfs_path_free (vpath);
     }
     while (ok && current_panel->marked != 0);
+
+  done:
+    failed = mc_setctl (current_panel->cwd_vpath, VFS_SETCTL_BATCH, NULL);
+    if (failed > 0)
+        message (D_ERROR, MSG_ERROR,
+                 ngettext ("Cannot chown %d file", "Cannot chown %d files", failed), failed);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -129,7 +129,7 @@ static void
 do_view_cmd (gboolean normal)
 {
     /* Directories are viewed by changing to them */
-    if (S_ISDIR (selection (current_panel)->st.st_mode) || link_isdir (selection (current_panel)))
+    if (S_ISDIR (selection (current_panel)->st.mode) || link_isdir (selection (current_panel)))
     {
         vfs_path_t *fname_vpath;
 
@@ -285,7 +285,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
         file_mark (panel, i, 0);
 
         /* Skip directories */
-        if (S_ISDIR (source->st.st_mode))
+        if (S_ISDIR (source->st.mode))
             continue;
 
         /* Search the corresponding entry from the other panel */
@@ -305,12 +305,12 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
             if (mode != compare_size_only)
             {
                 /* Older version is not marked */
-                if (source->st.st_mtime < target->st.st_mtime)
+                if (source->st.mtime < target->st.mtime)
                     continue;
             }
 
             /* Newer version with different size is marked */
-            if (source->st.st_size != target->st.st_size)
+            if (source->st.size != target->st.size)
             {
                 do_file_mark (panel, i, 1);
                 continue;
@@ -323,7 +323,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
             {
                 /* Thorough compare off, compare only time stamps */
                 /* Mark newer version, don't mark version with the same date */
-                if (source->st.st_mtime > target->st.st_mtime)
+                if (source->st.mtime > target->st.mtime)
                 {
                     do_file_mark (panel, i, 1);
                 }
@@ -336,7 +336,7 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
 
                 src_name = vfs_path_append_new (panel->cwd_vpath, source->fname, (char *) NULL);
                 dst_name = vfs_path_append_new (other->cwd_vpath, target->fname, (char *) NULL);
-                if (compare_files (src_name, dst_name, source->st.st_size))
+                if (compare_files (src_name, dst_name, source->st.size))
                     do_file_mark (panel, i, 1);
                 vfs_path_free (src_name);
                 vfs_path_free (dst_name);
@@ -1247,7 +1247,7 @@ edit_symlink_cmd (void)
     fe = selection (current_panel);
     p = fe->fname;
 
-    if (!S_ISLNK (fe->st.st_mode))
+    if (!S_ISLNK (fe->st.mode))
         message (D_ERROR, MSG_ERROR, _("'%s' is not a symbolic link"), p);
     else
     {
@@ -1416,7 +1416,7 @@ smart_dirsize_cmd (void)
     file_entry_t *entry;
 
     entry = &(panel->dir.list[panel->selected]);
-    if ((S_ISDIR (entry->st.st_mode) && DIR_IS_DOTDOT (entry->fname)) || panel->dirs_marked)
+    if ((S_ISDIR (entry->st.mode) && DIR_IS_DOTDOT (entry->fname)) || panel->dirs_marked)
         dirsizes_cmd ();
     else
         single_dirsize_cmd ();
@@ -1431,7 +1431,7 @@ single_dirsize_cmd (void)
     file_entry_t *entry;
 
     entry = &(panel->dir.list[panel->selected]);
-    if (S_ISDIR (entry->st.st_mode) && !DIR_IS_DOTDOT (entry->fname))
+    if (S_ISDIR (entry->st.mode) && !DIR_IS_DOTDOT (entry->fname))
     {
         size_t dir_count = 0;
         size_t count = 0;
@@ -1447,7 +1447,7 @@ single_dirsize_cmd (void)
 
         if (compute_dir_size (p, &dsm, &dir_count, &count, &total, TRUE) == FILE_CONT)
         {
-            entry->st.st_size = (off_t) total;
+            entry->st.size = (off_t) total;
             entry->f.dir_size_computed = 1;
         }
 
@@ -1481,7 +1481,7 @@ dirsizes_cmd (void)
                      dirsize_status_update_cb, dirsize_status_deinit_cb);
 
     for (i = 0; i < panel->dir.len; i++)
-        if (S_ISDIR (panel->dir.list[i].st.st_mode)
+        if (S_ISDIR (panel->dir.list[i].st.mode)
             && ((panel->dirs_marked && panel->dir.list[i].f.marked)
                 || !panel->dirs_marked) && !DIR_IS_DOTDOT (panel->dir.list[i].fname))
         {
@@ -1497,7 +1497,7 @@ dirsizes_cmd (void)
             if (ok)
                 break;
 
-            panel->dir.list[i].st.st_size = (off_t) total;
+            panel->dir.list[i].st.size = (off_t) total;
             panel->dir.list[i].f.dir_size_computed = 1;
         }
 
@@ -55,10 +55,13 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+/* runs of this length are sorted by insertion before merging */
+#define DIR_SORT_RUN_LEN 16
+
 #define MY_ISDIR(x) (\
-    (is_exe (x->st.st_mode) && !(S_ISDIR (x->st.st_mode) || link_isdir (x)) && exec_first) \
+    (is_exe (x->st.mode) && !(S_ISDIR (x->st.mode) || link_isdir (x)) && exec_first) \
         ? 1 \
-        : ( (S_ISDIR (x->st.st_mode) || link_isdir (x)) ? 2 : 0) )
+        : ( (S_ISDIR (x->st.mode) || link_isdir (x)) ? 2 : 0) )
 
 /*** file scope type declarations ****************************************************************/
 
@@ -73,7 +76,7 @@ static gboolean case_sensitive = OS_SORT_CASE_SENSITIVE_DEFAULT;
 /* Are the exec_bit files top in list */
 static gboolean exec_first = TRUE;
 
-static dir_list dir_copy = { NULL, 0, 0 };
+static dir_list dir_copy = { NULL, 0, 0, FALSE, NULL };
 
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -120,7 +123,8 @@ key_collate (const char *t1, const char *t2)
 
 /* --------------------------------------------------------------------------------------------- */
 /**
- * clear keys, should be call after sorting is finished.
+ * Release sort keys. Keys are kept between sorts and must be released
+ * with the case sensitivity they were created with.
  */
 
 static void
@@ -133,19 +137,123 @@ clean_sort_keys (dir_list * list, int start, int count)
         file_entry_t *fentry;
 
         fentry = &list->list[i + start];
-        str_release_key (fentry->sort_key, case_sensitive);
+        str_release_key (fentry->sort_key, list->keys_case_sensitive);
         fentry->sort_key = NULL;
-        str_release_key (fentry->second_sort_key, case_sensitive);
+        str_release_key (fentry->second_sort_key, list->keys_case_sensitive);
         fentry->second_sort_key = NULL;
     }
 }
 
 /* --------------------------------------------------------------------------------------------- */
 /**
- * If you change handle_dirent then check also handle_path.
- * @return FALSE = don't add, TRUE = add to the list
+ * Move sort key from one entry to another entry with the same file name.
+ * Key may point into the file name itself, such key is moved to the name of new entry.
+ */
+
+static char *
+move_sort_key (char *key, const file_entry_t * from, const file_entry_t * to)
+{
+    if (key != NULL && key >= from->fname && key <= from->fname + from->fnamelen)
+        key = to->fname + (key - from->fname);
+
+    return key;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stable bottom-up merge sort of the index array.
+ * Merge of two runs is skipped if they are already in order, so resorting of sorted list
+ * costs one comparison per run.
+ *
+ * @param base first entry to sort
+ * @param idx index array to sort
+ * @param tmp temporary array of the same size
+ * @param n number of entries
+ * @param sort compare function
+ */
+
+static void
+dir_list_sort_index (file_entry_t * base, int *idx, int *tmp, int n, GCompareFunc sort)
+{
+    int lo, width;
+
+    for (lo = 0; lo < n; lo += DIR_SORT_RUN_LEN)
+    {
+        int hi, i;
+
+        hi = MIN (lo + DIR_SORT_RUN_LEN, n);
+
+        for (i = lo + 1; i < hi; i++)
+        {
+            int v, j;
+
+            v = idx[i];
+            for (j = i; j > lo && sort (&base[idx[j - 1]], &base[v]) > 0; j--)
+                idx[j] = idx[j - 1];
+            idx[j] = v;
+        }
+    }
+
+    for (width = DIR_SORT_RUN_LEN; width < n; width *= 2)
+        for (lo = 0; lo < n - width; lo += 2 * width)
+        {
+            int mid, hi, i, j, k, nl;
+
+            mid = lo + width;
+            hi = MIN (lo + 2 * width, n);
+
+            if (sort (&base[idx[mid - 1]], &base[idx[mid]]) <= 0)
+                continue;
+
+            nl = mid - lo;
+            memcpy (tmp, idx + lo, nl * sizeof (int));
+
+            for (i = 0, j = mid, k = lo; i < nl && j < hi; k++)
+                if (sort (&base[idx[j]], &base[tmp[i]]) < 0)
+                    idx[k] = idx[j++];
+                else
+                    idx[k] = tmp[i++];
+
+            memcpy (idx + k, tmp + i, (nl - i) * sizeof (int));
+        }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move entries to the sorted order by following the cycles of permutation,
+ * so each entry is moved once.
+ *
+ * @param base first entry
+ * @param idx sorted index array, destroyed on return
+ * @param n number of entries
  */
 
+static void
+dir_list_permute (file_entry_t * base, int *idx, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (idx[i] != i)
+        {
+            file_entry_t fentry;
+            int j, k;
+
+            fentry = base[i];
+
+            for (j = i; (k = idx[j]) != i; j = k)
+            {
+                base[j] = base[k];
+                idx[j] = j;
+            }
+
+            base[j] = fentry;
+            idx[j] = j;
+        }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static gboolean
 handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, int *link_to_dir,
                int *stale_link)
@@ -293,26 +401,49 @@ dir_list_append (dir_list * list, const char *fname, const struct stat * st,
 {
     file_entry_t *fentry;
 
-    /* Need to grow the *list? */
-    if (list->len == list->size && !dir_list_grow (list, DIR_LIST_RESIZE_STEP))
+    /* Need to grow the *list? Grow geometrically to keep appending to huge lists linear */
+    if (list->len == list->size
+        && !dir_list_grow (list, MAX (DIR_LIST_RESIZE_STEP, list->size / 2)))
         return FALSE;
 
     fentry = &list->list[list->len];
     fentry->fnamelen = strlen (fname);
-    fentry->fname = g_strndup (fname, fentry->fnamelen);
+    fentry->fname = dir_list_name_dup (list, fname, fentry->fnamelen);
     fentry->f.marked = 0;
     fentry->f.link_to_dir = link_to_dir ? 1 : 0;
     fentry->f.stale_link = stale_link ? 1 : 0;
     fentry->f.dir_size_computed = 0;
-    fentry->st = *st;
+    file_stat_from_stat (&fentry->st, st);
     fentry->sort_key = NULL;
     fentry->second_sort_key = NULL;
+    fentry->color_generation = 0;
 
     list->len++;
 
     return TRUE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy file name to the name storage of the directory list. Names are not freed one by one,
+ * the storage is released by dir_list_clean() and dir_list_free_list().
+ *
+ * @param list directory list
+ * @param fname file name
+ * @param len length of file name
+ *
+ * @return copy of file name
+ */
+
+char *
+dir_list_name_dup (dir_list * list, const char *fname, size_t len)
+{
+    if (list->names == NULL)
+        list->names = g_string_chunk_new (DIR_LIST_NAMES_CHUNK_SIZE);
+
+    return g_string_chunk_insert_len (list->names, fname, (gssize) len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 int
@@ -333,7 +464,7 @@ sort_name (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        /* create key if does not exist, key will be freed after sorting */
+        /* create key if does not exist, key is kept until entry is freed */
         if (a->sort_key == NULL)
             a->sort_key = str_create_key_for_filename (a->fname, case_sensitive);
         if (b->sort_key == NULL)
@@ -399,7 +530,7 @@ sort_time (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_mtime < b->st.st_mtime ? -1 : a->st.st_mtime > b->st.st_mtime;
+        int result = a->st.mtime < b->st.mtime ? -1 : a->st.mtime > b->st.mtime;
         if (result != 0)
             return result * reverse;
         else
@@ -419,7 +550,7 @@ sort_ctime (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_ctime < b->st.st_ctime ? -1 : a->st.st_ctime > b->st.st_ctime;
+        int result = a->st.ctime < b->st.ctime ? -1 : a->st.ctime > b->st.ctime;
         if (result != 0)
             return result * reverse;
         else
@@ -439,7 +570,7 @@ sort_atime (file_entry_t * a, file_entry_t * b)
 
     if (ad == bd || panels_options.mix_all_files)
     {
-        int result = a->st.st_atime < b->st.st_atime ? -1 : a->st.st_atime > b->st.st_atime;
+        int result = a->st.atime < b->st.atime ? -1 : a->st.atime > b->st.atime;
         if (result != 0)
             return result * reverse;
         else
@@ -458,7 +589,7 @@ sort_inode (file_entry_t * a, file_entry_t * b)
     int bd = MY_ISDIR (b);
 
     if (ad == bd || panels_options.mix_all_files)
-        return (a->st.st_ino - b->st.st_ino) * reverse;
+        return (a->st.ino - b->st.ino) * reverse;
     else
         return bd - ad;
 }
@@ -475,7 +606,7 @@ sort_size (file_entry_t * a, file_entry_t * b)
     if (ad != bd && !panels_options.mix_all_files)
         return bd - ad;
 
-    result = a->st.st_size < b->st.st_size ? -1 : a->st.st_size > b->st.st_size;
+    result = a->st.size < b->st.size ? -1 : a->st.size > b->st.size;
     if (result != 0)
         return result * reverse;
     else
@@ -489,6 +620,8 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
 {
     file_entry_t *fentry;
     int dot_dot_found = 0;
+    int *idx, *tmp;
+    int i, n;
 
     if (list->len < 2 || sort == (GCompareFunc) unsorted)
         return;
@@ -502,9 +635,48 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
     reverse = sort_op->reverse ? -1 : 1;
     case_sensitive = sort_op->case_sensitive ? 1 : 0;
     exec_first = sort_op->exec_first;
-    qsort (&(list->list)[dot_dot_found], list->len - dot_dot_found, sizeof (file_entry_t), sort);
 
-    clean_sort_keys (list, dot_dot_found, list->len - dot_dot_found);
+    /* keys don't depend on other sort options */
+    if (list->keys_case_sensitive != case_sensitive)
+    {
+        clean_sort_keys (list, 0, list->len);
+        list->keys_case_sensitive = case_sensitive;
+    }
+
+    n = list->len - dot_dot_found;
+    fentry = &list->list[dot_dot_found];
+
+    idx = g_new (int, n);
+    tmp = g_new (int, n);
+
+    for (i = 0; i < n; i++)
+        idx[i] = i;
+
+    dir_list_sort_index (fentry, idx, tmp, n, sort);
+    dir_list_permute (fentry, idx, n);
+
+    g_free (tmp);
+    g_free (idx);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free sort keys of the directory list entry. File name is kept in the name storage
+ * of the list until the list is cleaned.
+ *
+ * @param list directory list the entry belongs to
+ * @param fentry entry to be freed
+ */
+
+void
+dir_list_free_entry (const dir_list * list, file_entry_t * fentry)
+{
+    /* key may point to the file name itself, so release keys first */
+    str_release_key (fentry->sort_key, list->keys_case_sensitive);
+    fentry->sort_key = NULL;
+    str_release_key (fentry->second_sort_key, list->keys_case_sensitive);
+    fentry->second_sort_key = NULL;
+    fentry->fname = NULL;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -519,9 +691,12 @@ dir_list_clean (dir_list * list)
         file_entry_t *fentry;
 
         fentry = &list->list[i];
-        MC_PTR_FREE (fentry->fname);
+        dir_list_free_entry (list, fentry);
     }
 
+    if (list->names != NULL)
+        g_string_chunk_clear (list->names);
+
     list->len = 0;
     /* reduce memory usage */
     dir_list_grow (list, DIR_LIST_MIN_SIZE - list->size);
@@ -539,7 +714,13 @@ dir_list_free_list (dir_list * list)
         file_entry_t *fentry;
 
         fentry = &list->list[i];
-        g_free (fentry->fname);
+        dir_list_free_entry (list, fentry);
+    }
+
+    if (list->names != NULL)
+    {
+        g_string_chunk_free (list->names);
+        list->names = NULL;
     }
 
     MC_PTR_FREE (list->list);
@@ -565,12 +746,12 @@ dir_list_init (dir_list * list)
     fentry = &list->list[0];
     memset (fentry, 0, sizeof (*fentry));
     fentry->fnamelen = 2;
-    fentry->fname = g_strndup ("..", fentry->fnamelen);
+    fentry->fname = dir_list_name_dup (list, "..", fentry->fnamelen);
     fentry->f.link_to_dir = 0;
     fentry->f.stale_link = 0;
     fentry->f.dir_size_computed = 0;
     fentry->f.marked = 0;
-    fentry->st.st_mode = 040755;
+    fentry->st.mode = 040755;
     list->len = 1;
     return TRUE;
 }
@@ -639,7 +820,7 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
 
     fentry = &list->list[0];
     if (dir_get_dotdot_stat (vpath, &st))
-        fentry->st = st;
+        file_stat_from_stat (&fentry->st, &st);
 
     dirp = mc_opendir (vpath);
     if (dirp == NULL)
@@ -682,7 +863,7 @@ if_link_is_exe (const vfs_path_t * full_name_vpath, const file_entry_t * file)
 {
     struct stat b;
 
-    if (S_ISLNK (file->st.st_mode) && mc_stat (full_name_vpath, &b) == 0)
+    if (S_ISLNK (file->st.mode) && mc_stat (full_name_vpath, &b) == 0)
         return is_exe (b.st_mode);
     return TRUE;
 }
@@ -699,7 +880,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     int i, link_to_dir, stale_link;
     struct stat st;
     int marked_cnt;
-    GHashTable *marked_files;
+    GHashTable *old_files;
     const char *tmp_path;
 
     dirp = mc_opendir (vpath);
@@ -713,8 +894,15 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
 
     tree_store_start_check (vpath);
 
-    marked_files = g_hash_table_new (g_str_hash, g_str_equal);
+    old_files = g_hash_table_new (g_str_hash, g_str_equal);
     alloc_dir_copy (list->len);
+    /* Entries and the name storage are moved to the copy: sort keys of files
+       which are still in the directory will be moved back. */
+    dir_copy.keys_case_sensitive = list->keys_case_sensitive;
+    if (dir_copy.names != NULL)
+        g_string_chunk_free (dir_copy.names);
+    dir_copy.names = list->names;
+    list->names = NULL;
     for (marked_cnt = i = 0; i < list->len; i++)
     {
         file_entry_t *fentry, *dfentry;
@@ -722,19 +910,14 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
         fentry = &list->list[i];
         dfentry = &dir_copy.list[i];
 
-        dfentry->fnamelen = fentry->fnamelen;
-        dfentry->fname = g_strndup (fentry->fname, fentry->fnamelen);
-        dfentry->f.marked = fentry->f.marked;
-        dfentry->f.dir_size_computed = fentry->f.dir_size_computed;
-        dfentry->f.link_to_dir = fentry->f.link_to_dir;
-        dfentry->f.stale_link = fentry->f.stale_link;
-        dfentry->sort_key = NULL;
-        dfentry->second_sort_key = NULL;
-        if (fentry->f.marked)
-        {
-            g_hash_table_insert (marked_files, dfentry->fname, dfentry);
+        *dfentry = *fentry;
+        fentry->fname = NULL;
+        fentry->sort_key = NULL;
+        fentry->second_sort_key = NULL;
+
+        g_hash_table_insert (old_files, dfentry->fname, dfentry);
+        if (dfentry->f.marked)
             marked_cnt++;
-        }
     }
 
     /* save len for later dir_list_clean() */
@@ -753,6 +936,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
         dir_list_clean (list);
         if (!dir_list_init (list))
         {
+            g_hash_table_destroy (old_files);
             dir_list_free_list (&dir_copy);
             return;
         }
@@ -762,13 +946,13 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
             file_entry_t *fentry;
 
             fentry = &list->list[0];
-            fentry->st = st;
+            file_stat_from_stat (&fentry->st, &st);
         }
     }
 
     while ((dp = mc_readdir (dirp)) != NULL)
     {
-        file_entry_t *fentry;
+        file_entry_t *fentry, *dfentry;
 
         if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
             continue;
@@ -787,22 +971,28 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                dir_list_clean (&dir_copy);
              */
             tree_store_end_check ();
-            g_hash_table_destroy (marked_files);
+            g_hash_table_destroy (old_files);
             return;
         }
         fentry = &list->list[list->len - 1];
 
         fentry->f.marked = 0;
 
-        /*
-         * If we have marked files in the copy, scan through the copy
-         * to find matching file.  Decrease number of remaining marks if
-         * we copied one.
-         */
-        if (marked_cnt > 0 && g_hash_table_lookup (marked_files, dp->d_name) != NULL)
+        dfentry = (file_entry_t *) g_hash_table_lookup (old_files, dp->d_name);
+        if (dfentry != NULL)
         {
-            fentry->f.marked = 1;
-            marked_cnt--;
+            /* Decrease number of remaining marks if we copied one. */
+            if (marked_cnt > 0 && dfentry->f.marked)
+            {
+                fentry->f.marked = 1;
+                marked_cnt--;
+            }
+
+            /* Reuse sort keys */
+            fentry->sort_key = move_sort_key (dfentry->sort_key, dfentry, fentry);
+            fentry->second_sort_key = move_sort_key (dfentry->second_sort_key, dfentry, fentry);
+            dfentry->sort_key = NULL;
+            dfentry->second_sort_key = NULL;
         }
 
         if ((list->len & 15) == 0)
@@ -810,7 +1000,7 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     }
     mc_closedir (dirp);
     tree_store_end_check ();
-    g_hash_table_destroy (marked_files);
+    g_hash_table_destroy (old_files);
 
     dir_list_sort (list, sort, sort_op);
 
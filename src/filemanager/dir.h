@@ -15,6 +15,8 @@
 
 #define DIR_LIST_MIN_SIZE 128
 #define DIR_LIST_RESIZE_STEP 128
+/* size of blocks of file name storage */
+#define DIR_LIST_NAMES_CHUNK_SIZE 4096
 
 /*** enums ***************************************************************************************/
 
@@ -28,6 +30,8 @@ typedef struct
     file_entry_t *list; /**< list of file_entry_t objects */
     int size;           /**< number of allocated elements in list (capacity) */
     int len;            /**< number of used elements in list */
+    gboolean keys_case_sensitive; /**< case sensitivity of cached sort keys */
+    GStringChunk *names; /**< storage of file names, names are freed all together */
 } dir_list;
 
 /**
@@ -47,6 +51,7 @@ typedef struct dir_sort_options_struct
 gboolean dir_list_grow (dir_list * list, int delta);
 gboolean dir_list_append (dir_list * list, const char *fname, const struct stat *st,
                           gboolean link_to_dir, gboolean stale_link);
+char *dir_list_name_dup (dir_list * list, const char *fname, size_t len);
 
 void dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
                     const dir_sort_options_t * sort_op, const char *fltr);
@@ -54,6 +59,7 @@ void dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc so
                       const dir_sort_options_t * sort_op, const char *fltr);
 void dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * sort_op);
 gboolean dir_list_init (dir_list * list);
+void dir_list_free_entry (const dir_list * list, file_entry_t * fentry);
 void dir_list_clean (dir_list * list);
 void dir_list_free_list (dir_list * list);
 gboolean handle_path (const char *path, struct stat *buf1, int *link_to_dir, int *stale_link);
@@ -707,14 +707,14 @@ panel_compute_totals (const WPanel * panel, dirsize_status_msg_t * sm, size_t *
 
     for (i = 0; i < panel->dir.len; i++)
     {
-        struct stat *s;
+        const file_stat_t *s;
 
         if (!panel->dir.list[i].f.marked)
             continue;
 
         s = &panel->dir.list[i].st;
 
-        if (S_ISDIR (s->st_mode))
+        if (S_ISDIR (s->mode))
         {
             vfs_path_t *p;
             FileProgressStatus status;
@@ -729,7 +729,7 @@ panel_compute_totals (const WPanel * panel, dirsize_status_msg_t * sm, size_t *
         else
         {
             (*ret_count)++;
-            *ret_total += (uintmax_t) s->st_size;
+            *ret_total += (uintmax_t) s->size;
         }
     }
 
@@ -1214,7 +1214,7 @@ move_file_file (const WPanel * panel, file_op_total_context_t * tctx, file_op_co
         goto ret;
     }
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     while (mc_lstat (src_vpath, &src_stat) != 0)
     {
@@ -1329,7 +1329,7 @@ move_file_file (const WPanel * panel, file_op_total_context_t * tctx, file_op_co
             goto ret;
     }
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
   retry_src_remove:
     if (!try_remove_file (ctx, src_vpath, &return_status) && panel == NULL)
@@ -1364,7 +1364,7 @@ erase_file (file_op_total_context_t * tctx, file_op_context_t * ctx, const vfs_p
         if (check_progress_buttons (ctx) == FILE_ABORT)
             return FILE_ABORT;
 
-        mc_refresh ();
+        mc_refresh_deferred ();
     }
 
     if (tctx->progress_count != 0 && mc_lstat (vpath, &buf) != 0)
@@ -1454,7 +1454,7 @@ recursive_erase (file_op_total_context_t * tctx, file_op_context_t * ctx, const
     if (check_progress_buttons (ctx) == FILE_ABORT)
         return FILE_ABORT;
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     return try_erase_dir (ctx, s);
 }
@@ -1499,7 +1499,7 @@ erase_dir_iff_empty (file_op_context_t * ctx, const vfs_path_t * vpath, size_t c
     if (check_progress_buttons (ctx) == FILE_ABORT)
         return FILE_ABORT;
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     if (check_dir_is_empty (vpath) != 1)
         return FILE_CONT;
@@ -1578,7 +1578,7 @@ do_move_dir_dir (const WPanel * panel, file_op_total_context_t * tctx, file_op_c
         goto ret_fast;
     }
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     mc_stat (src_vpath, &src_stat);
 
@@ -1682,7 +1682,7 @@ do_move_dir_dir (const WPanel * panel, file_op_total_context_t * tctx, file_op_c
             goto ret;
     }
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     erase_dir_after_copy (tctx, ctx, src_vpath, &return_status);
 
@@ -2226,7 +2226,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
         goto ret_fast;
     }
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     while (mc_stat (dst_vpath, &dst_stat) == 0)
     {
@@ -2517,7 +2517,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
     else
         file_progress_show (ctx, 1, 1, "", TRUE);
     return_status = check_progress_buttons (ctx);
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     if (return_status == FILE_CONT)
     {
@@ -2640,7 +2640,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
                 file_progress_show (ctx, n_read_total + ctx->do_reget, file_size, stalled_msg,
                                     force_update);
             }
-            mc_refresh ();
+            mc_refresh_deferred ();
 
             return_status = check_progress_buttons (ctx);
 
@@ -3057,7 +3057,7 @@ erase_dir (file_op_total_context_t * tctx, file_op_context_t * ctx, const vfs_pa
     if (check_progress_buttons (ctx) == FILE_ABORT)
         return FILE_ABORT;
 
-    mc_refresh ();
+    mc_refresh_deferred ();
 
     /* The old way to detect a non empty directory was:
        error = my_rmdir (s);
@@ -3295,7 +3295,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
     {
         if (operation == OP_DELETE)
             dialog_type = FILEGUI_DIALOG_DELETE_ITEM;
-        else if (single_entry && S_ISDIR (selection (panel)->st.st_mode))
+        else if (single_entry && S_ISDIR (selection (panel)->st.mode))
             dialog_type = FILEGUI_DIALOG_MULTI_ITEM;
         else if (single_entry || force_single)
             dialog_type = FILEGUI_DIALOG_ONE_ITEM;
@@ -3315,6 +3315,10 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
         && (mc_setctl (panel->cwd_vpath, VFS_SETCTL_STALE_DATA, GUINT_TO_POINTER (1)) != 0))
         save_cwd = g_strdup (vfs_path_as_str (panel->cwd_vpath));
 
+    /* Network filesystems may send removals in batches instead of one by one */
+    if (operation == OP_DELETE)
+        mc_setctl (panel->cwd_vpath, VFS_SETCTL_BATCH, GUINT_TO_POINTER (1));
+
     /* Now, let's do the job */
 
     /* This code is only called by the tree and panel code */
@@ -3382,7 +3386,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                     continue;   /* Skip the unmarked ones */
 
                 source2 = panel->dir.list[i].fname;
-                src_stat = panel->dir.list[i].st;
+                file_stat_to_stat (&panel->dir.list[i].st, &src_stat);
 
                 value = operate_one_file (panel, operation, tctx, ctx, source2, &src_stat, dest);
 
@@ -3404,13 +3408,25 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                 if (check_progress_buttons (ctx) == FILE_ABORT)
                     break;
 
-                mc_refresh ();
+                mc_refresh_deferred ();
             }                   /* Loop for every file */
         }
     }                           /* Many entries */
 
   clean_up:
     /* Clean up */
+    if (operation == OP_DELETE)
+    {
+        int failed;
+
+        /* errors of batched removals are known only now */
+        failed = mc_setctl (panel->cwd_vpath, VFS_SETCTL_BATCH, NULL);
+        if (failed > 0)
+            message (D_ERROR, MSG_ERROR,
+                     ngettext ("Cannot remove %d file or directory",
+                               "Cannot remove %d files or directories", failed), failed);
+    }
+
     if (save_cwd != NULL)
     {
         tmp_vpath = vfs_path_from_str (save_cwd);
@@ -0,0 +1,390 @@
+/*
+   Matching of files for group selection in the panel.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file fileselect.c
+ *  \brief Source: matching of files for group selection in the panel
+ *
+ * Most patterns typed in the Select/Unselect dialog are literals with a star at one or both
+ * ends, like "*.log" or "core*". Such patterns are matched by plain string comparison,
+ * the regular expression engine is used for other patterns only.
+ *
+ * Besides file name, files can be matched by size and by age of modification time.
+ */
+
+#include <config.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lib/global.h"
+#include "lib/strutil.h"        /* parse_integer() */
+
+#include "fileselect.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/*** file scope type declarations ****************************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+file_select_is_ascii (const char *str, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        if ((guchar) str[i] >= 0x80)
+            return FALSE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find out if pattern can be matched without mc_search.
+ *
+ * @param fs file selector
+ * @param pattern pattern
+ * @param shell_patterns TRUE if pattern is a shell pattern, FALSE if it is a regular expression
+ */
+
+static void
+file_select_classify (file_select_t * fs, const char *pattern, gboolean shell_patterns)
+{
+    const char *special;
+    size_t len;
+    gboolean lead, trail;
+
+    len = strlen (pattern);
+
+    if (shell_patterns)
+    {
+        /* see glob translation in lib/search/glob.c */
+        special = "*?[]{},|\\";
+        lead = pattern[0] == '*';
+        trail = len > (lead ? 1 : 0) && pattern[len - 1] == '*';
+    }
+    else
+    {
+        special = ".^$*+?()[]{}|\\";
+        lead = FALSE;
+        trail = FALSE;
+    }
+
+    if (lead)
+    {
+        pattern++;
+        len--;
+    }
+    if (trail)
+        len--;
+
+    if (strcspn (pattern, special) < len)
+        return;
+
+    /* case insensitive comparison of literals is implemented for ASCII only */
+    if (!fs->case_sensitive && !file_select_is_ascii (pattern, len))
+        return;
+
+    fs->literal = g_strndup (pattern, len);
+    fs->literal_len = len;
+
+    if (len == 0)
+        fs->name_type = FILE_SELECT_NAME_ANY;
+    else if (lead && trail)
+        fs->name_type = FILE_SELECT_NAME_SUBSTRING;
+    else if (lead)
+        fs->name_type = FILE_SELECT_NAME_SUFFIX;
+    else if (trail)
+        fs->name_type = FILE_SELECT_NAME_PREFIX;
+    else
+        fs->name_type = FILE_SELECT_NAME_EXACT;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline gboolean
+file_select_equal (const file_select_t * fs, const char *str)
+{
+    return fs->case_sensitive ? memcmp (str, fs->literal, fs->literal_len) == 0
+        : g_ascii_strncasecmp (str, fs->literal, fs->literal_len) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+file_select_match_name (const file_select_t * fs, const char *name, size_t len)
+{
+    size_t i;
+
+    switch (fs->name_type)
+    {
+    case FILE_SELECT_NAME_ANY:
+        return TRUE;
+
+    case FILE_SELECT_NAME_EXACT:
+        return len == fs->literal_len && file_select_equal (fs, name);
+
+    case FILE_SELECT_NAME_PREFIX:
+        return len >= fs->literal_len && file_select_equal (fs, name);
+
+    case FILE_SELECT_NAME_SUFFIX:
+        return len >= fs->literal_len && file_select_equal (fs, name + len - fs->literal_len);
+
+    case FILE_SELECT_NAME_SUBSTRING:
+        if (fs->case_sensitive)
+            return strstr (name, fs->literal) != NULL;
+
+        for (i = 0; i + fs->literal_len <= len; i++)
+            if (file_select_equal (fs, name + i))
+                return TRUE;
+        return FALSE;
+
+    default:
+        return mc_search_run (fs->search, name, 0, len, NULL);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Parse comparison operator at the beginning of expression.
+ *
+ * @return -1 for '<', 1 for '>', 0 for '=', def if there is no operator
+ */
+
+static int
+file_select_parse_cmp (const char **expr, int def)
+{
+    int cmp = def;
+
+    while (isspace ((unsigned char) **expr))
+        (*expr)++;
+
+    switch (**expr)
+    {
+    case '<':
+        cmp = -1;
+        break;
+    case '>':
+        cmp = 1;
+        break;
+    case '=':
+        cmp = 0;
+        break;
+    default:
+        return cmp;
+    }
+
+    (*expr)++;
+    while (isspace ((unsigned char) **expr))
+        (*expr)++;
+
+    return cmp;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create file selector.
+ *
+ * @param pattern pattern of file names, empty pattern matches any name
+ * @param shell_patterns TRUE if pattern is a shell pattern, FALSE if it is a regular expression
+ * @param case_sensitive TRUE for case sensitive match of names
+ * @param files_only TRUE if directories should not be matched
+ *
+ * @return new file selector
+ */
+
+file_select_t *
+file_select_new (const char *pattern, gboolean shell_patterns, gboolean case_sensitive,
+                 gboolean files_only)
+{
+    file_select_t *fs;
+
+    fs = g_new0 (file_select_t, 1);
+    fs->case_sensitive = case_sensitive;
+    fs->files_only = files_only;
+    fs->name_type = FILE_SELECT_NAME_SEARCH;
+
+    file_select_classify (fs, pattern, shell_patterns);
+
+    if (fs->name_type == FILE_SELECT_NAME_SEARCH)
+    {
+        fs->search = mc_search_new (pattern, NULL);
+        fs->search->search_type = shell_patterns ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
+        fs->search->is_entire_line = TRUE;
+        fs->search->is_case_sensitive = case_sensitive;
+    }
+
+    return fs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+file_select_free (file_select_t * fs)
+{
+    if (fs != NULL)
+    {
+        mc_search_free (fs->search);
+        g_free (fs->literal);
+        g_free (fs);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set size predicate: "[<|>|=]number[suffix]", where suffix is one of suffixes of
+ * parse_integer(), e.g. ">100M". Without operator, size should be equal to number.
+ * Empty expression removes predicate.
+ *
+ * @return FALSE if expression is invalid
+ */
+
+gboolean
+file_select_set_size (file_select_t * fs, const char *expr)
+{
+    gboolean invalid = FALSE;
+    uintmax_t size;
+    int cmp;
+
+    cmp = file_select_parse_cmp (&expr, 0);
+    if (*expr == '\0')
+    {
+        fs->use_size = FALSE;
+        return cmp == 0;
+    }
+
+    size = parse_integer (expr, &invalid);
+    if (invalid)
+        return FALSE;
+
+    fs->use_size = TRUE;
+    fs->size_cmp = cmp;
+    fs->size = size;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set modification time predicate: "[<|>]number[s|m|h|d|w]". "<" selects files modified
+ * within the given time, ">" selects older files. Default operator is "<", default unit is day.
+ * Empty expression removes predicate.
+ *
+ * @return FALSE if expression is invalid
+ */
+
+gboolean
+file_select_set_age (file_select_t * fs, const char *expr, time_t now)
+{
+    char *end;
+    unsigned long age;
+    int cmp;
+
+    cmp = file_select_parse_cmp (&expr, -1);
+    if (*expr == '\0')
+    {
+        fs->use_mtime = FALSE;
+        return cmp == -1;
+    }
+
+    if (cmp == 0 || !isdigit ((unsigned char) *expr))
+        return FALSE;
+
+    age = strtoul (expr, &end, 10);
+
+    switch (*end)
+    {
+    case 's':
+        end++;
+        break;
+    case 'm':
+        age *= 60;
+        end++;
+        break;
+    case 'h':
+        age *= 60 * 60;
+        end++;
+        break;
+    case 'w':
+        age *= 7 * 24 * 60 * 60;
+        end++;
+        break;
+    case 'd':
+        end++;
+        MC_FALLTHROUGH;
+    default:
+        age *= 24 * 60 * 60;
+        break;
+    }
+
+    while (isspace ((unsigned char) *end))
+        end++;
+    if (*end != '\0')
+        return FALSE;
+
+    fs->use_mtime = TRUE;
+    fs->mtime_cmp = cmp;
+    fs->mtime = now - (time_t) age;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check if file matches all criteria of selector. The ".." entry never matches.
+ */
+
+gboolean
+file_select_match (const file_select_t * fs, const file_entry_t * fe)
+{
+    if (DIR_IS_DOTDOT (fe->fname))
+        return FALSE;
+
+    if (fs->files_only && S_ISDIR (fe->st.mode))
+        return FALSE;
+
+    /* cheap checks go first */
+    if (fs->use_size)
+    {
+        uintmax_t size = (uintmax_t) fe->st.size;
+
+        if (fs->size_cmp < 0 ? size >= fs->size : fs->size_cmp > 0 ? size <= fs->size
+            : size != fs->size)
+            return FALSE;
+    }
+
+    if (fs->use_mtime
+        && (fs->mtime_cmp < 0 ? fe->st.mtime < fs->mtime : fe->st.mtime >= fs->mtime))
+        return FALSE;
+
+    return file_select_match_name (fs, fe->fname, fe->fnamelen);
+}
+
+/* --------------------------------------------------------------------------------------------- */
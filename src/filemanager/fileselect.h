@@ -0,0 +1,62 @@
+/** \file fileselect.h
+ *  \brief Header: matching of files for group selection in the panel
+ */
+
+#ifndef MC__FILESELECT_H
+#define MC__FILESELECT_H
+
+#include "lib/global.h"
+#include "lib/search.h"
+#include "lib/util.h"           /* file_entry_t */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/* how file name is matched */
+typedef enum
+{
+    FILE_SELECT_NAME_ANY = 0,   /* any name, pattern is empty */
+    FILE_SELECT_NAME_EXACT,     /* name equals to literal */
+    FILE_SELECT_NAME_PREFIX,    /* name starts with literal */
+    FILE_SELECT_NAME_SUFFIX,    /* name ends with literal */
+    FILE_SELECT_NAME_SUBSTRING, /* name contains literal */
+    FILE_SELECT_NAME_SEARCH     /* name is matched by mc_search */
+} file_select_name_t;
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct
+{
+    file_select_name_t name_type;
+    char *literal;
+    size_t literal_len;
+    mc_search_t *search;
+    gboolean case_sensitive;
+    gboolean files_only;
+
+    /* size predicate: size_cmp < 0 for "less than", > 0 for "greater than", 0 for "equal" */
+    gboolean use_size;
+    int size_cmp;
+    uintmax_t size;
+
+    /* modification time predicate: mtime_cmp < 0 for "newer than", > 0 for "older than" */
+    gboolean use_mtime;
+    int mtime_cmp;
+    time_t mtime;
+} file_select_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+file_select_t *file_select_new (const char *pattern, gboolean shell_patterns,
+                                gboolean case_sensitive, gboolean files_only);
+void file_select_free (file_select_t * fs);
+gboolean file_select_set_size (file_select_t * fs, const char *expr);
+gboolean file_select_set_age (file_select_t * fs, const char *expr, time_t now);
+gboolean file_select_match (const file_select_t * fs, const file_entry_t * fe);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__FILESELECT_H */
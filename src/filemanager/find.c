@@ -1254,7 +1254,7 @@ find_rotate_dash (const WDialog * h, gboolean show)
     widget_move (h, w->lines - 7, w->cols - 4);
     tty_print_char (show ? rotating_dash[pos] : ' ');
     pos = (pos + 1) % sizeof (rotating_dash);
-    mc_refresh ();
+    mc_refresh_deferred ();
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1830,14 +1830,16 @@ do_find (const char *start_dir, ssize_t start_dir_len, const char *ignore_dirs,
             }
 
             list->list[list->len].fnamelen = strlen (p);
-            list->list[list->len].fname = g_strndup (p, list->list[list->len].fnamelen);
+            list->list[list->len].fname =
+                dir_list_name_dup (list, p, list->list[list->len].fnamelen);
             list->list[list->len].f.marked = 0;
             list->list[list->len].f.link_to_dir = link_to_dir;
             list->list[list->len].f.stale_link = stale_link;
             list->list[list->len].f.dir_size_computed = 0;
-            list->list[list->len].st = st;
+            file_stat_from_stat (&list->list[list->len].st, &st);
             list->list[list->len].sort_key = NULL;
             list->list[list->len].second_sort_key = NULL;
+            list->list[list->len].color_generation = 0;
             list->len++;
             g_free (name);
             if ((list->len & 15) == 0)
@@ -66,6 +66,11 @@ struct WInfo
 {
     Widget widget;
     gboolean ready;
+
+    /* file list keeps a part of file attributes only, so selected file is stat'ed */
+    vfs_path_t *vpath;          /* selected file */
+    file_stat_t fst;            /* attributes of selected file from file list */
+    struct stat st;             /* result of stat */
 };
 
 /*** file scope variables ************************************************************************/
@@ -98,6 +103,37 @@ info_box (WInfo * info)
     tty_draw_hline (w->y + 2, w->x + 1, ACS_HLINE, w->cols - 2);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get attributes of the selected file. File is stat'ed once while it is selected
+ * and isn't changed in the file list, not on every redraw.
+ */
+
+static void
+info_get_stat (WInfo * info, const WPanel * panel, struct stat *st)
+{
+    const file_entry_t *fe = &panel->dir.list[panel->selected];
+    vfs_path_t *vpath;
+
+    vpath = vfs_path_append_new (panel->cwd_vpath, fe->fname, (char *) NULL);
+
+    if (info->vpath == NULL || !vfs_path_equal (info->vpath, vpath)
+        || info->fst.ino != fe->st.ino || info->fst.size != fe->st.size
+        || info->fst.mtime != fe->st.mtime || info->fst.ctime != fe->st.ctime
+        || info->fst.mode != fe->st.mode)
+    {
+        if (mc_lstat (vpath, &info->st) != 0)
+            file_stat_to_stat (&fe->st, &info->st);
+        info->fst = fe->st;
+        vfs_path_free (info->vpath);
+        info->vpath = vpath;
+    }
+    else
+        vfs_path_free (vpath);
+
+    *st = info->st;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -133,7 +169,7 @@ info_show_info (WInfo * info)
 
     my_statfs (&myfs_stats, p_rp_cwd);
 
-    st = current_panel->dir.list[current_panel->selected].st;
+    info_get_stat (info, current_panel, &st);
 
     /* Print only lines which fit */
 
@@ -322,6 +358,7 @@ info_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *da
     case MSG_DESTROY:
         delete_hook (&select_file_hook, info_hook);
         free_my_statfs ();
+        vfs_path_free (info->vpath);
         return MSG_HANDLED;
 
     default:
@@ -340,6 +377,7 @@ info_new (int y, int x, int lines, int cols)
     Widget *w;
 
     info = g_new (struct WInfo, 1);
+    info->vpath = NULL;
     w = WIDGET (info);
     widget_init (w, y, x, lines, cols, info_callback, NULL);
 
@@ -736,7 +736,7 @@ put_link (WPanel * panel)
 {
     if (!command_prompt)
         return;
-    if (S_ISLNK (selection (panel)->st.st_mode))
+    if (S_ISLNK (selection (panel)->st.mode))
     {
         char buffer[MC_MAXPATHLEN];
         vfs_path_t *vpath;
@@ -1498,6 +1498,11 @@ midnight_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void
         return MSG_HANDLED;
 
     case MSG_DRAW:
+        /* whole screen is being repainted, so panels cannot rely on what they painted before */
+        if (get_panel_type (0) == view_listing)
+            panel_invalidate_rows (PANEL (get_panel_widget (0)));
+        if (get_panel_type (1) == view_listing)
+            panel_invalidate_rows (PANEL (get_panel_widget (1)));
         load_hint (TRUE);
         /* We handle the special case of the output lines */
         if (mc_global.tty.console_flag != '\0' && output_lines)
@@ -60,6 +60,7 @@
 #ifdef HAVE_CHARSET
 #include "src/selcodepage.h"    /* select_charset (), SELECT_CHARSET_NO_TRANSLATE */
 #endif
+#include "src/history.h"
 #include "src/keybind-defaults.h"       /* global_keymap_t */
 #ifdef ENABLE_SUBSHELL
 #include "src/subshell/subshell.h"      /* do_subshell_chdir() */
@@ -77,6 +78,7 @@
 #include "midnight.h"
 #include "mountlist.h"          /* my_statfs */
 
+#include "fileselect.h"
 #include "panel.h"
 
 /*** global variables ****************************************************************************/
@@ -85,7 +87,7 @@
 hook_t *select_file_hook = NULL;
 
 /* *INDENT-OFF* */
-panelized_panel_t panelized_panel = { {NULL, 0, -1}, NULL };
+panelized_panel_t panelized_panel = { {NULL, 0, -1, FALSE, NULL}, NULL };
 /* *INDENT-ON* */
 
 static const char *string_file_name (file_entry_t *, int);
@@ -117,6 +119,12 @@ mc_fhl_t *mc_filehighlight = NULL;
 #define MARKED_SELECTED 3
 #define STATUS          5
 
+/* serial of panel row that is painted empty, see panel_row_t */
+#define PANEL_ROW_EMPTY G_MAXUINT
+
+/* drop cached cells if there are more of them than shown rows multiplied by this */
+#define PANEL_CELLS_MAX_RATIO 4
+
 /*** file scope type declarations ****************************************************************/
 
 typedef enum
@@ -150,6 +158,23 @@ typedef enum
     FILENAME_SCROLL_RIGHT = 4
 } filename_scroll_flag_t;
 
+/* Formatted fields of file entry. They are reused while the entry is not changed */
+typedef struct
+{
+    guint serial;               /* unique number of this set of fields */
+    file_entry_t fe;            /* copy of the entry the fields were made of */
+    GPtrArray *fields;          /* texts of format items that have string_fn */
+} panel_cells_t;
+
+/* State of panel row on the screen */
+typedef struct
+{
+    guint serial;               /* serial of painted cells, 0 if the row is not painted */
+    int attr;
+    int width;
+    int content_shift;          /* scroll of filename the row is painted with */
+} panel_row_t;
+
 /*** file scope variables ************************************************************************/
 
 /* *INDENT-OFF* */
@@ -370,6 +395,9 @@ static WPanel *mouse_mark_panel = NULL;
 static int mouse_marking = 0;
 static int state_mark = 0;
 
+/* last serial of panel cells */
+static guint panel_cells_serial = 0;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -511,11 +539,11 @@ string_file_size (file_entry_t * fe, int len)
         return _("UP--DIR");
 
 #ifdef HAVE_STRUCT_STAT_ST_RDEV
-    if (S_ISBLK (fe->st.st_mode) || S_ISCHR (fe->st.st_mode))
-        format_device_number (buffer, len + 1, fe->st.st_rdev);
+    if (S_ISBLK (fe->st.mode) || S_ISCHR (fe->st.mode))
+        format_device_number (buffer, len + 1, fe->st.rdev);
     else
 #endif
-        size_trunc_len (buffer, (unsigned int) len, fe->st.st_size, 0, panels_options.kilobyte_si);
+        size_trunc_len (buffer, (unsigned int) len, fe->st.size, 0, panels_options.kilobyte_si);
 
     return buffer;
 }
@@ -526,10 +554,10 @@ string_file_size (file_entry_t * fe, int len)
 static const char *
 string_file_size_brief (file_entry_t * fe, int len)
 {
-    if (S_ISLNK (fe->st.st_mode) && !link_isdir (fe))
+    if (S_ISLNK (fe->st.mode) && !link_isdir (fe))
         return _("SYMLINK");
 
-    if ((S_ISDIR (fe->st.st_mode) || link_isdir (fe)) && !DIR_IS_DOTDOT (fe->fname))
+    if ((S_ISDIR (fe->st.mode) || link_isdir (fe)) && !DIR_IS_DOTDOT (fe->fname))
         return _("SUB-DIR");
 
     return string_file_size (fe, len);
@@ -545,9 +573,9 @@ string_file_type (file_entry_t * fe, int len)
 
     (void) len;
 
-    if (S_ISDIR (fe->st.st_mode))
+    if (S_ISDIR (fe->st.mode))
         buffer[0] = PATH_SEP;
-    else if (S_ISLNK (fe->st.st_mode))
+    else if (S_ISLNK (fe->st.mode))
     {
         if (link_isdir (fe))
             buffer[0] = '~';
@@ -556,21 +584,21 @@ string_file_type (file_entry_t * fe, int len)
         else
             buffer[0] = '@';
     }
-    else if (S_ISCHR (fe->st.st_mode))
+    else if (S_ISCHR (fe->st.mode))
         buffer[0] = '-';
-    else if (S_ISSOCK (fe->st.st_mode))
+    else if (S_ISSOCK (fe->st.mode))
         buffer[0] = '=';
-    else if (S_ISDOOR (fe->st.st_mode))
+    else if (S_ISDOOR (fe->st.mode))
         buffer[0] = '>';
-    else if (S_ISBLK (fe->st.st_mode))
+    else if (S_ISBLK (fe->st.mode))
         buffer[0] = '+';
-    else if (S_ISFIFO (fe->st.st_mode))
+    else if (S_ISFIFO (fe->st.mode))
         buffer[0] = '|';
-    else if (S_ISNAM (fe->st.st_mode))
+    else if (S_ISNAM (fe->st.mode))
         buffer[0] = '#';
-    else if (!S_ISREG (fe->st.st_mode))
+    else if (!S_ISREG (fe->st.mode))
         buffer[0] = '?';        /* non-regular of unknown kind */
-    else if (is_exe (fe->st.st_mode))
+    else if (is_exe (fe->st.mode))
         buffer[0] = '*';
     else
         buffer[0] = ' ';
@@ -586,7 +614,7 @@ string_file_mtime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_mtime);
+    return file_date (fe->st.mtime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -597,7 +625,7 @@ string_file_atime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_atime);
+    return file_date (fe->st.atime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -608,7 +636,7 @@ string_file_ctime (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return file_date (fe->st.st_ctime);
+    return file_date (fe->st.ctime);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -619,7 +647,7 @@ string_file_permission (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return string_perm (fe->st.st_mode);
+    return string_perm (fe->st.mode);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -632,7 +660,7 @@ string_file_perm_octal (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "0%06lo", (unsigned long) fe->st.st_mode);
+    g_snprintf (buffer, sizeof (buffer), "0%06lo", (unsigned long) fe->st.mode);
     return buffer;
 }
 
@@ -646,7 +674,7 @@ string_file_nlinks (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%16d", (int) fe->st.st_nlink);
+    g_snprintf (buffer, sizeof (buffer), "%16d", (int) fe->st.nlink);
     return buffer;
 }
 
@@ -660,7 +688,7 @@ string_inode (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_ino);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.ino);
     return buffer;
 }
 
@@ -674,7 +702,7 @@ string_file_nuid (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_uid);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.uid);
     return buffer;
 }
 
@@ -688,7 +716,7 @@ string_file_ngid (file_entry_t * fe, int len)
 
     (void) len;
 
-    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.st_gid);
+    g_snprintf (buffer, sizeof (buffer), "%lu", (unsigned long) fe->st.gid);
     return buffer;
 }
 
@@ -700,7 +728,7 @@ string_file_owner (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return get_owner (fe->st.st_uid);
+    return get_owner (fe->st.uid);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -711,7 +739,7 @@ string_file_group (file_entry_t * fe, int len)
 {
     (void) len;
 
-    return get_group (fe->st.st_gid);
+    return get_group (fe->st.gid);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -783,16 +811,106 @@ panel_items (const WPanel * p)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** Formats the file number file_index of panel in the buffer dest */
+
+static void
+panel_cells_free (gpointer data)
+{
+    panel_cells_t *cells = (panel_cells_t *) data;
+
+    g_free (cells->fe.fname);
+    g_ptr_array_free (cells->fields, TRUE);
+    g_free (cells);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+panel_cells_match (const panel_cells_t * cells, const file_entry_t * fe)
+{
+    return (cells->fe.fnamelen == fe->fnamelen && strcmp (cells->fe.fname, fe->fname) == 0
+            && memcmp (&cells->fe.st, &fe->st, sizeof (fe->st)) == 0
+            && cells->fe.f.marked == fe->f.marked && cells->fe.f.link_to_dir == fe->f.link_to_dir
+            && cells->fe.f.stale_link == fe->f.stale_link
+            && cells->fe.f.dir_size_computed == fe->f.dir_size_computed);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get formatted fields of file. Fields are made once and then reused until the file entry
+ * or the panel format is changed.
+ */
+
+static panel_cells_t *
+panel_get_cells (WPanel * panel, int file_index)
+{
+    file_entry_t *fe = &panel->dir.list[file_index];
+    panel_cells_t *cells = NULL;
+    GSList *format;
+
+    if (panel->cells == NULL)
+        panel->cells =
+            g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, panel_cells_free);
+    else
+    {
+        cells = (panel_cells_t *) g_hash_table_lookup (panel->cells, GINT_TO_POINTER (file_index));
+        if (cells != NULL && panel_cells_match (cells, fe))
+            return cells;
+
+        /* keep cache small: only shown files are really needed */
+        if (cells == NULL
+            && g_hash_table_size (panel->cells) >=
+            (guint) (panel_items (panel) * PANEL_CELLS_MAX_RATIO))
+            g_hash_table_remove_all (panel->cells);
+    }
+
+    cells = g_new (panel_cells_t, 1);
+    /* 0 and PANEL_ROW_EMPTY are reserved */
+    if (++panel_cells_serial == PANEL_ROW_EMPTY)
+        panel_cells_serial = 1;
+    cells->serial = panel_cells_serial;
+    cells->fe = *fe;
+    cells->fe.fname = g_strndup (fe->fname, fe->fnamelen);
+    cells->fe.sort_key = NULL;
+    cells->fe.second_sort_key = NULL;
+    cells->fields = g_ptr_array_new_with_free_func (g_free);
+
+    for (format = panel->format; format != NULL; format = g_slist_next (format))
+    {
+        format_item_t *fi = (format_item_t *) format->data;
+
+        if (fi->string_fn != NULL)
+            g_ptr_array_add (cells->fields, g_strdup (fi->string_fn (fe, fi->field_len)));
+    }
+
+    g_hash_table_replace (panel->cells, GINT_TO_POINTER (file_index), cells);
+
+    return cells;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_drop_cells (WPanel * panel)
+{
+    if (panel->cells != NULL)
+        g_hash_table_remove_all (panel->cells);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Formats the file number file_index of panel in the buffer dest.
+ * If cells is not NULL, texts of fields are taken from it.
+ */
 
 static filename_scroll_flag_t
 format_file (WPanel * panel, int file_index, int width, int attr, gboolean isstatus,
-             int *field_length)
+             const panel_cells_t * cells, int *field_length)
 {
     int color = NORMAL_COLOR;
     int length = 0;
     GSList *format, *home;
     file_entry_t *fe = NULL;
+    guint field = 0;
     filename_scroll_flag_t res = FILENAME_NOSCROLL;
 
     *field_length = 0;
@@ -816,7 +934,9 @@ format_file (WPanel * panel, int file_index, int width, int attr, gboolean issta
             const char *prepared_text;
             int name_offset = 0;
 
-            if (fe != NULL)
+            if (cells != NULL)
+                txt = (const char *) g_ptr_array_index (cells->fields, field++);
+            else if (fe != NULL)
                 txt = fi->string_fn (fe, fi->field_len);
 
             len = fi->field_len;
@@ -910,6 +1030,7 @@ repaint_file (WPanel * panel, int file_index, gboolean mv, int attr, gboolean is
     int ypos = 0;
     gboolean panel_is_split;
     int fln = 0;
+    panel_cells_t *cells = NULL;
 
     panel_is_split = !isstatus && panel->list_cols > 1;
     width = w->cols - 2;
@@ -929,6 +1050,31 @@ repaint_file (WPanel * panel, int file_index, gboolean mv, int attr, gboolean is
     if (width <= 0)
         return;
 
+    if (!isstatus && mv)
+    {
+        int row_index = file_index - panel->top_file;
+
+        if (file_index < panel->dir.len)
+            cells = panel_get_cells (panel, file_index);
+
+        if (panel->rows != NULL && row_index >= 0 && (guint) row_index < panel->rows->len)
+        {
+            panel_row_t *row = &g_array_index (panel->rows, panel_row_t, row_index);
+            guint serial = cells != NULL ? cells->serial : PANEL_ROW_EMPTY;
+
+            /* Row is on the screen already. While filename is scrolled,
+               every row should be formatted to get max_shift */
+            if (row->serial == serial && row->attr == attr && row->width == width
+                && row->content_shift == -1 && panel->content_shift == -1)
+                return;
+
+            row->serial = serial;
+            row->attr = attr;
+            row->width = width;
+            row->content_shift = panel->content_shift;
+        }
+    }
+
     if (mv)
     {
         ypos = file_index - panel->top_file;
@@ -940,7 +1086,7 @@ repaint_file (WPanel * panel, int file_index, gboolean mv, int attr, gboolean is
         widget_move (w, ypos, offset + 1);
     }
 
-    ret_frm = format_file (panel, file_index, width, attr, isstatus, &fln);
+    ret_frm = format_file (panel, file_index, width, attr, isstatus, cells, &fln);
 
     if (panel_is_split && nth_column + 1 < panel->list_cols)
     {
@@ -1001,7 +1147,7 @@ display_mini_info (WPanel * panel)
     /* Status resolves links and show them */
     set_colors (panel);
 
-    if (S_ISLNK (panel->dir.list[panel->selected].st.st_mode))
+    if (S_ISLNK (panel->dir.list[panel->selected].st.mode))
     {
         char link_target[MC_MAXPATHLEN];
         vfs_path_t *lc_link_vpath;
@@ -1046,6 +1192,15 @@ paint_dir (WPanel * panel)
     /* reset max len of filename because we have the new max length for the new file list */
     panel->max_shift = -1;
 
+    if (panel->rows == NULL)
+        panel->rows = g_array_new (FALSE, TRUE, sizeof (panel_row_t));
+    if (panel->rows->len != (guint) items)
+    {
+        /* geometry is changed: forget all rows */
+        g_array_set_size (panel->rows, 0);
+        g_array_set_size (panel->rows, items);
+    }
+
     for (i = 0; i < items; i++)
     {
         int color = 0;          /* Color value of the line */
@@ -1194,7 +1349,8 @@ panel_correct_path_to_show (const WPanel * panel)
 
     if (elements_count > 1 && (strcmp (path_element->class->name, "cpiofs") == 0 ||
                                strcmp (path_element->class->name, "extfs") == 0 ||
-                               strcmp (path_element->class->name, "tarfs") == 0))
+                               strcmp (path_element->class->name, "tarfs") == 0 ||
+                               strcmp (path_element->class->name, "zipfs") == 0))
     {
         const char *archive_name;
         const vfs_path_element_t *prev_path_element;
@@ -1314,12 +1470,12 @@ show_dir (const WPanel * panel)
         if (panel->marked == 0)
         {
             /* Show size of curret file in the bottom of panel */
-            if (S_ISREG (panel->dir.list[panel->selected].st.st_mode))
+            if (S_ISREG (panel->dir.list[panel->selected].st.mode))
             {
                 char buffer[BUF_SMALL];
 
                 g_snprintf (buffer, sizeof (buffer), " %s ",
-                            size_trunc_sep (panel->dir.list[panel->selected].st.st_size,
+                            size_trunc_sep (panel->dir.list[panel->selected].st.size,
                                             panels_options.kilobyte_si));
                 tty_setcolor (NORMAL_COLOR);
                 widget_move (w, w->lines - 1, 4);
@@ -1495,6 +1651,11 @@ panel_destroy (WPanel * p)
     g_slist_free_full (p->format, (GDestroyNotify) format_item_free);
     g_slist_free_full (p->status_format, (GDestroyNotify) format_item_free);
 
+    if (p->rows != NULL)
+        g_array_free (p->rows, TRUE);
+    if (p->cells != NULL)
+        g_hash_table_destroy (p->cells);
+
     g_free (p->user_format);
     for (i = 0; i < LIST_FORMATS; i++)
         g_free (p->user_status_format[i]);
@@ -1997,7 +2158,7 @@ maybe_cd (gboolean move_up_dir)
             return MSG_HANDLED;
         }
 
-        if (S_ISDIR (selection (current_panel)->st.st_mode)
+        if (S_ISDIR (selection (current_panel)->st.mode)
             || link_isdir (selection (current_panel)))
         {
             vfs_path_t *vpath;
@@ -2067,7 +2228,7 @@ panel_select_ext_cmd (void)
     {
         file_entry_t *file_entry = &current_panel->dir.list[i];
 
-        if (DIR_IS_DOTDOT (file_entry->fname) || S_ISDIR (file_entry->st.st_mode))
+        if (DIR_IS_DOTDOT (file_entry->fname) || S_ISDIR (file_entry->st.mode))
             continue;
 
         if (!mc_search_run (search, file_entry->fname, 0, file_entry->fnamelen, NULL))
@@ -2325,7 +2486,7 @@ next_page (WPanel * panel)
 static void
 goto_child_dir (WPanel * panel)
 {
-    if ((S_ISDIR (selection (panel)->st.st_mode) || link_isdir (selection (panel))))
+    if ((S_ISDIR (selection (panel)->st.mode) || link_isdir (selection (panel))))
     {
         vfs_path_t *vpath;
 
@@ -2510,6 +2671,60 @@ mark_file_left (WPanel * panel)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Mark or unmark all files matched by selector. Totals of marked files are updated at once.
+ */
+
+static void
+panel_mark_matching_files (WPanel * panel, const file_select_t * fs, gboolean do_select)
+{
+    const int mark = do_select ? 1 : 0;
+    int i;
+    int marked = 0, dirs_marked = 0;
+    uintmax_t total = 0;
+
+    for (i = 0; i < panel->dir.len; i++)
+    {
+        file_entry_t *fe = &panel->dir.list[i];
+
+        /* check mark first: it's cheaper than matching */
+        if (fe->f.marked == mark || !file_select_match (fs, fe))
+            continue;
+
+        fe->f.marked = mark;
+        marked++;
+
+        if (S_ISDIR (fe->st.mode))
+        {
+            if (fe->f.dir_size_computed)
+                total += (uintmax_t) fe->st.size;
+            dirs_marked++;
+        }
+        else
+            total += (uintmax_t) fe->st.size;
+    }
+
+    if (marked == 0)
+        return;
+
+    if (do_select)
+    {
+        panel->marked += marked;
+        panel->dirs_marked += dirs_marked;
+        panel->total += total;
+    }
+    else
+    {
+        panel->marked -= marked;
+        panel->dirs_marked -= dirs_marked;
+        panel->total -= total;
+    }
+
+    panel->dirty = 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static void
 panel_select_unselect_files (WPanel * panel, const char *title, const char *history_name,
                              gboolean do_select)
@@ -2518,14 +2733,20 @@ panel_select_unselect_files (WPanel * panel, const char *title, const char *hist
     gboolean case_sens = (panels_options.select_flags & SELECT_MATCH_CASE) != 0;
     gboolean shell_patterns = (panels_options.select_flags & SELECT_SHELL_PATTERNS) != 0;
 
-    char *reg_exp;
-    mc_search_t *search;
-    int i;
+    char *reg_exp, *size_expr, *age_expr;
+    file_select_t *fs;
 
     quick_widget_t quick_widgets[] = {
         /* *INDENT-OFF* */
         QUICK_INPUT (INPUT_LAST_TEXT, history_name, &reg_exp, NULL,
                      FALSE, FALSE, INPUT_COMPLETE_FILENAMES),
+        QUICK_START_COLUMNS,
+            QUICK_LABELED_INPUT (N_("Si&ze:"), input_label_left, "", MC_HISTORY_FM_SELECT_SIZE,
+                                 &size_expr, NULL, FALSE, FALSE, INPUT_COMPLETE_NONE),
+        QUICK_NEXT_COLUMN,
+            QUICK_LABELED_INPUT (N_("&Age:"), input_label_left, "", MC_HISTORY_FM_SELECT_AGE,
+                                 &age_expr, NULL, FALSE, FALSE, INPUT_COMPLETE_NONE),
+        QUICK_STOP_COLUMNS,
         QUICK_START_COLUMNS,
             QUICK_CHECKBOX (N_("&Files only"), &files_only, NULL),
             QUICK_CHECKBOX (N_("&Using shell patterns"), &shell_patterns, NULL),
@@ -2545,30 +2766,28 @@ panel_select_unselect_files (WPanel * panel, const char *title, const char *hist
     if (quick_dialog (&qdlg) == B_CANCEL)
         return;
 
-    if (reg_exp == NULL || *reg_exp == '\0')
+    if ((reg_exp == NULL || *reg_exp == '\0') && (size_expr == NULL || *size_expr == '\0')
+        && (age_expr == NULL || *age_expr == '\0'))
     {
         g_free (reg_exp);
+        g_free (size_expr);
+        g_free (age_expr);
         return;
     }
 
-    search = mc_search_new (reg_exp, NULL);
-    search->search_type = shell_patterns ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
-    search->is_entire_line = TRUE;
-    search->is_case_sensitive = case_sens;
+    fs = file_select_new (reg_exp != NULL ? reg_exp : "", shell_patterns, case_sens, files_only);
 
-    for (i = 0; i < panel->dir.len; i++)
-    {
-        if (DIR_IS_DOTDOT (panel->dir.list[i].fname))
-            continue;
-        if (S_ISDIR (panel->dir.list[i].st.st_mode) && files_only)
-            continue;
-
-        if (mc_search_run (search, panel->dir.list[i].fname, 0, panel->dir.list[i].fnamelen, NULL))
-            do_file_mark (panel, i, do_select);
-    }
+    if (size_expr != NULL && !file_select_set_size (fs, size_expr))
+        message (D_ERROR, MSG_ERROR, _("Invalid size: \"%s\""), size_expr);
+    else if (age_expr != NULL && !file_select_set_age (fs, age_expr, time (NULL)))
+        message (D_ERROR, MSG_ERROR, _("Invalid age: \"%s\""), age_expr);
+    else
+        panel_mark_matching_files (panel, fs, do_select);
 
-    mc_search_free (search);
+    file_select_free (fs);
     g_free (reg_exp);
+    g_free (size_expr);
+    g_free (age_expr);
 
     /* result flags */
     panels_options.select_flags = 0;
@@ -2607,7 +2826,7 @@ panel_select_invert_files (WPanel * panel)
     {
         file_entry_t *file = &panel->dir.list[i];
 
-        if (!panels_options.reverse_files_only || !S_ISDIR (file->st.st_mode))
+        if (!panels_options.reverse_files_only || !S_ISDIR (file->st.mode))
             do_file_mark (panel, i, !file->f.marked);
     }
 }
@@ -2622,12 +2841,8 @@ static void
 do_search (WPanel * panel, int c_code)
 {
     size_t l;
-    int i, sel;
-    gboolean wrapped = FALSE;
+    int sel;
     char *act;
-    mc_search_t *search;
-    char *reg_exp, *esc_str;
-    gboolean is_found = FALSE;
 
     l = strlen (panel->search_buffer);
     if (c_code == KEY_BACKSPACE)
@@ -2669,44 +2884,33 @@ do_search (WPanel * panel, int c_code)
         }
     }
 
-    reg_exp = g_strdup_printf ("%s*", panel->search_buffer);
-    esc_str = strutils_escape (reg_exp, -1, ",|\\{}[]", TRUE);
-    search = mc_search_new (esc_str, NULL);
-    search->search_type = MC_SEARCH_T_GLOB;
-    search->is_entire_line = TRUE;
-
-    switch (panels_options.qsearch_mode)
+    if (panel->quick_search == NULL)
     {
-    case QSEARCH_CASE_SENSITIVE:
-        search->is_case_sensitive = TRUE;
-        break;
-    case QSEARCH_CASE_INSENSITIVE:
-        search->is_case_sensitive = FALSE;
-        break;
-    default:
-        search->is_case_sensitive = panel->sort_info.case_sensitive;
-        break;
-    }
-
-    sel = panel->selected;
+        gboolean case_sensitive;
 
-    for (i = panel->selected; !wrapped || i != panel->selected; i++)
-    {
-        if (i >= panel->dir.len)
+        switch (panels_options.qsearch_mode)
         {
-            i = 0;
-            if (wrapped)
-                break;
-            wrapped = TRUE;
-        }
-        if (mc_search_run (search, panel->dir.list[i].fname, 0, panel->dir.list[i].fnamelen, NULL))
-        {
-            sel = i;
-            is_found = TRUE;
+        case QSEARCH_CASE_SENSITIVE:
+            case_sensitive = TRUE;
+            break;
+        case QSEARCH_CASE_INSENSITIVE:
+            case_sensitive = FALSE;
+            break;
+        default:
+            case_sensitive = panel->sort_info.case_sensitive;
             break;
         }
+
+        panel->quick_search =
+            quick_search_new (&panel->dir, case_sensitive, panels_options.qsearch_fuzzy);
     }
-    if (is_found)
+
+    /* search again: fuzzy search goes to the next ranked match,
+       other ones search from the next file */
+    sel = quick_search_find (panel->quick_search, panel->search_buffer, panel->selected,
+                             c_code == 0);
+
+    if (sel >= 0)
     {
         unselect_item (panel);
         panel->selected = sel;
@@ -2719,9 +2923,6 @@ do_search (WPanel * panel, int c_code)
         str_prev_noncomb_char (&act, panel->search_buffer);
         act[0] = '\0';
     }
-    mc_search_free (search);
-    g_free (reg_exp);
-    g_free (esc_str);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -2734,10 +2935,14 @@ start_search (WPanel * panel)
 {
     if (panel->searching)
     {
-        if (panel->selected + 1 == panel->dir.len)
-            panel->selected = 0;
-        else
-            move_down (panel);
+        /* fuzzy search goes to the next ranked match itself */
+        if (!panels_options.qsearch_fuzzy)
+        {
+            if (panel->selected + 1 == panel->dir.len)
+                panel->selected = 0;
+            else
+                move_down (panel);
+        }
 
         /* in case if there was no search string we need to recall
            previous string, with which we ended previous searching */
@@ -2764,6 +2969,7 @@ static void
 stop_search (WPanel * panel)
 {
     panel->searching = FALSE;
+    quick_search_free (&panel->quick_search);
 
     /* if user had overrdied search string, we need to store it
        to the previous_search_buffer */
@@ -2787,7 +2993,7 @@ do_enter_on_file_entry (file_entry_t * fe)
      * Directory or link to directory - change directory.
      * Try the same for the entries on which mc_lstat() has failed.
      */
-    if (S_ISDIR (fe->st.st_mode) || link_isdir (fe) || (fe->st.st_mode == 0))
+    if (S_ISDIR (fe->st.mode) || link_isdir (fe) || (fe->st.mode == 0))
     {
         vfs_path_t *fname_vpath;
 
@@ -2808,7 +3014,7 @@ do_enter_on_file_entry (file_entry_t * fe)
 
     /* Check if the file is executable */
     full_name_vpath = vfs_path_append_new (current_panel->cwd_vpath, fe->fname, (char *) NULL);
-    ok = (is_exe (fe->st.st_mode) && if_link_is_exe (full_name_vpath, fe));
+    ok = (is_exe (fe->st.mode) && if_link_is_exe (full_name_vpath, fe));
     vfs_path_free (full_name_vpath);
     if (!ok)
         return FALSE;
@@ -2879,7 +3085,7 @@ chdir_other_panel (WPanel * panel)
     if (get_other_type () != view_listing)
         create_panel (get_other_index (), view_listing);
 
-    if (S_ISDIR (entry->st.st_mode) || link_isdir (entry))
+    if (S_ISDIR (entry->st.mode) || link_isdir (entry))
         new_dir_vpath = vfs_path_append_new (panel->cwd_vpath, entry->fname, (char *) NULL);
     else
     {
@@ -2934,7 +3140,7 @@ chdir_to_readlink (WPanel * panel)
     if (get_other_type () != view_listing)
         return;
 
-    if (!S_ISLNK (panel->dir.list[panel->selected].st.st_mode))
+    if (!S_ISLNK (panel->dir.list[panel->selected].st.mode))
         return;
 
     i = readlink (selection (panel)->fname, buffer, MC_MAXPATHLEN - 1);
@@ -3639,8 +3845,10 @@ panel_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *d
         return MSG_HANDLED;
 
     case MSG_DRAW:
-        /* Repaint everything, including frame and separator */
-        widget_erase (w);
+        /* Repaint frame and separator. Rows that are on the screen already are
+           not repainted unless the panel was invalidated */
+        if (panel->rows == NULL || panel->rows->len == 0)
+            widget_erase (w);
         show_dir (panel);
         panel_print_header (panel);
         adjust_top_file (panel);
@@ -3650,6 +3858,10 @@ panel_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm, void *d
         panel->dirty = 0;
         return MSG_HANDLED;
 
+    case MSG_RESIZE:
+        panel_invalidate_rows (panel);
+        return MSG_HANDLED;
+
     case MSG_FOCUS:
         state_mark = -1;
         current_panel = panel;
@@ -3947,6 +4159,7 @@ reload_panelized (WPanel * panel)
 {
     int i, j;
     dir_list *list = &panel->dir;
+    struct stat st;
 
     /* refresh current VFS directory required for vfs_path_from_str() */
     (void) mc_chdir (panel->cwd_vpath);
@@ -3956,10 +4169,13 @@ reload_panelized (WPanel * panel)
         vfs_path_t *vpath;
 
         vpath = vfs_path_from_str (list->list[i].fname);
-        if (mc_lstat (vpath, &list->list[i].st) != 0)
-            g_free (list->list[i].fname);
+        if (mc_lstat (vpath, &st) != 0)
+            dir_list_free_entry (list, &list->list[i]);
         else
         {
+            file_stat_from_stat (&list->list[i].st, &st);
+            /* file type might be changed */
+            list->list[i].color_generation = 0;
             if (j != i)
                 list->list[j] = list->list[i];
             j++;
@@ -3971,6 +4187,8 @@ reload_panelized (WPanel * panel)
     else
         list->len = j;
 
+    quick_search_free (&panel->quick_search);
+
     recalculate_panel_summary (panel);
 
     if (panel != current_panel)
@@ -4199,6 +4417,8 @@ panel_clean_dir (WPanel * panel)
     panel->dirs_marked = 0;
     panel->total = 0;
     panel->searching = FALSE;
+    quick_search_free (&panel->quick_search);
+    panel_drop_cells (panel);
     panel->is_panelized = FALSE;
     panel->dirty = 1;
     panel->content_shift = -1;
@@ -4207,6 +4427,21 @@ panel_clean_dir (WPanel * panel)
     dir_list_free_list (&panel->dir);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget what is painted in the panel rows. The panel will be erased and repainted entirely
+ * on the next redraw. Should be called if something else has painted over the panel.
+ *
+ * @param panel panel object
+ */
+
+void
+panel_invalidate_rows (WPanel * panel)
+{
+    if (panel->rows != NULL)
+        g_array_set_size (panel->rows, 0);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Set Up panel's current dir object
@@ -4413,6 +4648,7 @@ panel_reload (WPanel * panel)
 
     dir_list_reload (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                      &panel->sort_info, panel->filter);
+    quick_search_free (&panel->quick_search);
 
     panel->dirty = 1;
     if (panel->selected >= panel->dir.len)
@@ -4464,6 +4700,10 @@ set_panel_formats (WPanel * p)
 
     panel_update_cols (WIDGET (p), p->frame_size);
 
+    /* fields and columns are changed */
+    panel_drop_cells (p);
+    panel_invalidate_rows (p);
+
     if (retcode)
         message (D_ERROR, _("Warning"),
                  _("User supplied format looks invalid, reverting to default."));
@@ -4554,27 +4794,27 @@ do_file_mark (WPanel * panel, int idx, int mark)
     {
         panel->marked++;
 
-        if (S_ISDIR (panel->dir.list[idx].st.st_mode))
+        if (S_ISDIR (panel->dir.list[idx].st.mode))
         {
             if (panel->dir.list[idx].f.dir_size_computed)
-                panel->total += (uintmax_t) panel->dir.list[idx].st.st_size;
+                panel->total += (uintmax_t) panel->dir.list[idx].st.size;
             panel->dirs_marked++;
         }
         else
-            panel->total += (uintmax_t) panel->dir.list[idx].st.st_size;
+            panel->total += (uintmax_t) panel->dir.list[idx].st.size;
 
         set_colors (panel);
     }
     else
     {
-        if (S_ISDIR (panel->dir.list[idx].st.st_mode))
+        if (S_ISDIR (panel->dir.list[idx].st.mode))
         {
             if (panel->dir.list[idx].f.dir_size_computed)
-                panel->total -= (uintmax_t) panel->dir.list[idx].st.st_size;
+                panel->total -= (uintmax_t) panel->dir.list[idx].st.size;
             panel->dirs_marked--;
         }
         else
-            panel->total -= (uintmax_t) panel->dir.list[idx].st.st_size;
+            panel->total -= (uintmax_t) panel->dir.list[idx].st.size;
 
         panel->marked--;
     }
@@ -4622,6 +4862,7 @@ panel_re_sort (WPanel * panel)
     filename = g_strdup (selection (panel)->fname);
     unselect_item (panel);
     dir_list_sort (&panel->dir, panel->sort_field->sort_routine, &panel->sort_info);
+    quick_search_free (&panel->quick_search);
     panel->selected = -1;
 
     for (i = panel->dir.len; i != 0; i--)
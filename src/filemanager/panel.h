@@ -15,6 +15,7 @@
 #include "lib/filehighlight.h"
 
 #include "dir.h"                /* dir_list */
+#include "quicksearch.h"        /* quick_search_t */
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -131,12 +132,16 @@ typedef struct
 #endif
 
     gboolean searching;
+    quick_search_t *quick_search;       /* index of file names, built on first search */
     char search_buffer[MC_MAXFILENAMELEN];
     char prev_search_buffer[MC_MAXFILENAMELEN];
     char search_char[MB_LEN_MAX];       /*buffer for multibytes characters */
     int search_chpoint;         /*point after last characters in search_char */
     int content_shift;          /* Number of characters of filename need to skip from left side. */
     int max_shift;              /* Max shift for visible part of current panel */
+
+    GArray *rows;               /* state of rows on the screen, empty if the panel must be erased */
+    GHashTable *cells;          /* formatted fields of shown files by file index */
 } WPanel;
 
 /*** global variables defined in .c file *********************************************************/
@@ -154,6 +159,7 @@ WPanel *panel_sized_with_dir_new (const char *panel_name, int y, int x, int line
                                   const vfs_path_t * vpath);
 
 void panel_clean_dir (WPanel * panel);
+void panel_invalidate_rows (WPanel * panel);
 
 void panel_reload (WPanel * panel);
 void panel_set_sort_order (WPanel * panel, const panel_field_t * sort_order);
@@ -393,8 +393,8 @@ do_panelize_cd (WPanel * panel)
         if (panelized_same || DIR_IS_DOTDOT (panelized_panel.list.list[i].fname))
         {
             list->list[i].fnamelen = panelized_panel.list.list[i].fnamelen;
-            list->list[i].fname = g_strndup (panelized_panel.list.list[i].fname,
-                                             panelized_panel.list.list[i].fnamelen);
+            list->list[i].fname = dir_list_name_dup (list, panelized_panel.list.list[i].fname,
+                                                     panelized_panel.list.list[i].fnamelen);
         }
         else
         {
@@ -406,7 +406,7 @@ do_panelize_cd (WPanel * panel)
                                      (char *) NULL);
             fname = vfs_path_as_str (tmp_vpath);
             list->list[i].fnamelen = strlen (fname);
-            list->list[i].fname = g_strndup (fname, list->list[i].fnamelen);
+            list->list[i].fname = dir_list_name_dup (list, fname, list->list[i].fnamelen);
             vfs_path_free (tmp_vpath);
         }
         list->list[i].f.link_to_dir = panelized_panel.list.list[i].f.link_to_dir;
@@ -414,8 +414,9 @@ do_panelize_cd (WPanel * panel)
         list->list[i].f.dir_size_computed = panelized_panel.list.list[i].f.dir_size_computed;
         list->list[i].f.marked = panelized_panel.list.list[i].f.marked;
         list->list[i].st = panelized_panel.list.list[i].st;
-        list->list[i].sort_key = panelized_panel.list.list[i].sort_key;
-        list->list[i].second_sort_key = panelized_panel.list.list[i].second_sort_key;
+        list->list[i].sort_key = NULL;
+        list->list[i].second_sort_key = NULL;
+        list->list[i].color_generation = 0;
     }
 
     panel->is_panelized = TRUE;
@@ -462,14 +463,16 @@ panelize_save_panel (WPanel * panel)
     {
         panelized_panel.list.list[i].fnamelen = list->list[i].fnamelen;
         panelized_panel.list.list[i].fname =
-            g_strndup (list->list[i].fname, list->list[i].fnamelen);
+            dir_list_name_dup (&panelized_panel.list, list->list[i].fname,
+                               list->list[i].fnamelen);
         panelized_panel.list.list[i].f.link_to_dir = list->list[i].f.link_to_dir;
         panelized_panel.list.list[i].f.stale_link = list->list[i].f.stale_link;
         panelized_panel.list.list[i].f.dir_size_computed = list->list[i].f.dir_size_computed;
         panelized_panel.list.list[i].f.marked = list->list[i].f.marked;
         panelized_panel.list.list[i].st = list->list[i].st;
-        panelized_panel.list.list[i].sort_key = list->list[i].sort_key;
-        panelized_panel.list.list[i].second_sort_key = list->list[i].second_sort_key;
+        panelized_panel.list.list[i].sort_key = NULL;
+        panelized_panel.list.list[i].second_sort_key = NULL;
+        panelized_panel.list.list[i].color_generation = 0;
     }
 }
 
@@ -0,0 +1,664 @@
+/*
+   Incremental quick search of file names in the panel.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file quicksearch.c
+ *  \brief Source: incremental quick search of file names in the panel
+ *
+ * Three kinds of patterns are handled:
+ *  - plain pattern is a prefix of file name: it is looked up by binary search
+ *    in the index of names sorted in byte order;
+ *  - pattern with wildcards '*' and '?' is matched as glob. The first set of candidates
+ *    is taken from the index by the literal head of pattern;
+ *  - in fuzzy mode the characters of pattern must occur in file name in the same order.
+ *    Matches are ranked by score which prefers consecutive characters and word boundaries.
+ *
+ * Candidates of wildcard and fuzzy patterns are kept for each typed part of pattern:
+ * typing one more character filters the previous set, backspace returns to it.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "lib/global.h"
+#include "lib/search.h"
+#include "lib/strescape.h"
+
+#include "quicksearch.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define QS_NO_MATCH G_MININT
+
+/* fuzzy scores */
+#define QS_SCORE_MATCH 16
+#define QS_SCORE_GAP_START (-3)
+#define QS_SCORE_GAP_EXTENSION (-1)
+#define QS_BONUS_BOUNDARY 8
+#define QS_BONUS_CAMEL (QS_BONUS_BOUNDARY - 1)
+#define QS_BONUS_CONSECUTIVE 4
+#define QS_BONUS_FIRST_CHAR_MULTIPLIER 2
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    char *pattern;
+    GArray *entries;            /* numbers of matching entries in list order */
+    GArray *scores;             /* fuzzy scores of entries */
+} quick_search_level_t;
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline const char *
+quick_search_key (const quick_search_t * qs, int i)
+{
+    return qs->folded == NULL ? qs->entries[i].fname : qs->folded->str + qs->offsets[i];
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+quick_search_fold (const char *s, gssize len)
+{
+    if (g_utf8_validate (s, len, NULL))
+        return g_utf8_casefold (s, len);
+
+    return g_ascii_strdown (s, len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+quick_search_level_free (gpointer data)
+{
+    quick_search_level_t *level = (quick_search_level_t *) data;
+
+    g_free (level->pattern);
+    g_array_free (level->entries, TRUE);
+    if (level->scores != NULL)
+        g_array_free (level->scores, TRUE);
+    g_free (level);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+quick_search_clean (quick_search_t * qs)
+{
+    if (qs->folded != NULL)
+    {
+        g_string_free (qs->folded, TRUE);
+        qs->folded = NULL;
+    }
+    MC_PTR_FREE (qs->offsets);
+    MC_PTR_FREE (qs->sorted);
+    g_ptr_array_set_size (qs->levels, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Take the current state of directory list.
+ */
+
+static void
+quick_search_build (quick_search_t * qs)
+{
+    int i;
+
+    quick_search_clean (qs);
+
+    qs->entries = qs->list->list;
+    qs->len = qs->list->len;
+
+    if (qs->case_sensitive)
+        return;
+
+    qs->folded = g_string_sized_new (qs->len * 16);
+    qs->offsets = g_new (gsize, qs->len);
+
+    for (i = 0; i < qs->len; i++)
+    {
+        char *fold;
+
+        fold = quick_search_fold (qs->entries[i].fname, qs->entries[i].fnamelen);
+        qs->offsets[i] = qs->folded->len;
+        /* keep terminating zero */
+        g_string_append_len (qs->folded, fold, strlen (fold) + 1);
+        g_free (fold);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gint
+quick_search_sorted_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const quick_search_t *qs = (const quick_search_t *) user_data;
+
+    return strcmp (quick_search_key (qs, *(const int *) a), quick_search_key (qs, *(const int *) b));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gint
+quick_search_int_cmp (gconstpointer a, gconstpointer b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find entries with names starting with prefix.
+ *
+ * @param qs quick search
+ * @param prefix prefix, already folded
+ * @param lo place to store the first position in the sorted index
+ * @param hi place to store the position after the last one
+ */
+
+static void
+quick_search_prefix_range (quick_search_t * qs, const char *prefix, int *lo, int *hi)
+{
+    size_t len;
+    int l, h;
+
+    if (qs->sorted == NULL)
+    {
+        int i;
+
+        qs->sorted = g_new (int, qs->len);
+        for (i = 0; i < qs->len; i++)
+            qs->sorted[i] = i;
+        g_qsort_with_data (qs->sorted, qs->len, sizeof (int), quick_search_sorted_cmp, qs);
+    }
+
+    len = strlen (prefix);
+
+    /* first name not less than prefix */
+    for (l = 0, h = qs->len; l < h;)
+    {
+        int m = l + (h - l) / 2;
+
+        if (strcmp (quick_search_key (qs, qs->sorted[m]), prefix) < 0)
+            l = m + 1;
+        else
+            h = m;
+    }
+
+    *lo = l;
+
+    /* first name not starting with prefix */
+    for (h = qs->len; l < h;)
+    {
+        int m = l + (h - l) / 2;
+
+        if (strncmp (quick_search_key (qs, qs->sorted[m]), prefix, len) == 0)
+            l = m + 1;
+        else
+            h = m;
+    }
+
+    *hi = l;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+quick_search_find_prefix (quick_search_t * qs, const char *prefix, int current)
+{
+    int lo, hi, i;
+    int first = -1, next = -1;
+
+    quick_search_prefix_range (qs, prefix, &lo, &hi);
+
+    /* the nearest entry at or after the cursor, otherwise the first one */
+    for (i = lo; i < hi; i++)
+    {
+        int e = qs->sorted[i];
+
+        if (first == -1 || e < first)
+            first = e;
+        if (e >= current && (next == -1 || e < next))
+            next = e;
+    }
+
+    return next != -1 ? next : first;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline size_t
+quick_search_char_len (const quick_search_t * qs, const char *s)
+{
+    size_t len, i;
+
+    if (!qs->utf8)
+        return 1;
+
+    len = g_utf8_skip[(guchar) s[0]];
+    /* don't step over the end of broken string */
+    for (i = 1; i < len; i++)
+        if (s[i] == '\0')
+            return i;
+
+    return len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline const char *
+quick_search_prev_char (const quick_search_t * qs, const char *str, const char *s)
+{
+    if (s <= str)
+        return NULL;
+
+    return qs->utf8 ? g_utf8_find_prev_char (str, s) : s - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+quick_search_bonus (const char *text, const char *t)
+{
+    if (t == text || strchr ("/._- ", t[-1]) != NULL)
+        return QS_BONUS_BOUNDARY;
+    if (g_ascii_islower (t[-1]) && g_ascii_isupper (t[0]))
+        return QS_BONUS_CAMEL;
+    if (g_ascii_isdigit (t[0]) && !g_ascii_isdigit (t[-1]))
+        return QS_BONUS_CAMEL;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Match pattern as a subsequence of text and score the match.
+ *
+ * The first match is found by forward scan, then backward scan from its end finds
+ * the shortest window containing the pattern, and the window is scored.
+ *
+ * @return score or QS_NO_MATCH
+ */
+
+static int
+quick_search_fuzzy_score (const quick_search_t * qs, const char *text, const char *pattern)
+{
+    const char *t, *p, *pe, *start, *end, *prev_end = NULL;
+    int score = 0, chunk_bonus = 0;
+    gboolean first = TRUE;
+
+    /* forward scan */
+    for (t = text, p = pattern; *p != '\0' && *t != '\0';)
+    {
+        size_t tl, pl;
+
+        tl = quick_search_char_len (qs, t);
+        pl = quick_search_char_len (qs, p);
+        if (tl == pl && memcmp (t, p, tl) == 0)
+            p += pl;
+        t += tl;
+    }
+
+    if (*p != '\0')
+        return QS_NO_MATCH;
+
+    end = t;
+
+    /* backward scan */
+    start = text;
+    pe = pattern + strlen (pattern);
+    p = quick_search_prev_char (qs, pattern, pe);
+    for (t = quick_search_prev_char (qs, text, end); p != NULL && t != NULL;
+         t = quick_search_prev_char (qs, text, t))
+    {
+        size_t tl;
+
+        tl = quick_search_char_len (qs, t);
+        if (tl == (size_t) (pe - p) && memcmp (t, p, tl) == 0)
+        {
+            pe = p;
+            p = quick_search_prev_char (qs, pattern, pe);
+            if (p == NULL)
+                start = t;
+        }
+    }
+
+    /* score the window */
+    for (t = start, p = pattern; *p != '\0' && t < end;)
+    {
+        size_t tl, pl;
+
+        tl = quick_search_char_len (qs, t);
+        pl = quick_search_char_len (qs, p);
+        if (tl == pl && memcmp (t, p, tl) == 0)
+        {
+            int bonus;
+
+            bonus = quick_search_bonus (text, t);
+
+            if (prev_end == t)
+            {
+                /* consecutive characters get the bonus of the chunk start */
+                chunk_bonus = MAX (chunk_bonus, MAX (bonus, QS_BONUS_CONSECUTIVE));
+                bonus = chunk_bonus;
+            }
+            else
+            {
+                if (prev_end != NULL)
+                {
+                    long gap;
+
+                    gap = qs->utf8 ? g_utf8_strlen (prev_end, t - prev_end) : t - prev_end;
+                    score += QS_SCORE_GAP_START + QS_SCORE_GAP_EXTENSION * (int) (gap - 1);
+                }
+                chunk_bonus = bonus;
+            }
+
+            if (first)
+            {
+                bonus *= QS_BONUS_FIRST_CHAR_MULTIPLIER;
+                first = FALSE;
+            }
+
+            score += QS_SCORE_MATCH + bonus;
+            prev_end = t + tl;
+            p += pl;
+        }
+        t += tl;
+    }
+
+    return score;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Fill candidates of the level using candidates of the base level
+ * (or the whole list if there is no base level).
+ */
+
+static void
+quick_search_filter (quick_search_t * qs, const quick_search_level_t * base,
+                     quick_search_level_t * level, const char *folded_pattern)
+{
+    mc_search_t *search = NULL;
+    GArray *head = NULL;
+    const GArray *src = NULL;
+    guint i, n;
+
+    if (base != NULL)
+        src = base->entries;
+
+    if (qs->fuzzy)
+        level->scores = g_array_new (FALSE, FALSE, sizeof (int));
+    else
+    {
+        char *reg_exp, *esc_str;
+
+        reg_exp = g_strdup_printf ("%s*", level->pattern);
+        esc_str = strutils_escape (reg_exp, -1, ",|\\{}[]", TRUE);
+        search = mc_search_new (esc_str, NULL);
+        search->search_type = MC_SEARCH_T_GLOB;
+        search->is_entire_line = TRUE;
+        search->is_case_sensitive = qs->case_sensitive;
+        g_free (reg_exp);
+        g_free (esc_str);
+
+        if (src == NULL)
+        {
+            /* the literal head of pattern selects the first candidates from the index */
+            char *prefix;
+            int lo, hi;
+
+            prefix = g_strndup (folded_pattern, strcspn (folded_pattern, "*?"));
+            quick_search_prefix_range (qs, prefix, &lo, &hi);
+            g_free (prefix);
+
+            head = g_array_sized_new (FALSE, FALSE, sizeof (int), hi - lo);
+            g_array_append_vals (head, qs->sorted + lo, hi - lo);
+            g_array_sort (head, quick_search_int_cmp);
+            src = head;
+        }
+    }
+
+    n = src != NULL ? src->len : (guint) qs->len;
+
+    for (i = 0; i < n; i++)
+    {
+        int e;
+
+        e = src != NULL ? g_array_index (src, int, i) : (int) i;
+
+        if (qs->fuzzy)
+        {
+            int score;
+
+            score = quick_search_fuzzy_score (qs, quick_search_key (qs, e), folded_pattern);
+            if (score != QS_NO_MATCH)
+            {
+                g_array_append_val (level->entries, e);
+                g_array_append_val (level->scores, score);
+            }
+        }
+        else if (mc_search_run (search, qs->entries[e].fname, 0, qs->entries[e].fnamelen, NULL))
+            g_array_append_val (level->entries, e);
+    }
+
+    if (head != NULL)
+        g_array_free (head, TRUE);
+    mc_search_free (search);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get candidates of pattern, computing them from candidates of the longest typed part.
+ */
+
+static const quick_search_level_t *
+quick_search_get_level (quick_search_t * qs, const char *pattern, const char *folded_pattern)
+{
+    quick_search_level_t *top = NULL, *level;
+
+    /* drop candidates of patterns which are not a part of this one */
+    while (qs->levels->len != 0)
+    {
+        top = (quick_search_level_t *) g_ptr_array_index (qs->levels, qs->levels->len - 1);
+        if (g_str_has_prefix (pattern, top->pattern))
+            break;
+        g_ptr_array_remove_index (qs->levels, qs->levels->len - 1);
+        top = NULL;
+    }
+
+    if (top != NULL && strcmp (top->pattern, pattern) == 0)
+        return top;
+
+    level = g_new0 (quick_search_level_t, 1);
+    level->pattern = g_strdup (pattern);
+    level->entries = g_array_new (FALSE, FALSE, sizeof (int));
+    quick_search_filter (qs, top, level, folded_pattern);
+    g_ptr_array_add (qs->levels, level);
+
+    return level;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare fuzzy matches: higher score, shorter name, then list order.
+ *
+ * @return TRUE if the first match is better
+ */
+
+static gboolean
+quick_search_fuzzy_better (const quick_search_t * qs, int e1, int score1, int e2, int score2)
+{
+    if (score1 != score2)
+        return score1 > score2;
+    if (qs->entries[e1].fnamelen != qs->entries[e2].fnamelen)
+        return qs->entries[e1].fnamelen < qs->entries[e2].fnamelen;
+    return e1 < e2;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+quick_search_find_fuzzy (const quick_search_t * qs, const quick_search_level_t * level, int current,
+                         gboolean next)
+{
+    int best = -1, best_score = 0;
+    int after = -1, after_score = 0;
+    int current_score = QS_NO_MATCH;
+    guint i;
+
+    if (next)
+        for (i = 0; i < level->entries->len; i++)
+            if (g_array_index (level->entries, int, i) == current)
+            {
+                current_score = g_array_index (level->scores, int, i);
+                break;
+            }
+
+    for (i = 0; i < level->entries->len; i++)
+    {
+        int e, score;
+
+        e = g_array_index (level->entries, int, i);
+        score = g_array_index (level->scores, int, i);
+
+        if (best == -1 || quick_search_fuzzy_better (qs, e, score, best, best_score))
+        {
+            best = e;
+            best_score = score;
+        }
+
+        /* the best of matches ranked after the current one */
+        if (current_score != QS_NO_MATCH
+            && quick_search_fuzzy_better (qs, current, current_score, e, score)
+            && (after == -1 || quick_search_fuzzy_better (qs, e, score, after, after_score)))
+        {
+            after = e;
+            after_score = score;
+        }
+    }
+
+    return after != -1 ? after : best;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create quick search of the directory list.
+ *
+ * Index is built on the first search and rebuilt if the list is changed.
+ *
+ * @param list directory list
+ * @param case_sensitive TRUE for case sensitive search
+ * @param fuzzy TRUE for fuzzy search
+ *
+ * @return new quick search object
+ */
+
+quick_search_t *
+quick_search_new (const dir_list * list, gboolean case_sensitive, gboolean fuzzy)
+{
+    quick_search_t *qs;
+
+    qs = g_new0 (quick_search_t, 1);
+    qs->list = list;
+    qs->case_sensitive = case_sensitive;
+    qs->fuzzy = fuzzy;
+    qs->utf8 = mc_global.utf8_display;
+    qs->len = -1;
+    qs->levels = g_ptr_array_new_with_free_func (quick_search_level_free);
+
+    return qs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+quick_search_free (quick_search_t ** qs)
+{
+    if (qs == NULL || *qs == NULL)
+        return;
+
+    quick_search_clean (*qs);
+    g_ptr_array_free ((*qs)->levels, TRUE);
+    MC_PTR_FREE (*qs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find file name matching the pattern.
+ *
+ * @param qs quick search object
+ * @param pattern search pattern
+ * @param current number of the current entry
+ * @param next in fuzzy mode, find the match ranked after the current one
+ *
+ * @return number of found entry, or -1 if nothing matches. Glob and prefix search
+ * return the first match at or after the current entry, fuzzy search returns the best match
+ */
+
+int
+quick_search_find (quick_search_t * qs, const char *pattern, int current, gboolean next)
+{
+    char *folded_pattern;
+    int ret;
+
+    if (qs->entries != qs->list->list || qs->len != qs->list->len)
+        quick_search_build (qs);
+
+    folded_pattern = qs->case_sensitive ? g_strdup (pattern) : quick_search_fold (pattern, -1);
+
+    if (qs->fuzzy)
+        ret = quick_search_find_fuzzy (qs, quick_search_get_level (qs, pattern, folded_pattern),
+                                       current, next);
+    else if (strpbrk (pattern, "*?") == NULL)
+        ret = quick_search_find_prefix (qs, folded_pattern, current);
+    else
+    {
+        const quick_search_level_t *level;
+        guint i;
+
+        level = quick_search_get_level (qs, pattern, folded_pattern);
+
+        ret = level->entries->len != 0 ? g_array_index (level->entries, int, 0) : -1;
+        for (i = 0; i < level->entries->len; i++)
+            if (g_array_index (level->entries, int, i) >= current)
+            {
+                ret = g_array_index (level->entries, int, i);
+                break;
+            }
+    }
+
+    g_free (folded_pattern);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
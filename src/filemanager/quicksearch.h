@@ -0,0 +1,43 @@
+/** \file quicksearch.h
+ *  \brief Header: incremental quick search of file names in the panel
+ */
+
+#ifndef MC__QUICKSEARCH_H
+#define MC__QUICKSEARCH_H
+
+#include "lib/global.h"
+
+#include "dir.h"                /* dir_list */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct quick_search_struct
+{
+    const dir_list *list;
+    file_entry_t *entries;      /* list->list and list->len when the index was built */
+    int len;
+    gboolean case_sensitive;
+    gboolean fuzzy;
+    gboolean utf8;
+
+    GString *folded;            /* case folded names if search is case insensitive */
+    gsize *offsets;             /* offsets of names in folded */
+    int *sorted;                /* entries sorted by name, built on demand */
+    GPtrArray *levels;          /* candidates for each typed part of pattern */
+} quick_search_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+quick_search_t *quick_search_new (const dir_list * list, gboolean case_sensitive, gboolean fuzzy);
+void quick_search_free (quick_search_t ** qs);
+int quick_search_find (quick_search_t * qs, const char *pattern, int current, gboolean next);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__QUICKSEARCH_H */
@@ -27,6 +27,8 @@
 #define MC_HISTORY_FM_PANELIZE_ADD    "mc.fm.panelize.add"
 #define MC_HISTORY_FM_FILTERED_VIEW   "mc.fm.filtered-view"
 #define MC_HISTORY_FM_PANEL_FILTER    "mc.fm.panel-filter"
+#define MC_HISTORY_FM_SELECT_SIZE     "mc.fm.select.size"
+#define MC_HISTORY_FM_SELECT_AGE      "mc.fm.select.age"
 #define MC_HISTORY_FM_MENU_EXEC_PARAM "mc.fm.menu.exec.parameter"
 
 #define MC_HISTORY_ESC_TIMEOUT        "mc.esc.timeout"
@@ -42,6 +42,9 @@
 #include "lib/util.h"
 #include "lib/widget.h"
 
+#ifdef ENABLE_VFS_NET
+#include "lib/vfs/dircache.h"
+#endif
 #ifdef ENABLE_VFS_FTP
 #include "src/vfs/ftpfs/ftpfs.h"
 #endif
@@ -146,6 +149,7 @@ panels_options_t panels_options = {
     .filetype_mode = TRUE,
     .permission_mode = FALSE,
     .qsearch_mode = QSEARCH_PANEL_CASE,
+    .qsearch_fuzzy = FALSE,
     .torben_fj_mode = FALSE,
     .select_flags = SELECT_MATCH_CASE | SELECT_SHELL_PATTERNS
 };
@@ -371,6 +375,9 @@ static const struct
     { "num_history_items_recorded", &num_history_items_recorded },
 #ifdef ENABLE_VFS
     { "vfs_timeout", &vfs_timeout },
+#ifdef ENABLE_VFS_NET
+    { "vfs_dircache_max_age", &vfs_dircache_max_age },
+#endif /* ENABLE_VFS_NET */
 #ifdef ENABLE_VFS_FTP
     { "ftpfs_directory_timeout", &ftpfs_directory_timeout },
     { "ftpfs_retry_seconds", &ftpfs_retry_seconds },
@@ -397,6 +404,7 @@ static const struct
 #ifdef USE_INTERNAL_EDIT
     { "editor_backup_extension", &option_backup_ext, "~" },
     { "editor_filesize_threshold", &option_filesize_threshold, "64M" },
+    { "editor_undo_memory_limit", &option_undo_memory_limit, "4M" },
     { "editor_stop_format_chars", &option_stop_format_chars, "-+*\\,.;:&>" },
 #endif
     { "mcview_eof", &mcview_show_eof, "" },
@@ -424,6 +432,7 @@ static const struct
     { "mouse_move_pages",  &panels_options.mouse_move_pages },
     { "filetype_mode", &panels_options.filetype_mode },
     { "permission_mode", &panels_options.permission_mode },
+    { "quick_search_fuzzy", &panels_options.qsearch_fuzzy },
     { "torben_fj_mode", &panels_options.torben_fj_mode },
     { NULL, NULL }
 };
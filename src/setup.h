@@ -53,6 +53,7 @@ typedef struct
     gboolean filetype_mode;     /* If TRUE then add per file type hilighting */
     gboolean permission_mode;   /* If TRUE, we use permission hilighting */
     qsearch_mode_t qsearch_mode;        /* Quick search mode */
+    gboolean qsearch_fuzzy;     /* If TRUE, quick search matches characters in any positions */
     gboolean torben_fj_mode;    /* If TRUE, use some usability hacks by Torben */
     panel_select_flags_t select_flags;  /* Select/unselect file flags */
 } panels_options_t;
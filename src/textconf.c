@@ -53,6 +53,12 @@ static const char *const vfs_supported[] = {
 #ifdef ENABLE_VFS_TAR
     "tarfs",
 #endif
+#ifdef ENABLE_VFS_ZIP
+    "zipfs",
+#endif
+#ifdef ENABLE_VFS_DECOMPRESS
+    "decompressfs",
+#endif
 #ifdef ENABLE_VFS_SFS
     "sfs",
 #endif
@@ -165,7 +165,7 @@ static gboolean
 test_type (WPanel * panel, char *arg)
 {
     int result = 0;             /* False by default */
-    mode_t st_mode = panel->dir.list[panel->selected].st.st_mode;
+    mode_t st_mode = panel->dir.list[panel->selected].st.mode;
 
     for (; *arg != '\0'; arg++)
     {
@@ -0,0 +1,1110 @@
+/*
+   Virtual File System: in-process decompression of single files.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: Virtual File System: in-process decompression of single files
+ *
+ *  Handles "ugz", "ubz2", "uxz", "ulzma" and "uzst" suffixes (the ones returned by
+ *  decompress_extension()) instead of sfs. The data is decoded by compression libraries
+ *  while it is read, so tarfs, cpiofs and the viewer don't wait for the whole file to be
+ *  expanded into temporary one.
+ *
+ *  Decoding is sequential, but restart points are recorded on the way: state of deflate
+ *  decoder at block boundaries (input position and last 32K of output) and offsets
+ *  of zstd frames. A backward seek, e.g. tarfs reading a member after the archive was
+ *  scanned, resumes from the nearest restart point instead of the beginning of file.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <zlib.h>
+#ifdef HAVE_LIBBZ2
+#include <bzlib.h>
+#endif
+#ifdef HAVE_LIBLZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "lib/global.h"
+
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/utilvfs.h"
+#include "lib/vfs/xdirentry.h"
+
+#include "decompress.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* size of deflate window, also size of buffer of decoded data */
+#define DECOMPRESS_WINSIZE 32768
+
+/* initial distance between restart points in decoded data */
+#define DECOMPRESS_SPAN (1024 * 1024)
+
+/* when this number of restart points is reached, every other one is dropped */
+#define DECOMPRESS_MAX_POINTS 256
+
+#define DECOMPRESS_FH(a) ((decompress_fh_t *) (a))
+
+/*** file scope type declarations ****************************************************************/
+
+typedef enum
+{
+    DECOMPRESS_GZIP = 0,
+    DECOMPRESS_BZIP2,
+    DECOMPRESS_XZ,
+    DECOMPRESS_LZMA,
+    DECOMPRESS_ZSTD
+} decompress_type_t;
+
+typedef struct
+{
+    off_t out;                  /* offset in decoded data */
+    off_t in;                   /* offset in compressed file */
+    int bits;                   /* deflate: number of unused bits of byte at (in - 1) */
+    unsigned char *window;      /* deflate: DECOMPRESS_WINSIZE bytes of data before out */
+} decompress_point_t;
+
+typedef struct
+{
+    decompress_type_t type;
+    int fd;                     /* handle of compressed file */
+
+    union
+    {
+        z_stream zs;
+#ifdef HAVE_LIBBZ2
+        bz_stream bz;
+#endif
+#ifdef HAVE_LIBLZMA
+        lzma_stream xz;
+#endif
+#ifdef HAVE_LIBZSTD
+        struct
+        {
+            ZSTD_DStream *ds;
+            ZSTD_inBuffer in;
+        } zstd;
+#endif
+    } d;
+    gboolean d_init;            /* decoder is initialized */
+    gboolean raw;               /* gzip: raw deflate data after restore, no header and trailer */
+    gboolean boundary;          /* between gzip members, bzip2 streams or zstd frames */
+    gboolean ended;             /* at least one member or stream has ended */
+
+    off_t in_pos;               /* offset of the end of data read to in_buf */
+    gboolean in_eof;            /* compressed file is read up to the end */
+    unsigned char in_buf[BUF_8K];
+
+    /* ring buffer with the last decoded data, it is the deflate window as well */
+    unsigned char out_buf[DECOMPRESS_WINSIZE];
+    size_t out_head;            /* write position in out_buf */
+    size_t out_fill;            /* number of valid bytes in out_buf */
+    off_t out_pos;              /* offset of decoded data at out_head */
+    gboolean eof;               /* all data is decoded */
+    off_t size;                 /* size of decoded data, -1 if unknown yet */
+
+    off_t pos;                  /* offset of reader */
+
+    GArray *points;             /* array of decompress_point_t sorted by offset */
+    off_t span;                 /* minimal distance between restart points */
+} decompress_fh_t;
+
+/*** file scope variables ************************************************************************/
+
+static struct vfs_class decompress_class;
+static struct vfs_class *vfs_decompress_ops = &decompress_class;
+
+static const struct
+{
+    const char *prefix;
+    decompress_type_t type;
+} decompress_prefixes[] =
+{
+    /* *INDENT-OFF* */
+    { "ugz", DECOMPRESS_GZIP },
+#ifdef HAVE_LIBBZ2
+    { "ubz2", DECOMPRESS_BZIP2 },
+#endif
+#ifdef HAVE_LIBLZMA
+    { "uxz", DECOMPRESS_XZ },
+    { "ulzma", DECOMPRESS_LZMA },
+#endif
+#ifdef HAVE_LIBZSTD
+    { "uzst", DECOMPRESS_ZSTD },
+#endif
+    /* *INDENT-ON* */
+};
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read next portion of compressed file to the input buffer.
+ *
+ * @return number of read bytes, 0 at the end of file, -1 on error
+ */
+
+static ssize_t
+decompress_fill (decompress_fh_t * fh)
+{
+    ssize_t n;
+
+    n = mc_read (fh->fd, fh->in_buf, sizeof (fh->in_buf));
+    if (n > 0)
+        fh->in_pos += n;
+    else if (n == 0)
+        fh->in_eof = TRUE;
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+decompress_add_point (decompress_fh_t * fh, size_t produced, off_t in, int bits)
+{
+    decompress_point_t p;
+    off_t last = 0;
+
+    p.out = fh->out_pos + (off_t) produced;
+
+    if (fh->points->len != 0)
+        last = g_array_index (fh->points, decompress_point_t, fh->points->len - 1).out;
+    if (p.out - last < fh->span)
+        return;
+
+    if (fh->points->len >= DECOMPRESS_MAX_POINTS)
+    {
+        guint i;
+
+        /* keep memory bounded: make restart points twice sparser */
+        for (i = 0; i < fh->points->len; i++)
+        {
+            decompress_point_t *q;
+
+            q = &g_array_index (fh->points, decompress_point_t, i);
+            if (i % 2 == 0)
+                g_array_index (fh->points, decompress_point_t, i / 2) = *q;
+            else
+                g_free (q->window);
+        }
+        g_array_set_size (fh->points, (fh->points->len + 1) / 2);
+        fh->span *= 2;
+    }
+
+    p.in = in;
+    p.bits = bits;
+    p.window = NULL;
+
+    if (fh->type == DECOMPRESS_GZIP)
+    {
+        size_t start;
+
+        /* new data is already in out_buf, so window starts right after it */
+        start = (fh->out_head + produced) % DECOMPRESS_WINSIZE;
+        p.window = g_malloc (DECOMPRESS_WINSIZE);
+        memcpy (p.window, fh->out_buf + start, DECOMPRESS_WINSIZE - start);
+        memcpy (p.window + DECOMPRESS_WINSIZE - start, fh->out_buf, start);
+    }
+
+    g_array_append_val (fh->points, p);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** gzip ***/
+
+static gboolean
+decompress_gzip_init (decompress_fh_t * fh)
+{
+    memset (&fh->d.zs, 0, sizeof (fh->d.zs));
+    /* gzip header and trailer are checked by zlib */
+    return (inflateInit2 (&fh->d.zs, MAX_WBITS + 16) == Z_OK);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Skip 8-byte trailer of gzip member (CRC32 and size) after raw deflate data.
+ */
+
+static gboolean
+decompress_gzip_skip_trailer (decompress_fh_t * fh)
+{
+    z_stream *zs = &fh->d.zs;
+    size_t left = 8;
+
+    while (left != 0)
+    {
+        size_t n;
+
+        if (zs->avail_in == 0)
+        {
+            ssize_t r;
+
+            r = decompress_fill (fh);
+            if (r <= 0)
+                return FALSE;
+            zs->next_in = fh->in_buf;
+            zs->avail_in = (uInt) r;
+        }
+
+        n = MIN (left, zs->avail_in);
+        zs->next_in += n;
+        zs->avail_in -= (uInt) n;
+        left -= n;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+decompress_gzip_decode (decompress_fh_t * fh, unsigned char *buf, size_t len)
+{
+    z_stream *zs = &fh->d.zs;
+
+    zs->next_out = buf;
+    zs->avail_out = (uInt) len;
+
+    while (zs->avail_out == len)
+    {
+        int ret;
+
+        if (zs->avail_in == 0)
+        {
+            ssize_t n;
+
+            n = decompress_fill (fh);
+            if (n == -1)
+                return -1;
+            if (n == 0)
+            {
+                if (fh->boundary && fh->ended)
+                    return 0;
+                /* truncated file */
+                errno = EIO;
+                return -1;
+            }
+            zs->next_in = fh->in_buf;
+            zs->avail_in = (uInt) n;
+        }
+
+        ret = inflate (zs, Z_BLOCK);
+
+        if (ret == Z_DATA_ERROR && fh->boundary && fh->ended)
+            return 0;           /* ignore trailing garbage like gzip does */
+
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        {
+            errno = EIO;
+            return -1;
+        }
+
+        if (ret == Z_STREAM_END)
+        {
+            if (fh->raw && !decompress_gzip_skip_trailer (fh))
+            {
+                errno = EIO;
+                return -1;
+            }
+
+            /* file can contain several gzip members */
+            inflateReset2 (zs, MAX_WBITS + 16);
+            fh->raw = FALSE;
+            fh->boundary = TRUE;
+            fh->ended = TRUE;
+        }
+        else if ((zs->data_type & 128) != 0)
+        {
+            /* at the start of deflate block */
+            fh->boundary = FALSE;
+            if ((zs->data_type & 64) == 0)
+                decompress_add_point (fh, len - zs->avail_out, fh->in_pos - zs->avail_in,
+                                      zs->data_type & 7);
+        }
+    }
+
+    return (ssize_t) (len - zs->avail_out);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+decompress_gzip_restore (decompress_fh_t * fh, const decompress_point_t * p)
+{
+    z_stream *zs = &fh->d.zs;
+    off_t in;
+
+    if (inflateReset2 (zs, -MAX_WBITS) != Z_OK)
+        return FALSE;
+
+    in = p->in - (p->bits != 0 ? 1 : 0);
+    if (mc_lseek (fh->fd, in, SEEK_SET) != in)
+        return FALSE;
+    fh->in_pos = in;
+    zs->avail_in = 0;
+
+    if (p->bits != 0)
+    {
+        /* the first byte is used partially */
+        if (decompress_fill (fh) <= 0)
+            return FALSE;
+        zs->next_in = fh->in_buf + 1;
+        zs->avail_in = (uInt) (fh->in_pos - in - 1);
+        inflatePrime (zs, p->bits, fh->in_buf[0] >> (8 - p->bits));
+    }
+
+    if (inflateSetDictionary (zs, p->window, DECOMPRESS_WINSIZE) != Z_OK)
+        return FALSE;
+
+    memcpy (fh->out_buf, p->window, DECOMPRESS_WINSIZE);
+    fh->out_fill = DECOMPRESS_WINSIZE;
+    fh->raw = TRUE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** bzip2 ***/
+
+#ifdef HAVE_LIBBZ2
+static gboolean
+decompress_bzip2_init (decompress_fh_t * fh)
+{
+    memset (&fh->d.bz, 0, sizeof (fh->d.bz));
+    return (BZ2_bzDecompressInit (&fh->d.bz, 0, 0) == BZ_OK);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+decompress_bzip2_decode (decompress_fh_t * fh, unsigned char *buf, size_t len)
+{
+    bz_stream *bz = &fh->d.bz;
+
+    bz->next_out = (char *) buf;
+    bz->avail_out = (unsigned int) len;
+
+    while (bz->avail_out == len)
+    {
+        int ret;
+
+        if (bz->avail_in == 0)
+        {
+            ssize_t n;
+
+            n = decompress_fill (fh);
+            if (n == -1)
+                return -1;
+            if (n == 0)
+            {
+                if (fh->boundary && fh->ended)
+                    return 0;
+                errno = EIO;
+                return -1;
+            }
+            bz->next_in = (char *) fh->in_buf;
+            bz->avail_in = (unsigned int) n;
+        }
+
+        ret = BZ2_bzDecompress (bz);
+
+        if (ret == BZ_DATA_ERROR_MAGIC && fh->boundary && fh->ended)
+            return 0;           /* ignore trailing garbage like bzip2 does */
+
+        if (ret == BZ_STREAM_END)
+        {
+            /* concatenated streams, e.g. created by pbzip2 */
+            char *next_in = bz->next_in;
+            unsigned int avail_in = bz->avail_in;
+            char *next_out = bz->next_out;
+            unsigned int avail_out = bz->avail_out;
+
+            BZ2_bzDecompressEnd (bz);
+            if (BZ2_bzDecompressInit (bz, 0, 0) != BZ_OK)
+            {
+                fh->d_init = FALSE;
+                errno = ENOMEM;
+                return -1;
+            }
+            bz->next_in = next_in;
+            bz->avail_in = avail_in;
+            bz->next_out = next_out;
+            bz->avail_out = avail_out;
+            fh->boundary = TRUE;
+            fh->ended = TRUE;
+        }
+        else if (ret == BZ_OK)
+            fh->boundary = FALSE;
+        else
+        {
+            errno = EIO;
+            return -1;
+        }
+    }
+
+    return (ssize_t) (len - bz->avail_out);
+}
+#endif /* HAVE_LIBBZ2 */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** xz and lzma ***/
+
+#ifdef HAVE_LIBLZMA
+static gboolean
+decompress_xz_init (decompress_fh_t * fh)
+{
+    lzma_stream init = LZMA_STREAM_INIT;
+    lzma_ret ret;
+
+    fh->d.xz = init;
+    if (fh->type == DECOMPRESS_LZMA)
+        ret = lzma_alone_decoder (&fh->d.xz, UINT64_MAX);
+    else
+        ret = lzma_stream_decoder (&fh->d.xz, UINT64_MAX, LZMA_CONCATENATED);
+
+    return (ret == LZMA_OK);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+decompress_xz_decode (decompress_fh_t * fh, unsigned char *buf, size_t len)
+{
+    lzma_stream *xz = &fh->d.xz;
+
+    if (fh->ended)
+        return 0;
+
+    xz->next_out = buf;
+    xz->avail_out = len;
+
+    while (xz->avail_out == len)
+    {
+        lzma_ret ret;
+
+        if (xz->avail_in == 0 && !fh->in_eof)
+        {
+            ssize_t n;
+
+            n = decompress_fill (fh);
+            if (n == -1)
+                return -1;
+            xz->next_in = fh->in_buf;
+            xz->avail_in = (size_t) n;
+        }
+
+        ret = lzma_code (xz, fh->in_eof ? LZMA_FINISH : LZMA_RUN);
+        if (ret == LZMA_STREAM_END)
+        {
+            fh->ended = TRUE;
+            break;
+        }
+        if (ret != LZMA_OK)
+        {
+            errno = ret == LZMA_MEM_ERROR ? ENOMEM : EIO;
+            return -1;
+        }
+    }
+
+    return (ssize_t) (len - xz->avail_out);
+}
+#endif /* HAVE_LIBLZMA */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** zstd ***/
+
+#ifdef HAVE_LIBZSTD
+static gboolean
+decompress_zstd_init (decompress_fh_t * fh)
+{
+    fh->d.zstd.ds = ZSTD_createDStream ();
+    fh->d.zstd.in.src = fh->in_buf;
+    fh->d.zstd.in.size = 0;
+    fh->d.zstd.in.pos = 0;
+
+    return (fh->d.zstd.ds != NULL && !ZSTD_isError (ZSTD_initDStream (fh->d.zstd.ds)));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+decompress_zstd_decode (decompress_fh_t * fh, unsigned char *buf, size_t len)
+{
+    ZSTD_inBuffer *in = &fh->d.zstd.in;
+    ZSTD_outBuffer out = { buf, len, 0 };
+
+    while (out.pos == 0)
+    {
+        size_t ret;
+
+        if (in->pos == in->size)
+        {
+            ssize_t n;
+
+            n = decompress_fill (fh);
+            if (n == -1)
+                return -1;
+            if (n == 0)
+            {
+                if (fh->boundary)
+                    return 0;
+                errno = EIO;
+                return -1;
+            }
+            in->size = (size_t) n;
+            in->pos = 0;
+        }
+
+        ret = ZSTD_decompressStream (fh->d.zstd.ds, &out, in);
+        if (ZSTD_isError (ret))
+        {
+            errno = EIO;
+            return -1;
+        }
+
+        /* frame is decoded and flushed completely, the next one doesn't refer to it */
+        fh->boundary = (ret == 0);
+        if (fh->boundary)
+            decompress_add_point (fh, out.pos, fh->in_pos - (off_t) (in->size - in->pos), 0);
+    }
+
+    return (ssize_t) out.pos;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+decompress_zstd_restore (decompress_fh_t * fh, const decompress_point_t * p)
+{
+    if (ZSTD_isError (ZSTD_DCtx_reset (fh->d.zstd.ds, ZSTD_reset_session_only)))
+        return FALSE;
+
+    if (mc_lseek (fh->fd, p->in, SEEK_SET) != p->in)
+        return FALSE;
+    fh->in_pos = p->in;
+    fh->d.zstd.in.size = 0;
+    fh->d.zstd.in.pos = 0;
+    fh->boundary = TRUE;
+
+    return TRUE;
+}
+#endif /* HAVE_LIBZSTD */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** common ***/
+
+static void
+decompress_end (decompress_fh_t * fh)
+{
+    if (!fh->d_init)
+        return;
+
+    switch (fh->type)
+    {
+    case DECOMPRESS_GZIP:
+        inflateEnd (&fh->d.zs);
+        break;
+#ifdef HAVE_LIBBZ2
+    case DECOMPRESS_BZIP2:
+        BZ2_bzDecompressEnd (&fh->d.bz);
+        break;
+#endif
+#ifdef HAVE_LIBLZMA
+    case DECOMPRESS_XZ:
+    case DECOMPRESS_LZMA:
+        lzma_end (&fh->d.xz);
+        break;
+#endif
+#ifdef HAVE_LIBZSTD
+    case DECOMPRESS_ZSTD:
+        ZSTD_freeDStream (fh->d.zstd.ds);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    fh->d_init = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * (Re)start decoding from the beginning of file.
+ */
+
+static gboolean
+decompress_start (decompress_fh_t * fh)
+{
+    decompress_end (fh);
+
+    if (mc_lseek (fh->fd, 0, SEEK_SET) != 0)
+        return FALSE;
+
+    fh->in_pos = 0;
+    fh->in_eof = FALSE;
+    fh->raw = FALSE;
+    fh->boundary = TRUE;
+    fh->ended = FALSE;
+    fh->out_head = 0;
+    fh->out_fill = 0;
+    fh->out_pos = 0;
+    fh->eof = FALSE;
+
+    switch (fh->type)
+    {
+    case DECOMPRESS_GZIP:
+        fh->d_init = decompress_gzip_init (fh);
+        break;
+#ifdef HAVE_LIBBZ2
+    case DECOMPRESS_BZIP2:
+        fh->d_init = decompress_bzip2_init (fh);
+        break;
+#endif
+#ifdef HAVE_LIBLZMA
+    case DECOMPRESS_XZ:
+    case DECOMPRESS_LZMA:
+        fh->d_init = decompress_xz_init (fh);
+        break;
+#endif
+#ifdef HAVE_LIBZSTD
+    case DECOMPRESS_ZSTD:
+        fh->d_init = decompress_zstd_init (fh);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (!fh->d_init)
+        errno = ENOMEM;
+
+    return fh->d_init;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Continue decoding from the restart point.
+ */
+
+static gboolean
+decompress_restore (decompress_fh_t * fh, const decompress_point_t * p)
+{
+    gboolean ok = FALSE;
+
+    fh->in_eof = FALSE;
+    fh->ended = TRUE;
+    fh->boundary = FALSE;
+    fh->out_head = 0;
+    fh->out_fill = 0;
+    fh->out_pos = p->out;
+    fh->eof = FALSE;
+
+    switch (fh->type)
+    {
+    case DECOMPRESS_GZIP:
+        ok = decompress_gzip_restore (fh, p);
+        break;
+#ifdef HAVE_LIBZSTD
+    case DECOMPRESS_ZSTD:
+        ok = decompress_zstd_restore (fh, p);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    /* decoder state is undefined now, so begin from scratch next time */
+    if (!ok)
+        ok = decompress_start (fh);
+
+    return ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Decode next portion of data to the ring buffer.
+ *
+ * @return number of decoded bytes, 0 at the end of data, -1 on error
+ */
+
+static ssize_t
+decompress_step (decompress_fh_t * fh)
+{
+    unsigned char *buf;
+    size_t len;
+    ssize_t n = -1;
+
+    if (fh->eof)
+        return 0;
+
+    if (!fh->d_init)
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    buf = fh->out_buf + fh->out_head;
+    len = DECOMPRESS_WINSIZE - fh->out_head;
+
+    switch (fh->type)
+    {
+    case DECOMPRESS_GZIP:
+        n = decompress_gzip_decode (fh, buf, len);
+        break;
+#ifdef HAVE_LIBBZ2
+    case DECOMPRESS_BZIP2:
+        n = decompress_bzip2_decode (fh, buf, len);
+        break;
+#endif
+#ifdef HAVE_LIBLZMA
+    case DECOMPRESS_XZ:
+    case DECOMPRESS_LZMA:
+        n = decompress_xz_decode (fh, buf, len);
+        break;
+#endif
+#ifdef HAVE_LIBZSTD
+    case DECOMPRESS_ZSTD:
+        n = decompress_zstd_decode (fh, buf, len);
+        break;
+#endif
+    default:
+        errno = EIO;
+        break;
+    }
+
+    if (n > 0)
+    {
+        fh->out_head = (fh->out_head + (size_t) n) % DECOMPRESS_WINSIZE;
+        fh->out_fill = MIN (fh->out_fill + (size_t) n, DECOMPRESS_WINSIZE);
+        fh->out_pos += n;
+    }
+    else if (n == 0)
+    {
+        fh->eof = TRUE;
+        fh->size = fh->out_pos;
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Position decoder so that data at offset is either in the ring buffer or is the next one
+ * to be decoded.
+ */
+
+static gboolean
+decompress_seek (decompress_fh_t * fh, off_t offset)
+{
+    const decompress_point_t *p = NULL;
+    guint lo, hi;
+
+    /* find the last restart point not after offset */
+    lo = 0;
+    hi = fh->points->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (g_array_index (fh->points, decompress_point_t, mid).out <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo != 0)
+        p = &g_array_index (fh->points, decompress_point_t, lo - 1);
+
+    if (offset < fh->out_pos - (off_t) fh->out_fill)
+    {
+        /* data is behind */
+        if (!(p != NULL ? decompress_restore (fh, p) : decompress_start (fh)))
+            return FALSE;
+    }
+    else if (p != NULL && p->out > fh->out_pos && !decompress_restore (fh, p))
+        return FALSE;           /* jump forward instead of decoding up to the restart point */
+
+    while (fh->out_pos < offset)
+    {
+        ssize_t n;
+
+        n = decompress_step (fh);
+        if (n == -1)
+            return FALSE;
+        if (n == 0)
+            break;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static off_t
+decompress_get_size (decompress_fh_t * fh)
+{
+    while (fh->size == -1)
+        if (decompress_step (fh) == -1)
+            return -1;
+
+    return fh->size;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+decompress_which (struct vfs_class *me, const char *path)
+{
+    size_t i;
+
+    (void) me;
+
+    for (i = 0; i < G_N_ELEMENTS (decompress_prefixes); i++)
+        if (strcmp (path, decompress_prefixes[i].prefix) == 0)
+            return (int) decompress_prefixes[i].type;
+
+    return (-1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+decompress_close (void *data)
+{
+    decompress_fh_t *fh = DECOMPRESS_FH (data);
+    guint i;
+
+    decompress_end (fh);
+    mc_close (fh->fd);
+
+    for (i = 0; i < fh->points->len; i++)
+        g_free (g_array_index (fh->points, decompress_point_t, i).window);
+    g_array_free (fh->points, TRUE);
+    g_free (fh);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+decompress_open (const vfs_path_t * vpath, int flags, mode_t mode)
+{
+    struct vfs_class *me = vfs_decompress_ops;
+    const vfs_path_element_t *path_element;
+    vfs_path_t *pname;
+    decompress_fh_t *fh;
+    int type, fd;
+
+    (void) mode;
+
+    if ((flags & (O_WRONLY | O_RDWR)) != 0)
+        ERRNOR (EROFS, NULL);
+
+    path_element = vfs_path_get_by_index (vpath, -1);
+    type = decompress_which (me, path_element->vfs_prefix);
+    if (type == -1)
+        ERRNOR (ENOENT, NULL);
+
+    /* compressed file itself */
+    pname = vfs_path_clone (vpath);
+    vfs_path_remove_element_by_index (pname, -1);
+    fd = mc_open (pname, O_RDONLY);
+    vfs_path_free (pname);
+    if (fd == -1)
+        ERRNOR (errno, NULL);
+
+    fh = g_new0 (decompress_fh_t, 1);
+    fh->type = (decompress_type_t) type;
+    fh->fd = fd;
+    fh->size = -1;
+    fh->points = g_array_new (FALSE, FALSE, sizeof (decompress_point_t));
+    fh->span = DECOMPRESS_SPAN;
+
+    if (!decompress_start (fh))
+    {
+        int e = errno;
+
+        decompress_close (fh);
+        ERRNOR (e, NULL);
+    }
+
+    return fh;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+decompress_read (void *data, char *buffer, size_t count)
+{
+    struct vfs_class *me = vfs_decompress_ops;
+    decompress_fh_t *fh = DECOMPRESS_FH (data);
+    size_t done = 0;
+
+    if (!decompress_seek (fh, fh->pos))
+        ERRNOR (errno, -1);
+
+    while (done < count)
+    {
+        if (fh->pos < fh->out_pos)
+        {
+            size_t avail, start, n;
+
+            avail = (size_t) (fh->out_pos - fh->pos);
+            start = (fh->out_head + DECOMPRESS_WINSIZE - avail) % DECOMPRESS_WINSIZE;
+            n = MIN (avail, DECOMPRESS_WINSIZE - start);
+            n = MIN (n, count - done);
+            memcpy (buffer + done, fh->out_buf + start, n);
+            done += n;
+            fh->pos += n;
+        }
+        else
+        {
+            ssize_t n;
+
+            n = decompress_step (fh);
+            if (n == 0)
+                break;
+            if (n == -1)
+            {
+                if (done != 0)
+                    break;
+                ERRNOR (errno, -1);
+            }
+        }
+    }
+
+    return (ssize_t) done;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static off_t
+decompress_lseek (void *data, off_t offset, int whence)
+{
+    struct vfs_class *me = vfs_decompress_ops;
+    decompress_fh_t *fh = DECOMPRESS_FH (data);
+    off_t size;
+
+    /* data is decoded lazily by decompress_read() */
+    switch (whence)
+    {
+    case SEEK_CUR:
+        offset += fh->pos;
+        break;
+    case SEEK_END:
+        size = decompress_get_size (fh);
+        if (size == -1)
+            ERRNOR (errno, -1);
+        offset += size;
+        break;
+    default:
+        break;
+    }
+
+    if (offset < 0)
+        ERRNOR (EINVAL, -1);
+
+    fh->pos = offset;
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+decompress_fstat (void *data, struct stat *buf)
+{
+    struct vfs_class *me = vfs_decompress_ops;
+    decompress_fh_t *fh = DECOMPRESS_FH (data);
+    off_t size;
+
+    if (mc_fstat (fh->fd, buf) != 0)
+        ERRNOR (errno, -1);
+
+    /* size of decoded data isn't stored anywhere reliably */
+    size = decompress_get_size (fh);
+    if (size == -1)
+        ERRNOR (errno, -1);
+
+    buf->st_size = size;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+decompress_stat (const vfs_path_t * vpath, struct stat *buf)
+{
+    void *fh;
+    int result;
+
+    fh = decompress_open (vpath, O_RDONLY, 0);
+    if (fh == NULL)
+        return -1;
+
+    result = decompress_fstat (fh, buf);
+    decompress_close (fh);
+
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_init_decompressfs (void)
+{
+    vfs_init_class (vfs_decompress_ops, "decompressfs", VFS_READONLY, NULL);
+    vfs_decompress_ops->which = decompress_which;
+    vfs_decompress_ops->open = decompress_open;
+    vfs_decompress_ops->close = decompress_close;
+    vfs_decompress_ops->read = decompress_read;
+    vfs_decompress_ops->stat = decompress_stat;
+    vfs_decompress_ops->lstat = decompress_stat;
+    vfs_decompress_ops->fstat = decompress_fstat;
+    vfs_decompress_ops->lseek = decompress_lseek;
+    /* no directories and no state shared between handles */
+    vfs_decompress_ops->fill_names = NULL;
+    vfs_decompress_ops->opendir = NULL;
+    vfs_decompress_ops->readdir = NULL;
+    vfs_decompress_ops->closedir = NULL;
+    vfs_decompress_ops->readlink = NULL;
+    vfs_decompress_ops->chdir = NULL;
+    vfs_decompress_ops->getid = NULL;
+    vfs_decompress_ops->nothingisopen = NULL;
+    vfs_decompress_ops->free = NULL;
+    vfs_decompress_ops->setctl = NULL;
+    vfs_register_class (vfs_decompress_ops);
+}
+
+/* --------------------------------------------------------------------------------------------- */
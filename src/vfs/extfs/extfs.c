@@ -76,6 +76,9 @@
 
 #define EXTFS_SUPER(a) ((struct extfs_super_t *) (a))
 
+/* number of entries read from helper between progress messages */
+#define EXTFS_PROGRESS_STEP 1000
+
 /*** file scope type declarations ****************************************************************/
 
 struct extfs_super_t
@@ -95,6 +98,14 @@ typedef struct
     gboolean need_archive;
 } extfs_plugin_info_t;
 
+/* item of index of entries used while archive is read */
+typedef struct
+{
+    struct vfs_s_entry *entry;
+    char *path;                 /* real path of entry relative to archive root */
+    GList *last;                /* last link of entry->ino->subdir */
+} extfs_index_item_t;
+
 /*** file scope variables ************************************************************************/
 
 static GArray *extfs_plugins = NULL;
@@ -112,6 +123,8 @@ static int my_errno = 0;
 /* --------------------------------------------------------------------------------------------- */
 
 static struct vfs_s_entry *extfs_resolve_symlinks_int (struct vfs_s_entry *entry, GSList * list);
+static struct vfs_s_entry *extfs_resolve_symlinks (struct vfs_s_entry *entry);
+static char *extfs_get_path_from_entry (const struct vfs_s_entry *entry);
 
 /* --------------------------------------------------------------------------------------------- */
 
@@ -453,9 +466,224 @@ extfs_open_archive (int fstype, const char *name, struct extfs_super_t **pparc)
     return result;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+extfs_index_item_free (gpointer data)
+{
+    extfs_index_item_t *item = (extfs_index_item_t *) data;
+
+    g_free (item->path);
+    g_free (item);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert entry into directory indexed by extfs_index_lookup_dir().
+ * Entries are appended in constant time: the last link of list of directory is remembered.
+ */
+
+static void
+extfs_index_append (extfs_index_item_t * dir, struct vfs_s_entry *entry)
+{
+    struct vfs_s_inode *ino = dir->entry->ino;
+
+    entry->dir = ino;
+
+    if (ino->subdir == NULL)
+        dir->last = ino->subdir = g_list_append (NULL, entry);
+    else
+    {
+        /* list could be extended by extfs_find_entry(), g_list_last() handles that */
+        if (dir->last == NULL)
+            dir->last = ino->subdir;
+        dir->last = g_list_last (g_list_append (dir->last, entry));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember entry by its real path.
+ *
+ * @return index item of path
+ */
+
+static extfs_index_item_t *
+extfs_index_add (GHashTable * index, const char *path, struct vfs_s_entry *entry)
+{
+    extfs_index_item_t *item;
+
+    item = (extfs_index_item_t *) g_hash_table_lookup (index, path);
+    if (item == NULL)
+    {
+        /* the first of entries with the same name wins like in extfs_find_entry() */
+        item = g_new0 (extfs_index_item_t, 1);
+        item->entry = entry;
+        item->path = g_strdup (path);
+        g_hash_table_insert (index, item->path, item);
+    }
+
+    return item;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember entry found by extfs_find_entry() and all its parent directories.
+ */
+
+static extfs_index_item_t *
+extfs_index_add_entry (GHashTable * index, struct vfs_s_entry *entry)
+{
+    extfs_index_item_t *item = NULL;
+    struct vfs_s_entry *e;
+
+    if (entry->dir == NULL)
+        return (extfs_index_item_t *) g_hash_table_lookup (index, "");
+
+    for (e = entry; e->dir != NULL; e = e->dir->ent)
+    {
+        char *path;
+        extfs_index_item_t *it;
+
+        path = extfs_get_path_from_entry (e);
+        it = extfs_index_add (index, path, e);
+        g_free (path);
+
+        if (e == entry)
+            item = it;
+    }
+
+    return item;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+extfs_index_child_path (const extfs_index_item_t * dir, const char *name)
+{
+    if (*dir->path == '\0')
+        return g_strdup (name);
+
+    return g_strconcat (dir->path, PATH_SEP_STR, name, (char *) NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find directory by path relative to archive root using the index.
+ * Missing directories are created.
+ *
+ * @param index   index of entries
+ * @param archive archive
+ * @param path    path of directory
+ * @param resolve TRUE to follow symlink, as extfs_find_entry() does for all but the last
+ *                component of path
+ *
+ * @return directory item, NULL if path is not a directory
+ */
+
+static extfs_index_item_t *
+extfs_index_lookup_dir (GHashTable * index, struct extfs_super_t *archive, const char *path,
+                        gboolean resolve)
+{
+    extfs_index_item_t *item;
+
+    item = (extfs_index_item_t *) g_hash_table_lookup (index, path);
+    if (item == NULL)
+    {
+        const char *sep, *name;
+
+        sep = strrchr (path, PATH_SEP);
+        name = sep == NULL ? path : sep + 1;
+
+        if (*name == '\0' || strcmp (name, ".") == 0 || strcmp (name, "..") == 0
+            || (sep != NULL && (sep == path || IS_PATH_SEP (sep[-1]))))
+        {
+            /* unusual paths are resolved by extfs_find_entry() */
+            struct vfs_s_entry *entry;
+
+            entry = extfs_find_entry (VFS_SUPER (archive)->root, path, FL_MKDIR);
+            if (entry == NULL)
+                return NULL;
+            item = extfs_index_add_entry (index, entry);
+        }
+        else
+        {
+            extfs_index_item_t *parent;
+            char *real_path;
+
+            if (sep == NULL)
+                parent = (extfs_index_item_t *) g_hash_table_lookup (index, "");
+            else
+            {
+                char *parent_path;
+
+                parent_path = g_strndup (path, (gsize) (sep - path));
+                parent = extfs_index_lookup_dir (index, archive, parent_path, TRUE);
+                g_free (parent_path);
+            }
+
+            if (parent == NULL)
+                return NULL;
+
+            /* parent can be reached via symlink: index directory by its real path */
+            real_path = extfs_index_child_path (parent, name);
+            item = (extfs_index_item_t *) g_hash_table_lookup (index, real_path);
+            if (item == NULL)
+            {
+                item = extfs_index_add (index, real_path,
+                                        extfs_generate_entry (archive, name, NULL,
+                                                              S_IFDIR | 0777));
+                extfs_index_append (parent, item->entry);
+                /* as vfs_s_insert_entry() does for directories made by extfs_find_entry() */
+                item->entry->ino->st.st_nlink++;
+            }
+            g_free (real_path);
+        }
+    }
+
+    if (resolve && !S_ISDIR (item->entry->ino->st.st_mode))
+    {
+        struct vfs_s_entry *entry;
+
+        entry = extfs_resolve_symlinks (item->entry);
+        if (entry == NULL || !S_ISDIR (entry->ino->st.st_mode))
+            return NULL;
+        item = extfs_index_add_entry (index, entry);
+    }
+
+    return item;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read line of any length from helper output.
+ *
+ * @return FALSE at end of output
+ */
+
+static gboolean
+extfs_read_line (FILE * extfsd, GString * line, char *buffer, size_t size)
+{
+    g_string_truncate (line, 0);
+
+    while (fgets (buffer, size, extfsd) != NULL)
+    {
+        g_string_append (line, buffer);
+        if (line->str[line->len - 1] == '\n')
+            break;
+    }
+
+    return line->len != 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Main loop for reading an archive.
+ *
+ * Entries are inserted while output of helper is read. Directories are looked up
+ * through a hash table of paths, so loading of archive takes linear time even if it
+ * contains many files in one directory.
+ *
  * Return 0 on success, -1 on error.
  */
 
@@ -464,20 +692,27 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
 {
     int ret = 0;
     char *buffer;
+    GString *line;
+    GHashTable *index;
+    guint count = 0;
     struct vfs_s_super *super = VFS_SUPER (current_archive);
 
     buffer = g_malloc (BUF_4K);
+    line = g_string_sized_new (BUF_4K);
+    index = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, extfs_index_item_free);
+    extfs_index_add (index, "", super->root->ent);
 
-    while (fgets (buffer, BUF_4K, extfsd) != NULL)
+    while (extfs_read_line (extfsd, line, buffer, BUF_4K))
     {
         struct stat hstat;
         char *current_file_name = NULL, *current_link_name = NULL;
 
-        if (vfs_parse_ls_lga (buffer, &hstat, &current_file_name, &current_link_name, NULL))
+        if (vfs_parse_ls_lga (line->str, &hstat, &current_file_name, &current_link_name, NULL))
         {
-            struct vfs_s_entry *entry, *pent = NULL;
+            struct vfs_s_entry *entry, *pent;
             struct vfs_s_inode *inode;
-            char *p, *q, *cfn = current_file_name;
+            extfs_index_item_t *item;
+            char *p, *cfn = current_file_name;
 
             if (*cfn != '\0')
             {
@@ -488,46 +723,45 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
                     p[-1] = '\0';
                 p = strrchr (cfn, PATH_SEP);
                 if (p == NULL)
-                {
-                    p = cfn;
-                    q = strchr (cfn, '\0');
-                }
+                    item = extfs_index_lookup_dir (index, current_archive, "", FALSE);
                 else
                 {
-                    *(p++) = '\0';
-                    q = cfn;
+                    *p = '\0';
+                    item = extfs_index_lookup_dir (index, current_archive, cfn, FALSE);
+                    *p = PATH_SEP;
                 }
 
-                if (*q != '\0')
+                if (item == NULL)
                 {
-                    pent = extfs_find_entry (super->root, q, FL_MKDIR);
-                    if (pent == NULL)
-                    {
-                        ret = -1;
-                        break;
-                    }
+                    ret = -1;
+                    break;
                 }
 
-                if (pent != NULL)
-                {
-                    entry = extfs_entry_new (super->me, p, pent->ino);
-                    entry->dir = pent->ino;
-                    pent->ino->subdir = g_list_append (pent->ino->subdir, entry);
-                }
-                else
-                {
-                    entry = extfs_entry_new (super->me, p, super->root);
-                    entry->dir = super->root;
-                    super->root->subdir = g_list_append (super->root->subdir, entry);
-                }
+                p = p == NULL ? cfn : p + 1;
+                entry = extfs_entry_new (super->me, p, item->entry->ino);
+                extfs_index_append (item, entry);
+                p = extfs_index_child_path (item, p);
+                extfs_index_add (index, p, entry);
+                g_free (p);
 
                 if (!S_ISLNK (hstat.st_mode) && (current_link_name != NULL))
                 {
-                    pent = extfs_find_entry (super->root, current_link_name, FL_NONE);
-                    if (pent == NULL)
+                    const char *link = current_link_name;
+
+                    while (IS_PATH_SEP (*link))
+                        link++;
+
+                    item = (extfs_index_item_t *) g_hash_table_lookup (index, link);
+                    if (item != NULL)
+                        pent = item->entry;
+                    else
                     {
-                        ret = -1;
-                        break;
+                        pent = extfs_find_entry (super->root, current_link_name, FL_NONE);
+                        if (pent == NULL)
+                        {
+                            ret = -1;
+                            break;
+                        }
                     }
 
                     pent->ino->st.st_nlink++;
@@ -569,6 +803,10 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
                         current_link_name = NULL;
                     }
                 }
+
+                if ((++count % EXTFS_PROGRESS_STEP) == 0)
+                    vfs_print_message (_("extfs: Reading archive %s... %u entries"), super->name,
+                                       count);
             }
 
             g_free (current_file_name);
@@ -576,6 +814,8 @@ extfs_read_archive (FILE * extfsd, struct extfs_super_t *current_archive)
         }
     }
 
+    g_hash_table_destroy (index);
+    g_string_free (line, TRUE);
     g_free (buffer);
 
     return ret;
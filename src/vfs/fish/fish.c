@@ -93,6 +93,10 @@ int fish_directory_timeout = 900;
 
 #define OPT_FLUSH        1
 #define OPT_IGNORE_ERROR 2
+#define OPT_BATCH        4      /* operation may be queued if batch is active */
+
+/* max number of queued operations sent in one script */
+#define FISH_BATCH_MAX 256
 
 /*
  * Reply codes.
@@ -117,6 +121,9 @@ int fish_directory_timeout = 900;
 #define FISH_HAVE_DATE_MDYT   32
 #define FISH_HAVE_TAIL        64
 
+/* max block size of dd used by 'getrange' script */
+#define FISH_RANGE_MAX_BLOCK_SIZE (64 * 1024)
+
 #define FISH_SUPER(super) ((fish_super_t *) (super))
 #define FISH_FILE_HANDLER(fh) ((fish_file_handler_t *) fh)
 
@@ -140,11 +147,19 @@ typedef struct
     char *scr_mv;
     char *scr_hardlink;
     char *scr_get;
+    char *scr_getrange;
     char *scr_send;
     char *scr_append;
     char *scr_info;
     int host_flags;
     char *scr_env;
+
+    /* queued operations, see VFS_SETCTL_BATCH */
+    gboolean batch;
+    GString *batch_script;
+    int batch_count;
+    int batch_failed;
+    gboolean batch_flush_cache;
 } fish_super_t;
 
 typedef struct
@@ -300,6 +315,38 @@ fish_command (struct vfs_class *me, struct vfs_s_super *super, int wait_reply, c
     return COMPLETE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Send queued operations as one script and read their replies.
+ */
+
+static void
+fish_batch_flush (struct vfs_class *me, struct vfs_s_super *super)
+{
+    fish_super_t *fish_super = FISH_SUPER (super);
+    GString *script = fish_super->batch_script;
+    int count = fish_super->batch_count;
+
+    if (count == 0)
+        return;
+
+    fish_super->batch_script = NULL;
+    fish_super->batch_count = 0;
+
+    if (fish_command (me, super, NONE, script->str, script->len) != COMPLETE)
+        fish_super->batch_failed += count;
+    else
+        for (; count != 0; count--)
+            if (fish_get_reply (me, fish_super->sockr, NULL, 0) != COMPLETE)
+                fish_super->batch_failed++;
+
+    g_string_free (script, TRUE);
+    vfs_stamp_create (vfs_fish_ops, super);
+
+    /* the directory tree isn't invalidated here: this is called before any command,
+       when directory entries can be in use by caller; see fish_batch() */
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -310,6 +357,9 @@ fish_command_va (struct vfs_class *me, struct vfs_s_super *super, int wait_reply
     int r;
     GString *command;
 
+    /* replies of queued operations go first */
+    fish_batch_flush (me, super);
+
     command = g_string_new (FISH_SUPER (super)->scr_env);
     g_string_append_vprintf (command, vars, ap);
     g_string_append (command, scr);
@@ -343,10 +393,30 @@ G_GNUC_PRINTF (5, 6)
 fish_send_command (struct vfs_class *me, struct vfs_s_super *super, int flags, const char *scr,
                    const char *vars, ...)
 {
+    fish_super_t *fish_super = FISH_SUPER (super);
     int r;
     va_list ap;
 
     va_start (ap, vars);
+
+    if ((flags & OPT_BATCH) != 0 && fish_super->batch)
+    {
+        /* result will be known when batch is sent */
+        if (fish_super->batch_script == NULL)
+            fish_super->batch_script = g_string_new (fish_super->scr_env);
+        g_string_append_vprintf (fish_super->batch_script, vars, ap);
+        g_string_append (fish_super->batch_script, scr);
+        va_end (ap);
+
+        fish_super->batch_count++;
+        if ((flags & OPT_FLUSH) != 0)
+            fish_super->batch_flush_cache = TRUE;
+        if (fish_super->batch_count >= FISH_BATCH_MAX)
+            fish_batch_flush (me, super);
+
+        return 0;
+    }
+
     r = fish_command_va (me, super, WAIT_REPLY, scr, vars, ap);
     va_end (ap);
     vfs_stamp_create (vfs_fish_ops, super);
@@ -381,6 +451,7 @@ fish_free_archive (struct vfs_class *me, struct vfs_s_super *super)
 
     if ((fish_super->sockw != -1) || (fish_super->sockr != -1))
     {
+        fish_batch_flush (me, super);
         vfs_print_message (_("fish: Disconnecting from %s"), super->name ? super->name : "???");
         fish_command (me, super, NONE, "#BYE\nexit\n", -1);
         close (fish_super->sockw);
@@ -399,6 +470,7 @@ fish_free_archive (struct vfs_class *me, struct vfs_s_super *super)
     g_free (fish_super->scr_mv);
     g_free (fish_super->scr_hardlink);
     g_free (fish_super->scr_get);
+    g_free (fish_super->scr_getrange);
     g_free (fish_super->scr_send);
     g_free (fish_super->scr_append);
     g_free (fish_super->scr_info);
@@ -707,6 +779,9 @@ fish_open_archive (struct vfs_s_super *super,
                                     FISH_HARDLINK_DEF_CONTENT);
     fish_super->scr_get =
         fish_load_script_from_file (super->path_element->host, FISH_GET_FILE, FISH_GET_DEF_CONTENT);
+    fish_super->scr_getrange =
+        fish_load_script_from_file (super->path_element->host, FISH_GETRANGE_FILE,
+                                    FISH_GETRANGE_DEF_CONTENT);
     fish_super->scr_send =
         fish_load_script_from_file (super->path_element->host, FISH_SEND_FILE,
                                     FISH_SEND_DEF_CONTENT);
@@ -1075,6 +1150,34 @@ fish_file_store (struct vfs_class *me, vfs_file_handler_t * fh, char *name, char
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Prepare reading of file data sent by server after reply to 'get' or 'getrange' script.
+ *
+ * @return TRUE if server is ready to send data, FALSE otherwise
+ */
+
+static gboolean
+fish_linear_begin (struct vfs_class *me, vfs_file_handler_t * fh, int reply)
+{
+    fish_file_handler_t *fish = FISH_FILE_HANDLER (fh);
+
+    if (reply != PRELIM)
+        ERRNOR (E_REMOTE, FALSE);
+    fh->linear = LS_LINEAR_OPEN;
+    fish->got = 0;
+    errno = 0;
+#if SIZEOF_OFF_T == SIZEOF_LONG
+    fish->total = (off_t) strtol (reply_str, NULL, 10);
+#else
+    fish->total = (off_t) g_ascii_strtoll (reply_str, NULL, 10);
+#endif
+    if (errno != 0)
+        ERRNOR (E_REMOTE, FALSE);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static int
 fish_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
 {
@@ -1082,6 +1185,7 @@ fish_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
     struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
     char *name;
     char *quoted_name;
+    int reply;
 
     name = vfs_s_fullpath (me, fh->ino);
     if (name == NULL)
@@ -1097,25 +1201,13 @@ fish_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
      * standard output (i.e. over the network).
      */
 
-    offset =
+    reply =
         fish_command_v (me, super, WANT_STRING, FISH_SUPER (super)->scr_get,
                         "FISH_FILENAME=%s FISH_START_OFFSET=%" PRIuMAX ";\n", quoted_name,
                         (uintmax_t) offset);
     g_free (quoted_name);
 
-    if (offset != PRELIM)
-        ERRNOR (E_REMOTE, 0);
-    fh->linear = LS_LINEAR_OPEN;
-    fish->got = 0;
-    errno = 0;
-#if SIZEOF_OFF_T == SIZEOF_LONG
-    fish->total = (off_t) strtol (reply_str, NULL, 10);
-#else
-    fish->total = (off_t) g_ascii_strtoll (reply_str, NULL, 10);
-#endif
-    if (errno != 0)
-        ERRNOR (E_REMOTE, 0);
-    return 1;
+    return fish_linear_begin (me, fh, reply) ? 1 : 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1188,6 +1280,57 @@ fish_linear_close (struct vfs_class *me, vfs_file_handler_t * fh)
         fish_linear_abort (me, fh);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read part of file using 'getrange' script which sends data by dd.
+ */
+
+static ssize_t
+fish_read_range (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset, void *buf,
+                 size_t len)
+{
+    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
+    char *name;
+    char *quoted_name;
+    size_t block_size;
+    size_t total = 0;
+    ssize_t n;
+    int reply;
+
+    name = vfs_s_fullpath (me, fh->ino);
+    if (name == NULL)
+        return (-1);
+    quoted_name = strutils_shell_escape (name);
+    g_free (name);
+
+    /* dd copies whole blocks: find the largest block size that offset and length are multiple of */
+    for (block_size = 1; block_size < FISH_RANGE_MAX_BLOCK_SIZE
+         && offset % (off_t) (block_size * 2) == 0 && len % (block_size * 2) == 0; block_size *= 2)
+        ;
+
+    reply =
+        fish_command_v (me, super, WANT_STRING, FISH_SUPER (super)->scr_getrange,
+                        "FISH_FILENAME=%s FISH_BLOCK_SIZE=%" PRIuMAX " FISH_START_BLOCK=%"
+                        PRIuMAX " FISH_BLOCKS=%" PRIuMAX ";\n", quoted_name,
+                        (uintmax_t) block_size, (uintmax_t) (offset / (off_t) block_size),
+                        (uintmax_t) (len / block_size));
+    g_free (quoted_name);
+
+    if (!fish_linear_begin (me, fh, reply))
+    {
+        fh->linear = LS_NOT_LINEAR;
+        return (-1);
+    }
+
+    /* read data and final reply */
+    while ((n = fish_linear_read (me, fh, (char *) buf + total, len - total)) > 0)
+        total += (size_t) n;
+
+    fh->linear = LS_NOT_LINEAR;
+
+    return n < 0 ? -1 : (ssize_t) total;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -1377,7 +1520,8 @@ fish_chmod (const vfs_path_t * vpath, mode_t mode)
     rpath = strutils_shell_escape (crpath);
 
     ret =
-        fish_send_command (path_element->class, super, OPT_FLUSH, FISH_SUPER (super)->scr_chmod,
+        fish_send_command (path_element->class, super, OPT_FLUSH | OPT_BATCH,
+                           FISH_SUPER (super)->scr_chmod,
                            "FISH_FILENAME=%s FISH_FILEMODE=%4.4o;\n", rpath,
                            (unsigned int) (mode & 07777));
 
@@ -1421,7 +1565,8 @@ fish_chown (const vfs_path_t * vpath, uid_t owner, gid_t group)
 
     /* FIXME: what should we report if chgrp succeeds but chown fails? */
     ret =
-        fish_send_command (path_element->class, super, OPT_FLUSH, FISH_SUPER (super)->scr_chown,
+        fish_send_command (path_element->class, super, OPT_FLUSH | OPT_BATCH,
+                           FISH_SUPER (super)->scr_chown,
                            "FISH_FILENAME=%s FISH_FILEOWNER=%s FISH_FILEGROUP=%s;\n", rpath, sowner,
                            sgroup);
 
@@ -1500,7 +1645,8 @@ fish_utime (const vfs_path_t * vpath, mc_timesbuf_t * times)
                 gmt->tm_year + 1900, gmt->tm_mon + 1, gmt->tm_mday,
                 gmt->tm_hour, gmt->tm_min, gmt->tm_sec, mtime_nsec);
 
-    ret = fish_send_command (path_element->class, super, OPT_FLUSH, FISH_SUPER (super)->scr_utime,
+    ret = fish_send_command (path_element->class, super, OPT_FLUSH | OPT_BATCH,
+                             FISH_SUPER (super)->scr_utime,
                              "FISH_FILENAME=%s FISH_FILEATIME=%ld FISH_FILEMTIME=%ld "
                              "FISH_TOUCHATIME=%s FISH_TOUCHMTIME=%s FISH_TOUCHATIME_W_NSEC=\"%s\" "
                              "FISH_TOUCHMTIME_W_NSEC=\"%s\";\n", rpath, (long) atime, (long) mtime,
@@ -1531,7 +1677,8 @@ fish_unlink (const vfs_path_t * vpath)
     rpath = strutils_shell_escape (crpath);
 
     ret =
-        fish_send_command (path_element->class, super, OPT_FLUSH, FISH_SUPER (super)->scr_unlink,
+        fish_send_command (path_element->class, super, OPT_FLUSH | OPT_BATCH,
+                           FISH_SUPER (super)->scr_unlink,
                            "FISH_FILENAME=%s;\n", rpath);
 
     g_free (rpath);
@@ -1624,7 +1771,8 @@ fish_rmdir (const vfs_path_t * vpath)
     rpath = strutils_shell_escape (crpath);
 
     ret =
-        fish_send_command (path_element->class, super, OPT_FLUSH, FISH_SUPER (super)->scr_rmdir,
+        fish_send_command (path_element->class, super, OPT_FLUSH | OPT_BATCH,
+                           FISH_SUPER (super)->scr_rmdir,
                            "FISH_FILENAME=%s;\n", rpath);
 
     g_free (rpath);
@@ -1632,6 +1780,42 @@ fish_rmdir (const vfs_path_t * vpath)
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start queuing of chmod, chown, utime, unlink and rmdir operations, or send queued ones.
+ * Queued operations are sent as one script when batch is finished, when the queue is full,
+ * or before any other command. Directory cache is dropped only when batch is finished.
+ *
+ * @return number of queued operations failed since batch was started
+ */
+
+static int
+fish_batch (struct vfs_class *me, struct vfs_s_super *super, gboolean start)
+{
+    fish_super_t *fish_super = FISH_SUPER (super);
+    int failed;
+
+    if (start)
+    {
+        fish_super->batch = TRUE;
+        fish_super->batch_failed = 0;
+        return 0;
+    }
+
+    fish_batch_flush (me, super);
+    failed = fish_super->batch_failed;
+    fish_super->batch = FALSE;
+    fish_super->batch_failed = 0;
+
+    if (fish_super->batch_flush_cache)
+    {
+        vfs_s_invalidate (me, super);
+        fish_super->batch_flush_cache = FALSE;
+    }
+
+    return failed;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static vfs_file_handler_t *
@@ -1778,6 +1962,8 @@ vfs_init_fish (void)
     fish_subclass.linear_start = fish_linear_start;
     fish_subclass.linear_read = fish_linear_read;
     fish_subclass.linear_close = fish_linear_close;
+    fish_subclass.read_range = fish_read_range;
+    fish_subclass.batch = fish_batch;
     vfs_register_class (vfs_fish_ops);
 }
 
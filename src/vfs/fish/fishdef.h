@@ -143,6 +143,27 @@
 "    echo \"### 500\"\n"                                                        \
 "fi\n"
 
+/* default 'retr' script for part of file */
+#define FISH_GETRANGE_DEF_CONTENT ""                                              \
+"export LC_TIME=C\n"                                                              \
+"#RANGE $FISH_FILENAME $FISH_BLOCK_SIZE $FISH_START_BLOCK $FISH_BLOCKS\n"         \
+"if dd if=\"/${FISH_FILENAME}\" of=/dev/null bs=1 count=1 2>/dev/null ; then\n"   \
+"    ls -ln \"/${FISH_FILENAME}\" 2>/dev/null | (\n"                              \
+"       read p l u g s r\n"                                                       \
+"       s=`expr $s - $FISH_BLOCK_SIZE \\* $FISH_START_BLOCK`\n"                   \
+"       n=`expr $FISH_BLOCK_SIZE \\* $FISH_BLOCKS`\n"                             \
+"       if [ $s -lt 0 ]; then s=0; fi\n"                                          \
+"       if [ $s -gt $n ]; then s=$n; fi\n"                                        \
+"       echo $s\n"                                                                \
+"    )\n"                                                                         \
+"    echo \"### 100\"\n"                                                          \
+"    dd if=\"/${FISH_FILENAME}\" bs=$FISH_BLOCK_SIZE skip=$FISH_START_BLOCK \\\n" \
+"        count=$FISH_BLOCKS 2>/dev/null\n"                                        \
+"    echo \"### 200\"\n"                                                          \
+"else\n"                                                                          \
+"    echo \"### 500\"\n"                                                          \
+"fi\n"
+
 /* default 'stor'  script */
 #define FISH_SEND_DEF_CONTENT ""                                          \
 "FILENAME=\"/${FISH_FILENAME}\"\n"                                        \
@@ -46,6 +46,11 @@ success, if they were, it marks failure.
 001 don't know; if there were no previous lines, this marks
 PRELIMinary success, if they were, it marks failure
 
+Requests of CHMOD, CHOWN, UTIME, DELE and RMD commands may be sent
+in batches: several requests are written at once and replies are read
+after that, one per request. Therefore scripts of these commands must
+not read input nor exit the shell.
+
 				Connecting
 				~~~~~~~~~~
 Client uses "echo FISH:;/bin/sh" as command executed on remote
@@ -126,6 +131,14 @@ filesize bytes) and follows them with (with no preceding newline) ###
 Note that there's no way to abort running RETR command - except
 closing the connection.
 
+#RANGE /some/name <block size> <start block> <blocks>
+ls -l /some/name | ( read a b c d x e; echo <size of range> ); echo '### 100'; dd if=/some/name bs=<block size> skip=<start block> count=<blocks>; echo '### 200'
+
+Same as RETR, but only part of file is sent. Size of range is limited
+by the end of file. This command is used to read parts of file which
+is opened for reading only (e.g. by viewer) instead of retrieving the
+whole file.
+
 #STOR <size> /file/name
 > /file/name; echo '### 001'; ( dd bs=4096 count=<size/4096>; dd bs=<size%4096> count=1 ) 2>/dev/null | ( cat > %s; cat > /dev/null ); echo '### 200'
 
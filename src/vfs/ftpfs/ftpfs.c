@@ -182,12 +182,24 @@ gboolean ftpfs_ignore_chattr_errors = TRUE;
 #define TYPE_UNKNOWN -1
 
 #define ABORT_TIMEOUT 5
+
+/* max number of control connections to one server */
+#define FTP_MAX_CONNECTIONS 4
 /*** file scope type declarations ****************************************************************/
 
 #ifndef HAVE_SOCKLEN_T
 typedef int socklen_t;
 #endif
 
+/* State of control connection */
+typedef struct
+{
+    int sock;
+    int isbinary;
+    gboolean busy;              /* data transfer is in progress */
+    char *current_dir;
+} ftp_connection_t;
+
 /* This should match the keywords[] array below */
 typedef enum
 {
@@ -221,6 +233,13 @@ typedef struct
                                  */
     gboolean ctl_connection_busy;
     char *current_dir;
+    gboolean use_mlsd;          /* server supports MLSD command (RFC 3659) */
+    char *mlst_opts;            /* OPTS MLST command to be sent on each control connection,
+                                   NULL if MLSD is not used */
+    GSList *idle_connections;   /* logged in control connections (ftp_connection_t) */
+    int connections;            /* number of open control connections */
+    int max_connections;        /* limit of control connections, lowered when server
+                                   refuses to accept one more connection */
 } ftp_super_t;
 
 typedef struct
@@ -229,6 +248,8 @@ typedef struct
 
     int sock;
     gboolean append;
+    ftp_connection_t ctl;       /* control connection of transfer, ctl.sock is -1
+                                   if the connection of superblock is used */
 } ftp_file_handler_t;
 
 /*** file scope variables ************************************************************************/
@@ -560,6 +581,29 @@ ftpfs_command (struct vfs_class *me, struct vfs_s_super *super, int wait_reply,
     return COMPLETE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Exchange control connection of superblock with another one. Commands are always sent over
+ * control connection of superblock, so connection of a transfer is switched in to finish
+ * the transfer.
+ */
+
+static void
+ftpfs_connection_switch (ftp_super_t * ftp_super, ftp_connection_t * conn)
+{
+    ftp_connection_t tmp = *conn;
+
+    conn->sock = ftp_super->sock;
+    conn->isbinary = ftp_super->isbinary;
+    conn->busy = ftp_super->ctl_connection_busy;
+    conn->current_dir = ftp_super->current_dir;
+
+    ftp_super->sock = tmp.sock;
+    ftp_super->isbinary = tmp.isbinary;
+    ftp_super->ctl_connection_busy = tmp.busy;
+    ftp_super->current_dir = tmp.current_dir;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static struct vfs_s_super *
@@ -574,6 +618,8 @@ ftpfs_new_archive (struct vfs_class *me)
     arch->use_passive_connection = ftpfs_use_passive_connections;
     arch->strict = ftpfs_use_unix_list_options ? RFC_AUTODETECT : RFC_STRICT;
     arch->isbinary = TYPE_UNKNOWN;
+    arch->connections = 1;
+    arch->max_connections = FTP_MAX_CONNECTIONS;
 
     return VFS_SUPER (arch);
 }
@@ -585,6 +631,22 @@ ftpfs_free_archive (struct vfs_class *me, struct vfs_s_super *super)
 {
     ftp_super_t *ftp_super = FTP_SUPER (super);
 
+    while (ftp_super->idle_connections != NULL)
+    {
+        ftp_connection_t *conn = (ftp_connection_t *) ftp_super->idle_connections->data;
+
+        ftp_super->idle_connections =
+            g_slist_delete_link (ftp_super->idle_connections, ftp_super->idle_connections);
+
+        /* send QUIT over idle connection */
+        ftpfs_connection_switch (ftp_super, conn);
+        ftpfs_command (me, super, NONE, "%s", "QUIT");
+        close (ftp_super->sock);
+        ftpfs_connection_switch (ftp_super, conn);
+        g_free (conn->current_dir);
+        g_free (conn);
+    }
+
     if (ftp_super->sock != -1)
     {
         vfs_print_message (_("ftpfs: Disconnecting from %s"), super->path_element->host);
@@ -592,6 +654,7 @@ ftpfs_free_archive (struct vfs_class *me, struct vfs_s_super *super)
         close (ftp_super->sock);
     }
     g_free (ftp_super->current_dir);
+    g_free (ftp_super->mlst_opts);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -608,6 +671,124 @@ ftpfs_changetype (struct vfs_class *me, struct vfs_s_super *super, int binary)
     return binary;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Make OPTS MLST command which enables the facts ftpfs needs if server supports them.
+ *
+ * @param facts facts listed by server in reply to FEAT, in lower case
+ *
+ * @return newly allocated command
+ */
+
+static char *
+ftpfs_make_mlst_opts (const char *facts)
+{
+    /* facts used by vfs_parse_mlsd() */
+    static const char *const wanted_facts[] = {
+        "type", "size", "modify", "perm", "UNIX.mode", "UNIX.owner", "UNIX.group",
+        "UNIX.uid", "UNIX.gid", NULL
+    };
+
+    GString *opts;
+    size_t i;
+
+    opts = g_string_new ("OPTS MLST ");
+    for (i = 0; wanted_facts[i] != NULL; i++)
+    {
+        char *fact;
+        const char *p;
+        size_t len;
+
+        fact = g_ascii_strdown (wanted_facts[i], -1);
+        len = strlen (fact);
+
+        for (p = strstr (facts, fact); p != NULL; p = strstr (p + len, fact))
+            if ((p[-1] == ' ' || p[-1] == ';') && (p[len] == ';' || p[len] == '*'))
+            {
+                g_string_append_printf (opts, "%s;", wanted_facts[i]);
+                break;
+            }
+
+        g_free (fact);
+    }
+
+    return g_string_free (opts, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Ask server for supported extensions (RFC 2389) and find out whether machine-readable
+ * listings (RFC 3659) can be used. If so, request the facts ftpfs needs.
+ */
+
+static void
+ftpfs_get_features (struct vfs_class *me, struct vfs_s_super *super)
+{
+    ftp_super_t *ftp_super = FTP_SUPER (super);
+    char answer[BUF_1K];
+    char *facts = NULL;
+    gboolean multiline;
+
+    ftp_super->use_mlsd = FALSE;
+    MC_PTR_FREE (ftp_super->mlst_opts);
+
+    if (ftpfs_command (me, super, NONE, "FEAT") != COMPLETE)
+        return;
+
+    /* ftpfs_get_reply() drops lines of multiline reply, so read them here */
+    if (vfs_s_get_line (me, ftp_super->sock, answer, sizeof (answer), '\n') == 0)
+        return;
+
+    /* cppcheck-suppress invalidscanf */
+    if (sscanf (answer, "%d", &code) != 1)
+        return;
+
+    for (multiline = answer[3] == '-'; multiline;)
+    {
+        int i;
+
+        if (vfs_s_get_line (me, ftp_super->sock, answer, sizeof (answer), '\n') == 0)
+        {
+            code = 421;
+            g_free (facts);
+            return;
+        }
+
+        /* features are listed one per line with leading space */
+        if (code == 211 && answer[0] == ' ')
+        {
+            char *feature;
+
+            feature = g_strstrip (answer);
+            if (g_ascii_strncasecmp (feature, "MLST", 4) == 0
+                && (feature[4] == '\0' || feature[4] == ' '))
+            {
+                ftp_super->use_mlsd = TRUE;
+                g_free (facts);
+                facts = g_ascii_strdown (feature + 4, -1);
+            }
+        }
+        /* cppcheck-suppress invalidscanf */
+        else if (sscanf (answer, "%d", &i) > 0 && i == code && answer[3] == ' ')
+            multiline = FALSE;
+    }
+
+    if (ftp_super->use_mlsd)
+    {
+        /* enable facts we need if server supports them, don't care about the reply */
+        ftp_super->mlst_opts = ftpfs_make_mlst_opts (facts);
+        ftpfs_command (me, super, WAIT_REPLY, "%s", ftp_super->mlst_opts);
+    }
+
+    g_free (facts);
+
+    if (me->logfile != NULL)
+    {
+        fprintf (me->logfile, "MC -- use_mlsd = %s\n", ftp_super->use_mlsd ? "yes" : "no");
+        fflush (me->logfile);
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* This routine logs the user in */
 
@@ -713,6 +894,7 @@ ftpfs_login_server (struct vfs_class *me, struct vfs_s_super *super, const char
             vfs_print_message ("%s", _("ftpfs: logged in"));
             wipe_password (pass);
             g_free (name);
+            ftpfs_get_features (me, super);
             return TRUE;
 
         default:
@@ -1452,17 +1634,198 @@ ftpfs_open_data_connection (struct vfs_class *me, struct vfs_s_super *super, con
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Send command over new connection of the pool and get reply.
+ * Unlike ftpfs_command(), never tries to reconnect.
+ *
+ * @param string_buf buffer for reply line, it is empty if server hasn't answered
+ */
+
+static int
+G_GNUC_PRINTF (5, 6)
+ftpfs_pool_command (struct vfs_class *me, int sock, char *string_buf, int string_len,
+                    const char *fmt, ...)
+{
+    va_list ap;
+    char *cmd;
+    size_t len;
+    ssize_t written;
+
+    va_start (ap, fmt);
+    cmd = g_strdup_vprintf (fmt, ap);
+    va_end (ap);
+
+    len = strlen (cmd);
+    written = write (sock, cmd, len);
+    /* command can contain password */
+    wipe_password (cmd);
+
+    if (written != (ssize_t) len)
+    {
+        *string_buf = '\0';
+        return TRANSIENT;
+    }
+
+    return ftpfs_get_reply (me, sock, string_buf, string_len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Log in over new connection of the pool. Unlike ftpfs_login_server(), this never asks
+ * user and never shows errors: if password isn't known yet or the server refuses
+ * the connection, the transfer just keeps the connection of superblock.
+ * State of superblock (password, login failure) is not changed.
+ *
+ * @param refused set to TRUE if connection can't be logged in: password isn't known or
+ *                server answered with error, FALSE on success or connection error
+ */
+
+static gboolean
+ftpfs_login_pool_connection (struct vfs_class *me, struct vfs_s_super *super, int sock,
+                             gboolean * refused)
+{
+    const char *user = super->path_element->user;
+    char *pass, *name;
+    char answer[BUF_SMALL];
+    int reply;
+
+    *refused = TRUE;
+
+    if (super->path_element->password != NULL)
+        pass = g_strdup (super->path_element->password);
+    else if (strcmp (user, "anonymous") == 0 || strcmp (user, "ftp") == 0)
+    {
+        if (ftpfs_anonymous_passwd == NULL)     /* default anonymous password */
+            ftpfs_init_passwd ();
+        pass = g_strconcat (me->logfile != NULL ? "" : "-", ftpfs_anonymous_passwd,
+                            (char *) NULL);
+    }
+    else
+        return FALSE;
+
+    /* Proxy server accepts: username@host-we-want-to-connect */
+    if (FTP_SUPER (super)->proxy != NULL)
+        name =
+            g_strconcat (user, "@",
+                         super->path_element->host[0] ==
+                         '!' ? super->path_element->host + 1 : super->path_element->host,
+                         (char *) NULL);
+    else
+        name = g_strdup (user);
+
+    /* banner: 421 if server limits number of connections */
+    reply = ftpfs_get_reply (me, sock, answer, sizeof (answer));
+    if (reply == COMPLETE)
+    {
+        reply = ftpfs_pool_command (me, sock, answer, sizeof (answer), "USER %s\r\n", name);
+        if (reply == CONTINUE)
+            reply =
+                ftpfs_pool_command (me, sock, answer, sizeof (answer), "PASS %s\r\n", pass);
+    }
+
+    wipe_password (pass);
+    g_free (name);
+
+    if (reply != COMPLETE)
+    {
+        /* empty answer: connection is lost or timed out, it's not a refusal */
+        *refused = answer[0] != '\0';
+        return FALSE;
+    }
+
+    /* new connection doesn't inherit options of the first one */
+    if (FTP_SUPER (super)->mlst_opts != NULL)
+        ftpfs_pool_command (me, sock, answer, sizeof (answer), "%s\r\n",
+                            FTP_SUPER (super)->mlst_opts);
+
+    *refused = FALSE;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Hand control connection with started transfer over to file handler and switch superblock
+ * to another connection from the pool, so other commands (directory listings, another
+ * transfer) can be sent while the transfer is in progress.
+ * If no connection is available, the transfer keeps connection of superblock busy.
+ */
 
 static void
-ftpfs_linear_abort (struct vfs_class *me, vfs_file_handler_t * fh)
+ftpfs_connection_detach (struct vfs_class *me, struct vfs_s_super *super, ftp_connection_t * conn)
+{
+    ftp_super_t *ftp_super = FTP_SUPER (super);
+    int sock;
+
+    conn->sock = -1;
+    conn->isbinary = TYPE_UNKNOWN;
+    conn->busy = FALSE;
+    conn->current_dir = NULL;
+    ftpfs_connection_switch (ftp_super, conn);
+
+    if (ftp_super->idle_connections != NULL)
+    {
+        ftp_connection_t *idle = (ftp_connection_t *) ftp_super->idle_connections->data;
+
+        ftp_super->idle_connections =
+            g_slist_delete_link (ftp_super->idle_connections, ftp_super->idle_connections);
+        ftpfs_connection_switch (ftp_super, idle);
+        g_free (idle);
+        return;
+    }
+
+    if (ftp_super->connections < ftp_super->max_connections)
+    {
+        gboolean refused = FALSE;
+
+        sock = ftpfs_open_socket (me, super);
+        if (sock != -1 && ftpfs_login_pool_connection (me, super, sock, &refused))
+        {
+            ftp_super->sock = sock;
+            ftp_super->isbinary = TYPE_UNKNOWN;
+            ftp_super->ctl_connection_busy = FALSE;
+            ftp_super->connections++;
+            return;
+        }
+
+        if (sock != -1)
+            close (sock);
+
+        /* server doesn't accept more connections: don't try again for each transfer */
+        if (refused)
+            ftp_super->max_connections = ftp_super->connections;
+    }
+
+    /* no free connection */
+    ftpfs_connection_switch (ftp_super, conn);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Put control connection of superblock, which transfer is finished on, to the pool and
+ * switch superblock back to its connection saved in conn.
+ */
+
+static void
+ftpfs_connection_release (ftp_super_t * ftp_super, ftp_connection_t * conn)
+{
+    ftp_connection_t *idle;
+
+    idle = g_new0 (ftp_connection_t, 1);
+    idle->sock = -1;
+    ftpfs_connection_switch (ftp_super, idle);
+    ftpfs_connection_switch (ftp_super, conn);
+    ftp_super->idle_connections = g_slist_prepend (ftp_super->idle_connections, idle);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+ftpfs_abort (struct vfs_class *me, struct vfs_s_super *super, int dsock)
 {
-    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
     ftp_super_t *ftp_super = FTP_SUPER (super);
     static unsigned char const ipbuf[3] = { IAC, IP, IAC };
     fd_set mask;
-    int dsock = FH_SOCK;
 
-    FH_SOCK = -1;
     ftp_super->ctl_connection_busy = FALSE;
 
     vfs_print_message ("%s", _("ftpfs: aborting transfer."));
@@ -1518,6 +1881,27 @@ ftpfs_linear_abort (struct vfs_class *me, vfs_file_handler_t * fh)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+ftpfs_linear_abort (struct vfs_class *me, vfs_file_handler_t * fh)
+{
+    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
+    ftp_connection_t *ctl = &FTP_FILE_HANDLER (fh)->ctl;
+    int dsock = FH_SOCK;
+
+    FH_SOCK = -1;
+
+    if (ctl->sock == -1)
+        ftpfs_abort (me, super, dsock);
+    else
+    {
+        ftpfs_connection_switch (FTP_SUPER (super), ctl);
+        ftpfs_abort (me, super, dsock);
+        ftpfs_connection_release (FTP_SUPER (super), ctl);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 #if 0
 static void
 resolve_symlink_without_ls_options (struct vfs_class *me, struct vfs_s_super *super,
@@ -1748,7 +2132,10 @@ ftpfs_dir_load (struct vfs_class *me, struct vfs_s_inode *dir, char *remote_path
     gettimeofday (&dir->timestamp, NULL);
     dir->timestamp.tv_sec += ftpfs_directory_timeout;
 
-    if (ftp_super->strict == RFC_STRICT)
+    if (ftp_super->use_mlsd)
+        sock = ftpfs_open_data_connection (me, super, "MLSD", cd_first ? NULL : remote_path,
+                                           TYPE_ASCII, 0);
+    else if (ftp_super->strict == RFC_STRICT)
         sock = ftpfs_open_data_connection (me, super, "LIST", 0, TYPE_ASCII, 0);
     else if (cd_first)
         /* Dirty hack to avoid autoprepending / to . */
@@ -1776,6 +2163,7 @@ ftpfs_dir_load (struct vfs_class *me, struct vfs_s_inode *dir, char *remote_path
         int i;
         size_t count_spaces = 0;
         int res;
+        gboolean ok;
         char lc_buffer[BUF_8K] = "\0";
 
         res = vfs_s_get_line_interruptible (me, lc_buffer, sizeof (lc_buffer), sock);
@@ -1803,8 +2191,13 @@ ftpfs_dir_load (struct vfs_class *me, struct vfs_s_inode *dir, char *remote_path
         ent = vfs_s_generate_entry (me, NULL, dir, 0);
         i = ent->ino->st.st_nlink;
 
-        if (!vfs_parse_ls_lga
-            (lc_buffer, &ent->ino->st, &ent->name, &ent->ino->linkname, &count_spaces))
+        if (ftp_super->use_mlsd)
+            ok = vfs_parse_mlsd (lc_buffer, &ent->ino->st, &ent->name, &ent->ino->linkname);
+        else
+            ok = vfs_parse_ls_lga (lc_buffer, &ent->ino->st, &ent->name, &ent->ino->linkname,
+                                   &count_spaces);
+
+        if (!ok)
             vfs_s_free_entry (me, ent);
         else
         {
@@ -1846,6 +2239,20 @@ ftpfs_dir_load (struct vfs_class *me, struct vfs_s_inode *dir, char *remote_path
     return 0;
 
   fallback:
+    if (ftp_super->use_mlsd)
+    {
+        if (!cd_first)
+        {
+            /* check that directory exists before blaming MLSD */
+            cd_first = TRUE;
+            goto again;
+        }
+
+        /* server announced MLST, but MLSD doesn't work: use LIST from now on */
+        ftp_super->use_mlsd = FALSE;
+        goto again;
+    }
+
     if (ftp_super->strict == RFC_AUTODETECT)
     {
         /* It's our first attempt to get a directory listing from this
@@ -1971,7 +2378,7 @@ ftpfs_file_store (struct vfs_class *me, vfs_file_handler_t * fh, char *name, cha
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-ftpfs_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
+ftpfs_linear_open (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset, gboolean detach)
 {
     char *name;
 
@@ -1986,6 +2393,9 @@ ftpfs_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
     if (FH_SOCK == -1)
         ERRNOR (EACCES, 0);
 
+    if (detach)
+        ftpfs_connection_detach (me, VFS_FILE_HANDLER_SUPER (fh), &FTP_FILE_HANDLER (fh)->ctl);
+
     fh->linear = LS_LINEAR_OPEN;
     FTP_FILE_HANDLER (fh)->append = FALSE;
     return 1;
@@ -1993,6 +2403,14 @@ ftpfs_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static int
+ftpfs_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset)
+{
+    return ftpfs_linear_open (me, fh, offset, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static ssize_t
 ftpfs_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, size_t len)
 {
@@ -2010,10 +2428,19 @@ ftpfs_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, siz
         ftpfs_linear_abort (me, fh);
     else if (n == 0)
     {
+        ftp_connection_t *ctl = &FTP_FILE_HANDLER (fh)->ctl;
+        gboolean detached = ctl->sock != -1;
+        int reply;
+
+        if (detached)
+            ftpfs_connection_switch (FTP_SUPER (super), ctl);
         FTP_SUPER (super)->ctl_connection_busy = FALSE;
         close (FH_SOCK);
         FH_SOCK = -1;
-        if ((ftpfs_get_reply (me, FTP_SUPER (super)->sock, NULL, 0) != COMPLETE))
+        reply = ftpfs_get_reply (me, FTP_SUPER (super)->sock, NULL, 0);
+        if (detached)
+            ftpfs_connection_release (FTP_SUPER (super), ctl);
+        if (reply != COMPLETE)
             ERRNOR (E_REMOTE, -1);
         return 0;
     }
@@ -2030,6 +2457,32 @@ ftpfs_linear_close (struct vfs_class *me, vfs_file_handler_t * fh)
         ftpfs_linear_abort (me, fh);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read part of file: start transfer from given offset (REST + RETR) and abort it
+ * when requested amount of data is received.
+ */
+
+static ssize_t
+ftpfs_read_range (struct vfs_class *me, vfs_file_handler_t * fh, off_t offset, void *buf,
+                  size_t len)
+{
+    size_t total = 0;
+    ssize_t n = 0;
+
+    /* transfer is finished here, so don't take control connection from superblock */
+    if (ftpfs_linear_open (me, fh, offset, FALSE) == 0)
+        return (-1);
+
+    while (total < len && (n = ftpfs_linear_read (me, fh, (char *) buf + total, len - total)) > 0)
+        total += (size_t) n;
+
+    ftpfs_linear_close (me, fh);
+    fh->linear = LS_NOT_LINEAR;
+
+    return n < 0 ? -1 : (ssize_t) total;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -2246,6 +2699,7 @@ ftpfs_fh_new (struct vfs_s_inode *ino, gboolean changed)
     fh = g_new0 (ftp_file_handler_t, 1);
     vfs_s_init_fh (VFS_FILE_HANDLER (fh), ino, changed);
     fh->sock = -1;
+    fh->ctl.sock = -1;
 
     return VFS_FILE_HANDLER (fh);
 }
@@ -2312,6 +2766,9 @@ ftpfs_fh_open (struct vfs_class *me, vfs_file_handler_t * fh, int flags, mode_t
 #endif
         setsockopt (fh->handle, SOL_SOCKET, SO_LINGER, &li, sizeof (li));
 
+        /* keep control connection of superblock free during upload */
+        ftpfs_connection_detach (me, VFS_FILE_HANDLER_SUPER (fh), &ftp->ctl);
+
         if (fh->ino->localname != NULL)
         {
             unlink (fh->ino->localname);
@@ -2336,15 +2793,23 @@ ftpfs_fh_close (struct vfs_class *me, vfs_file_handler_t * fh)
     if (fh->handle != -1 && fh->ino->localname == NULL)
     {
         ftp_super_t *ftp = FTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+        ftp_connection_t *ctl = &FTP_FILE_HANDLER (fh)->ctl;
+        gboolean detached = ctl->sock != -1;
+        int reply;
 
         close (fh->handle);
         fh->handle = -1;
+        if (detached)
+            ftpfs_connection_switch (ftp, ctl);
         ftp->ctl_connection_busy = FALSE;
         /* File is stored to destination already, so
          * we prevent VFS_SUBCLASS (me)->ftpfs_file_store() call from vfs_s_close ()
          */
         fh->changed = FALSE;
-        if (ftpfs_get_reply (me, ftp->sock, NULL, 0) != COMPLETE)
+        reply = ftpfs_get_reply (me, ftp->sock, NULL, 0);
+        if (detached)
+            ftpfs_connection_release (ftp, ctl);
+        if (reply != COMPLETE)
             ERRNOR (EIO, -1);
         vfs_s_invalidate (me, VFS_FILE_HANDLER_SUPER (fh));
     }
@@ -2726,6 +3191,7 @@ vfs_init_ftpfs (void)
     ftpfs_subclass.linear_start = ftpfs_linear_start;
     ftpfs_subclass.linear_read = ftpfs_linear_read;
     ftpfs_subclass.linear_close = ftpfs_linear_close;
+    ftpfs_subclass.read_range = ftpfs_read_range;
     vfs_register_class (vfs_ftpfs_ops);
 }
 
@@ -42,6 +42,10 @@
 #include "cpio/cpio.h"
 #endif
 
+#ifdef ENABLE_VFS_DECOMPRESS
+#include "decompress/decompress.h"
+#endif
+
 #ifdef ENABLE_VFS_EXTFS
 #include "extfs/extfs.h"
 #endif
@@ -74,6 +78,10 @@
 #include "undelfs/undelfs.h"
 #endif
 
+#ifdef ENABLE_VFS_ZIP
+#include "zip/zip.h"
+#endif
+
 #include "plugins_init.h"
 
 /*** global variables ****************************************************************************/
@@ -103,6 +111,13 @@ vfs_plugins_init (void)
 #ifdef ENABLE_VFS_TAR
     vfs_init_tarfs ();
 #endif /* ENABLE_VFS_TAR */
+#ifdef ENABLE_VFS_ZIP
+    vfs_init_zipfs ();
+#endif /* ENABLE_VFS_ZIP */
+#ifdef ENABLE_VFS_DECOMPRESS
+    /* must be registered before sfs to take over its decompression prefixes */
+    vfs_init_decompressfs ();
+#endif /* ENABLE_VFS_DECOMPRESS */
 #ifdef ENABLE_VFS_SFS
     vfs_init_sfs ();
 #endif /* ENABLE_VFS_SFS */
@@ -526,6 +526,10 @@ sftpfs_close_connection (struct vfs_s_super *super, const char *shutdown_message
     /* no mc_return_*_if_error() here because of abort open_connection handling too */
     (void) mcerror;
 
+    g_slist_free_full (sftpfs_super->idle_channels, (GDestroyNotify) libssh2_sftp_shutdown);
+    sftpfs_super->idle_channels = NULL;
+    sftpfs_super->channels = 0;
+
     if (sftpfs_super->sftp_session != NULL)
     {
         libssh2_sftp_shutdown (sftpfs_super->sftp_session);
@@ -556,3 +560,59 @@ sftpfs_close_connection (struct vfs_s_super *super, const char *shutdown_message
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get SFTP channel for file transfer.
+ *
+ * OpenSSH sftp-server handles requests of one channel in order, so directory listings and
+ * stats would wait for the whole read-ahead or write-behind window of opened files.
+ * Each opened file gets its own channel in the same SSH session instead. Channels are reused
+ * after files are closed. If channel cannot be opened or there are SFTP_MAX_CHANNELS channels
+ * already, the main channel is shared.
+ *
+ * @param super connection data
+ * @return SFTP channel
+ */
+
+LIBSSH2_SFTP *
+sftpfs_channel_get (sftpfs_super_t * super)
+{
+    LIBSSH2_SFTP *sftp_session;
+
+    if (super->idle_channels != NULL)
+    {
+        sftp_session = (LIBSSH2_SFTP *) super->idle_channels->data;
+        super->idle_channels = g_slist_delete_link (super->idle_channels, super->idle_channels);
+        return sftp_session;
+    }
+
+    if (super->channels >= SFTP_MAX_CHANNELS)
+        return super->sftp_session;
+
+    sftp_session = libssh2_sftp_init (super->session);
+    if (sftp_session == NULL)
+    {
+        /* server doesn't allow more channels: don't try again */
+        super->channels = SFTP_MAX_CHANNELS;
+        return super->sftp_session;
+    }
+
+    super->channels++;
+    return sftp_session;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Return SFTP channel got by sftpfs_channel_get() for reuse.
+ *
+ * @param super        connection data
+ * @param sftp_session SFTP channel
+ */
+
+void
+sftpfs_channel_release (sftpfs_super_t * super, LIBSSH2_SFTP * sftp_session)
+{
+    if (sftp_session != NULL && sftp_session != super->sftp_session)
+        super->idle_channels = g_slist_prepend (super->idle_channels, sftp_session);
+}
+
+/* --------------------------------------------------------------------------------------------- */
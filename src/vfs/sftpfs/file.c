@@ -27,6 +27,7 @@
 #include <config.h>
 
 #include <errno.h>
+#include <string.h>             /* memcpy(), memmove() */
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
@@ -47,9 +48,19 @@ typedef struct
 {
     vfs_file_handler_t base;    /* base class */
 
+    LIBSSH2_SFTP *sftp_session; /* channel of file */
     LIBSSH2_SFTP_HANDLE *handle;
     int flags;
     mode_t mode;
+
+    /* number of outstanding read or write requests */
+    int window;
+    /* read-ahead data or write-behind data which is not acknowledged yet */
+    char *buf;
+    size_t buf_start;           /* start of unread data */
+    size_t buf_len;             /* end of data */
+    gboolean writing;           /* TRUE if buffer contains data to write */
+    gboolean sequential;        /* TRUE if file is read sequentially since open or seek */
 } sftpfs_file_handler_t;
 
 /*** file scope variables ************************************************************************/
@@ -82,20 +93,116 @@ sftpfs_reopen (vfs_file_handler_t * fh, GError ** mcerror)
 /* --------------------------------------------------------------------------------------------- */
 
 static int
-sftpfs_file__handle_error (sftpfs_super_t * super, int sftp_res, GError ** mcerror)
+sftpfs_file__handle_error (sftpfs_file_handler_t * file, int sftp_res, GError ** mcerror)
 {
-    if (sftpfs_is_sftp_error (super->sftp_session, sftp_res, LIBSSH2_FX_PERMISSION_DENIED))
+    sftpfs_super_t *super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (file));
+
+    if (sftpfs_is_sftp_error (file->sftp_session, sftp_res, LIBSSH2_FX_PERMISSION_DENIED))
         return -EACCES;
 
-    if (sftpfs_is_sftp_error (super->sftp_session, sftp_res, LIBSSH2_FX_NO_SUCH_FILE))
+    if (sftpfs_is_sftp_error (file->sftp_session, sftp_res, LIBSSH2_FX_NO_SUCH_FILE))
         return -ENOENT;
 
+    if (sftp_res == LIBSSH2_ERROR_SFTP_PROTOCOL)
+    {
+        sftpfs_sftperror_to_gliberror (super, file->sftp_session, sftp_res, mcerror);
+        return -1;
+    }
+
     if (!sftpfs_waitsocket (super, sftp_res, mcerror))
         return -1;
 
     return 0;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static inline size_t
+sftpfs_file_buf_size (const sftpfs_file_handler_t * file)
+{
+    return (size_t) file->window * SFTP_REQUEST_SIZE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Send write-behind data until no more than 'keep' bytes are waiting for acknowledgement.
+ *
+ * libssh2 splits data to requests and sends all of them at once. It returns as soon as
+ * some requests are acknowledged and expects unacknowledged data in the next call again,
+ * so data is kept in the buffer until it is acknowledged.
+ *
+ * @param file    the file handler
+ * @param keep    amount of data allowed to stay in the buffer
+ * @param mcerror pointer to the error handler
+ *
+ * @return 0 on success, negative value otherwise
+ */
+
+static ssize_t
+sftpfs_file_send (sftpfs_file_handler_t * file, size_t keep, GError ** mcerror)
+{
+    while (file->buf_len > keep)
+    {
+        ssize_t rc;
+
+        do
+        {
+            int err;
+
+            rc = libssh2_sftp_write (file->handle, file->buf, file->buf_len);
+            if (rc >= 0)
+                break;
+
+            err = sftpfs_file__handle_error (file, (int) rc, mcerror);
+            if (err < 0)
+                return err;
+        }
+        while (rc == LIBSSH2_ERROR_EAGAIN);
+
+        if (rc <= 0)
+            return rc < 0 ? rc : -1;
+
+        file->buf_len -= (size_t) rc;
+        memmove (file->buf, file->buf + rc, file->buf_len);
+    }
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Complete pending write requests and drop read-ahead data. File position of libssh2 handle
+ * is set to the position of the file handler.
+ *
+ * @param fh      the file handler
+ * @param mcerror pointer to the error handler
+ *
+ * @return 0 on success, negative value otherwise
+ */
+
+static ssize_t
+sftpfs_file_flush (vfs_file_handler_t * fh, GError ** mcerror)
+{
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+
+    if (file->writing)
+    {
+        ssize_t rc;
+
+        rc = sftpfs_file_send (file, 0, mcerror);
+        if (rc < 0)
+            return rc;
+    }
+    else if (file->buf_start < file->buf_len)
+        libssh2_sftp_seek64 (file->handle, fh->pos);
+
+    file->buf_start = 0;
+    file->buf_len = 0;
+    file->writing = FALSE;
+
+    return 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -107,6 +214,7 @@ sftpfs_fh_new (struct vfs_s_inode * ino, gboolean changed)
 
     fh = g_new0 (sftpfs_file_handler_t, 1);
     vfs_s_init_fh (VFS_FILE_HANDLER (fh), ino, changed);
+    fh->window = SFTP_DEFAULT_WINDOW;
 
     return VFS_FILE_HANDLER (fh);
 }
@@ -156,6 +264,8 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
     else
         sftp_open_flags = LIBSSH2_FXF_READ;
 
+    file->sftp_session = sftpfs_channel_get (super);
+
     while (TRUE)
     {
         const char *fixfname;
@@ -165,7 +275,7 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
         fixfname = sftpfs_fix_filename (name, &fixfname_len);
 
         file->handle =
-            libssh2_sftp_open_ex (super->sftp_session, fixfname, fixfname_len, sftp_open_flags,
+            libssh2_sftp_open_ex (file->sftp_session, fixfname, fixfname_len, sftp_open_flags,
                                   sftp_open_mode, LIBSSH2_SFTP_OPENFILE);
         if (file->handle != NULL)
             break;
@@ -173,7 +283,8 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
         libssh_errno = libssh2_session_last_errno (super->session);
         if (libssh_errno != LIBSSH2_ERROR_EAGAIN)
         {
-            sftpfs_ssherror_to_gliberror (super, libssh_errno, mcerror);
+            sftpfs_sftperror_to_gliberror (super, file->sftp_session, libssh_errno, mcerror);
+            sftpfs_channel_release (super, file->sftp_session);
             g_free (name);
             g_free (file);
             return FALSE;
@@ -184,6 +295,7 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
 
     file->flags = flags;
     file->mode = mode;
+    file->sequential = FALSE;
 
     if (do_append)
     {
@@ -203,7 +315,10 @@ sftpfs_open_file (vfs_file_handler_t * fh, int flags, mode_t mode, GError ** mce
          */
 
         if (sftpfs_fstat (fh, &file_info, mcerror) == 0)
+        {
             libssh2_sftp_seek64 (file->handle, file_info.st_size);
+            fh->pos = file_info.st_size;
+        }
     }
     return TRUE;
 }
@@ -225,14 +340,20 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
     LIBSSH2_SFTP_ATTRIBUTES attrs;
     vfs_file_handler_t *fh = VFS_FILE_HANDLER (data);
     sftpfs_file_handler_t *sftpfs_fh = (sftpfs_file_handler_t *) data;
-    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
-    sftpfs_super_t *sftpfs_super = SFTP_SUPER (super);
 
     mc_return_val_if_error (mcerror, -1);
 
     if (sftpfs_fh->handle == NULL)
         return -1;
 
+    /* size of file should include written data */
+    if (sftpfs_fh->writing)
+    {
+        res = (int) sftpfs_file_flush (fh, mcerror);
+        if (res < 0)
+            return res;
+    }
+
     do
     {
         int err;
@@ -241,7 +362,7 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
         if (res >= 0)
             break;
 
-        err = sftpfs_file__handle_error (sftpfs_super, res, mcerror);
+        err = sftpfs_file__handle_error (sftpfs_fh, res, mcerror);
         if (err < 0)
             return err;
     }
@@ -256,6 +377,9 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
 /**
  * Read up to 'count' bytes from the file descriptor 'fh' to the buffer starting at 'buffer'.
  *
+ * The first read after open or seek requests 'count' bytes only. If reading goes on
+ * sequentially, the whole window is requested and the rest of data is kept for next reads.
+ *
  * @param fh      file handler
  * @param buffer  buffer for data
  * @param count   data size
@@ -269,7 +393,8 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
 {
     ssize_t rc;
     sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
-    sftpfs_super_t *super;
+    char *dest;
+    size_t size;
 
     mc_return_val_if_error (mcerror, -1);
 
@@ -280,23 +405,61 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
         return -1;
     }
 
-    super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+    if (file->writing)
+    {
+        rc = sftpfs_file_flush (fh, mcerror);
+        if (rc < 0)
+            return rc;
+    }
+
+    if (file->buf_start < file->buf_len)
+    {
+        size = MIN (count, file->buf_len - file->buf_start);
+        memcpy (buffer, file->buf + file->buf_start, size);
+        file->buf_start += size;
+        fh->pos += (off_t) size;
+        return (ssize_t) size;
+    }
+
+    if (!file->sequential || count >= sftpfs_file_buf_size (file))
+    {
+        dest = buffer;
+        size = count;
+    }
+    else
+    {
+        if (file->buf == NULL)
+            file->buf = g_malloc (sftpfs_file_buf_size (file));
+        dest = file->buf;
+        size = sftpfs_file_buf_size (file);
+    }
 
     do
     {
         int err;
 
-        rc = libssh2_sftp_read (file->handle, buffer, count);
+        rc = libssh2_sftp_read (file->handle, dest, size);
         if (rc >= 0)
             break;
 
-        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
+        err = sftpfs_file__handle_error (file, (int) rc, mcerror);
         if (err < 0)
             return err;
     }
     while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    fh->pos = (off_t) libssh2_sftp_tell64 (file->handle);
+    file->sequential = TRUE;
+
+    if (rc > 0 && dest == file->buf)
+    {
+        file->buf_start = MIN (count, (size_t) rc);
+        file->buf_len = (size_t) rc;
+        memcpy (buffer, file->buf, file->buf_start);
+        rc = (ssize_t) file->buf_start;
+    }
+
+    if (rc > 0)
+        fh->pos += (off_t) rc;
 
     return rc;
 }
@@ -306,6 +469,9 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
 /**
  * Write up to 'count' bytes from  the buffer starting at 'buffer' to the descriptor 'fh'.
  *
+ * Data is buffered and sent when the window is full, so up to window requests are
+ * in flight. Errors of buffered data are reported by next write, seek or close.
+ *
  * @param fh      file handler
  * @param buffer  buffer for data
  * @param count   data size
@@ -317,29 +483,51 @@ sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, GError **
 ssize_t
 sftpfs_write_file (vfs_file_handler_t * fh, const char *buffer, size_t count, GError ** mcerror)
 {
-    ssize_t rc;
     sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
-    sftpfs_super_t *super = SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+    size_t buf_size;
+    size_t written = 0;
 
     mc_return_val_if_error (mcerror, -1);
 
-    fh->pos = (off_t) libssh2_sftp_tell64 (file->handle);
+    if (!file->writing)
+    {
+        ssize_t rc;
 
-    do
+        /* drop read-ahead data */
+        rc = sftpfs_file_flush (fh, mcerror);
+        if (rc < 0)
+            return rc;
+
+        file->writing = TRUE;
+    }
+
+    buf_size = sftpfs_file_buf_size (file);
+    if (file->buf == NULL)
+        file->buf = g_malloc (buf_size);
+
+    while (written < count)
     {
-        int err;
+        size_t size;
 
-        rc = libssh2_sftp_write (file->handle, buffer, count);
-        if (rc >= 0)
-            break;
+        size = MIN (count - written, buf_size - file->buf_len);
+        memcpy (file->buf + file->buf_len, buffer + written, size);
+        file->buf_len += size;
+        written += size;
 
-        err = sftpfs_file__handle_error (super, (int) rc, mcerror);
-        if (err < 0)
-            return err;
+        /* window is full: wait for acknowledgement of the oldest requests */
+        if (file->buf_len == buf_size)
+        {
+            ssize_t rc;
+
+            rc = sftpfs_file_send (file, buf_size - 1, mcerror);
+            if (rc < 0)
+                return rc;
+        }
     }
-    while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    return rc;
+    fh->pos += (off_t) written;
+
+    return (ssize_t) written;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -356,13 +544,55 @@ sftpfs_write_file (vfs_file_handler_t * fh, const char *buffer, size_t count, GE
 int
 sftpfs_close_file (vfs_file_handler_t * fh, GError ** mcerror)
 {
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    ssize_t rc;
     int ret;
 
     mc_return_val_if_error (mcerror, -1);
 
-    ret = libssh2_sftp_close (SFTP_FILE_HANDLER (fh)->handle);
+    /* complete write-behind */
+    rc = sftpfs_file_flush (fh, mcerror);
+
+    MC_PTR_FREE (file->buf);
+
+    ret = libssh2_sftp_close (file->handle);
 
-    return ret == 0 ? 0 : -1;
+    sftpfs_channel_release (SFTP_SUPER (VFS_FILE_HANDLER_SUPER (fh)), file->sftp_session);
+    file->sftp_session = NULL;
+
+    return ret == 0 && rc == 0 ? 0 : -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set number of outstanding read or write requests of file.
+ *
+ * @param fh      file handler
+ * @param window  number of requests, 1 disables read-ahead and write-behind
+ * @param mcerror pointer to the error handler
+ *
+ * @return 0 on success, negative value otherwise
+ */
+
+int
+sftpfs_set_window (vfs_file_handler_t * fh, int window, GError ** mcerror)
+{
+    sftpfs_file_handler_t *file = SFTP_FILE_HANDLER (fh);
+    ssize_t rc;
+
+    mc_return_val_if_error (mcerror, -1);
+
+    if (window < 1)
+        return -1;
+
+    rc = sftpfs_file_flush (fh, mcerror);
+    if (rc < 0)
+        return (int) rc;
+
+    MC_PTR_FREE (file->buf);
+    file->window = window;
+
+    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -385,6 +615,29 @@ sftpfs_lseek (vfs_file_handler_t * fh, off_t offset, int whence, GError ** mcerr
 
     mc_return_val_if_error (mcerror, 0);
 
+    /* complete pending writes before the position is changed */
+    if (file->writing && sftpfs_file_flush (fh, mcerror) < 0)
+        return -1;
+
+    /* seek forward within read-ahead data */
+    if (file->buf_start < file->buf_len && (whence == SEEK_SET || whence == SEEK_CUR))
+    {
+        off_t delta;
+
+        delta = whence == SEEK_SET ? offset - fh->pos : offset;
+        if (delta >= 0 && (uintmax_t) delta <= file->buf_len - file->buf_start)
+        {
+            file->buf_start += (size_t) delta;
+            fh->pos += delta;
+            return fh->pos;
+        }
+    }
+
+    /* drop read-ahead data */
+    file->buf_start = 0;
+    file->buf_len = 0;
+    file->sequential = FALSE;
+
     switch (whence)
     {
     case SEEK_SET:
@@ -203,6 +203,23 @@ sftpfs_is_sftp_error (LIBSSH2_SFTP * sftp_session, int sftp_res, int sftp_error)
 
 void
 sftpfs_ssherror_to_gliberror (sftpfs_super_t * super, int libssh_errno, GError ** mcerror)
+{
+    sftpfs_sftperror_to_gliberror (super, super->sftp_session, libssh_errno, mcerror);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Convert libssh error to GError object. SFTP protocol error is taken from given channel.
+ *
+ * @param super        extra data for SFTP connection
+ * @param sftp_session SFTP channel where error was occurred
+ * @param libssh_errno errno from libssh
+ * @param mcerror      pointer to the error object
+ */
+
+void
+sftpfs_sftperror_to_gliberror (sftpfs_super_t * super, LIBSSH2_SFTP * sftp_session,
+                               int libssh_errno, GError ** mcerror)
 {
     char *err = NULL;
     int err_len;
@@ -210,9 +227,9 @@ sftpfs_ssherror_to_gliberror (sftpfs_super_t * super, int libssh_errno, GError *
     mc_return_if_error (mcerror);
 
     libssh2_session_last_error (super->session, &err, &err_len, 1);
-    if (libssh_errno == LIBSSH2_ERROR_SFTP_PROTOCOL && super->sftp_session != NULL)
+    if (libssh_errno == LIBSSH2_ERROR_SFTP_PROTOCOL && sftp_session != NULL)
         mc_propagate_error (mcerror, libssh_errno, "%s %lu", err,
-                            libssh2_sftp_last_error (super->sftp_session));
+                            libssh2_sftp_last_error (sftp_session));
     else
         mc_propagate_error (mcerror, libssh_errno, "%s", err);
     g_free (err);
@@ -16,6 +16,13 @@
 
 #define SFTP_DEFAULT_PORT 22
 
+/* size of data in one read or write request sent by libssh2 */
+#define SFTP_REQUEST_SIZE 30000
+/* default number of outstanding read or write requests of file */
+#define SFTP_DEFAULT_WINDOW 32
+/* max number of SFTP channels for file transfers opened in one SSH session */
+#define SFTP_MAX_CHANNELS 4
+
 /* LIBSSH2_INVALID_SOCKET is defined in libssh2 >= 1.4.1 */
 #ifndef LIBSSH2_INVALID_SOCKET
 #define LIBSSH2_INVALID_SOCKET -1
@@ -45,6 +52,10 @@ typedef struct
     LIBSSH2_SESSION *session;
     LIBSSH2_SFTP *sftp_session;
 
+    /* SFTP channels for file transfers; sftp_session is kept for directory operations */
+    GSList *idle_channels;
+    int channels;               /* number of opened channels for file transfers */
+
     LIBSSH2_AGENT *agent;
 
     char *pubkey;
@@ -70,6 +81,8 @@ void sftpfs_deinit_config_variables_patterns (void);
 
 gboolean sftpfs_is_sftp_error (LIBSSH2_SFTP * sftp_session, int sftp_res, int sftp_error);
 void sftpfs_ssherror_to_gliberror (sftpfs_super_t * super, int libssh_errno, GError ** mcerror);
+void sftpfs_sftperror_to_gliberror (sftpfs_super_t * super, LIBSSH2_SFTP * sftp_session,
+                                    int libssh_errno, GError ** mcerror);
 gboolean sftpfs_waitsocket (sftpfs_super_t * super, int sftp_res, GError ** mcerror);
 
 const char *sftpfs_fix_filename (const char *file_name, unsigned int *length);
@@ -87,6 +100,8 @@ void sftpfs_fill_connection_data_from_config (struct vfs_s_super *super, GError
 int sftpfs_open_connection (struct vfs_s_super *super, GError ** mcerror);
 void sftpfs_close_connection (struct vfs_s_super *super, const char *shutdown_message,
                               GError ** mcerror);
+LIBSSH2_SFTP *sftpfs_channel_get (sftpfs_super_t * super);
+void sftpfs_channel_release (sftpfs_super_t * super, LIBSSH2_SFTP * sftp_session);
 
 vfs_file_handler_t *sftpfs_fh_new (struct vfs_s_inode *ino, gboolean changed);
 
@@ -101,6 +116,7 @@ ssize_t sftpfs_read_file (vfs_file_handler_t * fh, char *buffer, size_t count, G
 ssize_t sftpfs_write_file (vfs_file_handler_t * fh, const char *buffer, size_t count,
                            GError ** mcerror);
 int sftpfs_close_file (vfs_file_handler_t * fh, GError ** mcerror);
+int sftpfs_set_window (vfs_file_handler_t * fh, int window, GError ** mcerror);
 int sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror);
 off_t sftpfs_lseek (vfs_file_handler_t * fh, off_t offset, int whence, GError ** mcerror);
 
@@ -498,6 +498,33 @@ sftpfs_cb_close (void *data)
     return rc;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Callback for ctl VFS-function.
+ *
+ * @param data  file data handler
+ * @param ctlop control operation
+ * @param arg   argument of operation
+ * @return 1 if operation is done, 0 otherwise
+ */
+
+static int
+sftpfs_cb_ctl (void *data, int ctlop, void *arg)
+{
+    int rc;
+    GError *mcerror = NULL;
+
+    switch (ctlop)
+    {
+    case VFS_CTL_WINDOW:
+        rc = sftpfs_set_window (VFS_FILE_HANDLER (data), GPOINTER_TO_INT (arg), &mcerror);
+        mc_error_message (&mcerror, NULL);
+        return rc == 0 ? 1 : 0;
+    default:
+        return 0;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Callback for chmod VFS-function.
@@ -700,6 +727,7 @@ sftpfs_init_class (void)
     sftpfs_class->write = sftpfs_cb_write;
     sftpfs_class->close = sftpfs_cb_close;
     sftpfs_class->lseek = sftpfs_cb_lseek;
+    sftpfs_class->ctl = sftpfs_cb_ctl;
     sftpfs_class->unlink = sftpfs_cb_unlink;
     sftpfs_class->rename = sftpfs_cb_rename;
     sftpfs_class->ferrno = sftpfs_cb_errno;
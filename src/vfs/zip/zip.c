@@ -0,0 +1,970 @@
+/*
+   Virtual File System: ZIP file system.
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  \brief Source: Virtual File System: ZIP file system
+ *
+ *  Read-only access to ZIP archives without external helpers. The archive is listed
+ *  by reading of its central directory at the end of file only. Members are read
+ *  directly from the archive: stored ones with random access, deflated ones are inflated
+ *  on the fly.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "lib/global.h"
+#include "lib/util.h"
+#include "lib/widget.h"         /* message() */
+
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/utilvfs.h"
+#include "lib/vfs/xdirentry.h"
+#include "lib/vfs/gc.h"         /* vfs_rmstamp */
+
+#include "zip.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define ZIP_SUPER(super) ((zip_super_t *) (super))
+#define ZIP_FILE_HANDLER(fh) ((zip_fh_t *) (fh))
+
+/* signatures of records */
+#define ZIP_LOCAL_SIG       0x04034b50
+#define ZIP_CDIR_SIG        0x02014b50
+#define ZIP_EOCD_SIG        0x06054b50
+#define ZIP_EOCD64_SIG      0x06064b50
+#define ZIP_EOCD64_LOC_SIG  0x07064b50
+
+/* sizes of fixed parts of records */
+#define ZIP_LOCAL_SIZE      30
+#define ZIP_CDIR_SIZE       46
+#define ZIP_EOCD_SIZE       22
+#define ZIP_EOCD64_SIZE     56
+#define ZIP_EOCD64_LOC_SIZE 20
+
+/* end of central directory record can be followed by comment up to 64K long */
+#define ZIP_EOCD_MAX_SEARCH (ZIP_EOCD_SIZE + 0xffff)
+
+#define ZIP_METHOD_STORED   0
+#define ZIP_METHOD_DEFLATED 8
+
+#define ZIP_FLAG_ENCRYPTED  0x0001
+
+#define ZIP_HOST_UNIX       3
+
+#define ZIP_ATTR_READONLY   0x01
+#define ZIP_ATTR_DIR        0x10
+
+/* extra fields */
+#define ZIP_EXTRA_ZIP64     0x0001
+#define ZIP_EXTRA_TIMESTAMP 0x5455
+#define ZIP_EXTRA_UNIX      0x7875
+
+#define ZIP_MAX32 ((off_t) 0xffffffffU)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    guint16 method;             /* compression method */
+    guint16 flags;              /* general purpose flags */
+    guint32 crc;                /* CRC-32 of uncompressed data */
+    off_t csize;                /* compressed size */
+    off_t size;                 /* uncompressed size */
+    off_t offset;               /* offset of local header in archive */
+} zip_member_t;
+
+typedef struct
+{
+    struct vfs_s_super base;    /* base class */
+
+    int fd;
+    struct stat st;
+    off_t shift;                /* size of data prepended to archive, e.g. self-extractor */
+    GArray *members;            /* zip_member_t, indexed by data_offset of inode */
+} zip_super_t;
+
+typedef struct
+{
+    vfs_file_handler_t base;    /* base class */
+
+    gboolean opened;            /* member is prepared for reading */
+    zip_member_t member;
+    off_t data;                 /* offset of member data in archive */
+    z_stream zs;
+    gboolean zs_init;
+    off_t in_pos;               /* number of compressed bytes read */
+    off_t out_pos;              /* number of uncompressed bytes got, -1 if CRC isn't computed */
+    uLong crc;                  /* CRC-32 of uncompressed bytes got */
+    unsigned char in_buf[BUF_8K];
+} zip_fh_t;
+
+/*** file scope variables ************************************************************************/
+
+static struct vfs_s_subclass zip_subclass;
+static struct vfs_class *vfs_zipfs_ops = VFS_CLASS (&zip_subclass);
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline guint16
+zip_get16 (const unsigned char *p)
+{
+    return (guint16) (p[0] | (p[1] << 8));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline guint32
+zip_get32 (const unsigned char *p)
+{
+    return (guint32) zip_get16 (p) | ((guint32) zip_get16 (p + 2) << 16);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline guint64
+zip_get64 (const unsigned char *p)
+{
+    return (guint64) zip_get32 (p) | ((guint64) zip_get32 (p + 4) << 32);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+zip_get_var (const unsigned char *p, size_t len)
+{
+    guint32 value = 0;
+
+    while (len-- != 0)
+        value = (value << 8) | p[len];
+
+    return value;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+zip_read_at (int fd, off_t offset, void *buf, size_t len)
+{
+    char *p = (char *) buf;
+
+    if (mc_lseek (fd, offset, SEEK_SET) != offset)
+        return FALSE;
+
+    while (len != 0)
+    {
+        ssize_t n;
+
+        n = mc_read (fd, p, len);
+        if (n <= 0)
+            return FALSE;
+
+        p += n;
+        len -= (size_t) n;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Convert MS-DOS date and time (local) to time_t.
+ */
+
+static time_t
+zip_dos_time (guint16 date, guint16 dtime)
+{
+    struct tm tm;
+
+    memset (&tm, 0, sizeof (tm));
+    tm.tm_year = ((date >> 9) & 0x7f) + 80;
+    tm.tm_mon = ((date >> 5) & 0x0f) - 1;
+    tm.tm_mday = date & 0x1f;
+    tm.tm_hour = (dtime >> 11) & 0x1f;
+    tm.tm_min = (dtime >> 5) & 0x3f;
+    tm.tm_sec = (dtime & 0x1f) * 2;
+    tm.tm_isdst = -1;
+
+    return mktime (&tm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get values from extra fields of central directory record.
+ */
+
+static void
+zip_parse_extra (const unsigned char *p, size_t len, zip_member_t * m, struct stat *st)
+{
+    while (len >= 4)
+    {
+        guint16 id;
+        size_t size;
+        const unsigned char *d;
+
+        id = zip_get16 (p);
+        size = zip_get16 (p + 2);
+        d = p + 4;
+
+        if (size > len - 4)
+            break;
+
+        switch (id)
+        {
+        case ZIP_EXTRA_ZIP64:
+            {
+                size_t n = size;
+
+                /* only values which don't fit to the central directory record are here */
+                if (m->size == ZIP_MAX32 && n >= 8)
+                {
+                    m->size = (off_t) zip_get64 (d);
+                    d += 8;
+                    n -= 8;
+                }
+                if (m->csize == ZIP_MAX32 && n >= 8)
+                {
+                    m->csize = (off_t) zip_get64 (d);
+                    d += 8;
+                    n -= 8;
+                }
+                if (m->offset == ZIP_MAX32 && n >= 8)
+                    m->offset = (off_t) zip_get64 (d);
+            }
+            break;
+
+        case ZIP_EXTRA_TIMESTAMP:
+            /* flags and modification time in UTC if bit 0 of flags is set */
+            if (size >= 5 && (d[0] & 1) != 0)
+            {
+                st->st_mtime = (time_t) (gint32) zip_get32 (d + 1);
+                st->st_atime = st->st_ctime = st->st_mtime;
+            }
+            break;
+
+        case ZIP_EXTRA_UNIX:
+            /* version 1: size of uid, uid, size of gid, gid */
+            if (size >= 3 && d[0] == 1 && d[1] <= 4 && (size_t) d[1] + 3 <= size)
+            {
+                size_t usize = d[1], gsize = d[2 + usize];
+
+                st->st_uid = (uid_t) zip_get_var (d + 2, usize);
+                if (gsize <= 4 && usize + gsize + 3 <= size)
+                    st->st_gid = (gid_t) zip_get_var (d + 3 + usize, gsize);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        p += 4 + size;
+        len -= 4 + size;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_super *
+zip_new_archive (struct vfs_class *me)
+{
+    zip_super_t *arch;
+
+    arch = g_new0 (zip_super_t, 1);
+    arch->base.me = me;
+    arch->fd = -1;
+    arch->members = g_array_new (FALSE, FALSE, sizeof (zip_member_t));
+
+    return VFS_SUPER (arch);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zip_free_archive (struct vfs_class *me, struct vfs_s_super *super)
+{
+    zip_super_t *arch = ZIP_SUPER (super);
+
+    (void) me;
+
+    if (arch->fd != -1)
+    {
+        mc_close (arch->fd);
+        arch->fd = -1;
+    }
+    g_array_free (arch->members, TRUE);
+    arch->members = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Prepare member for reading.
+ *
+ * @return 0 on success, errno value otherwise
+ */
+
+static int
+zip_member_open (zip_super_t * arch, zip_fh_t * zfh, const zip_member_t * m)
+{
+    unsigned char h[ZIP_LOCAL_SIZE];
+
+    if ((m->flags & ZIP_FLAG_ENCRYPTED) != 0)
+        return EACCES;
+
+    if (m->method != ZIP_METHOD_STORED && m->method != ZIP_METHOD_DEFLATED)
+        return EOPNOTSUPP;
+
+    /* name and extra field in local header can differ from central directory ones */
+    if (!zip_read_at (arch->fd, m->offset, h, sizeof (h)) || zip_get32 (h) != ZIP_LOCAL_SIG)
+        return EIO;
+
+    zfh->member = *m;
+    zfh->data = m->offset + ZIP_LOCAL_SIZE + zip_get16 (h + 26) + zip_get16 (h + 28);
+    zfh->crc = crc32 (0L, Z_NULL, 0);
+
+    if (m->method == ZIP_METHOD_DEFLATED)
+    {
+        if (inflateInit2 (&zfh->zs, -MAX_WBITS) != Z_OK)
+            return ENOMEM;
+        zfh->zs_init = TRUE;
+    }
+
+    zfh->opened = TRUE;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zip_member_close (zip_fh_t * zfh)
+{
+    if (zfh->zs_init)
+    {
+        inflateEnd (&zfh->zs);
+        zfh->zs_init = FALSE;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Inflate next part of deflated member.
+ *
+ * @return number of uncompressed bytes, -1 on error
+ */
+
+static ssize_t
+zip_inflate (zip_super_t * arch, zip_fh_t * zfh, char *buf, size_t count)
+{
+    z_stream *zs = &zfh->zs;
+    size_t got;
+
+    zs->next_out = (Bytef *) buf;
+    zs->avail_out = (uInt) count;
+
+    while (zs->avail_out != 0)
+    {
+        int r;
+
+        if (zs->avail_in == 0 && zfh->in_pos < zfh->member.csize)
+        {
+            size_t n;
+
+            n = (size_t) MIN ((off_t) sizeof (zfh->in_buf), zfh->member.csize - zfh->in_pos);
+            if (!zip_read_at (arch->fd, zfh->data + zfh->in_pos, zfh->in_buf, n))
+                return (-1);
+
+            zfh->in_pos += (off_t) n;
+            zs->next_in = zfh->in_buf;
+            zs->avail_in = (uInt) n;
+        }
+
+        /* zlib can keep decoded data after the whole input is consumed,
+           so inflate() is called until the end of stream is reached */
+        r = inflate (zs, Z_NO_FLUSH);
+        if (r == Z_STREAM_END)
+            break;
+        if (r == Z_BUF_ERROR && zs->avail_in == 0 && zfh->in_pos >= zfh->member.csize)
+            break;              /* no progress is possible: member is truncated */
+        if (r != Z_OK)
+            return (-1);
+    }
+
+    got = count - zs->avail_out;
+    zfh->crc = crc32 (zfh->crc, (const Bytef *) buf, (uInt) got);
+    zfh->out_pos += (off_t) got;
+
+    return (ssize_t) got;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read part of member.
+ *
+ * Deflated data can't be read at random position: the stream is restarted if position
+ * is before the current one and data before position is skipped.
+ *
+ * CRC is checked when the end of member is reached. Stored members are read with random
+ * access, so their CRC is checked only if member is read sequentially from the start.
+ *
+ * @return number of read bytes, 0 at end of member, -1 on error
+ */
+
+static ssize_t
+zip_member_read (zip_super_t * arch, zip_fh_t * zfh, off_t pos, char *buf, size_t count)
+{
+    const zip_member_t *m = &zfh->member;
+    ssize_t n;
+
+    if (pos >= m->size || count == 0)
+        return 0;
+
+    count = (size_t) MIN ((off_t) count, m->size - pos);
+
+    if (m->method == ZIP_METHOD_STORED)
+    {
+        if (mc_lseek (arch->fd, zfh->data + pos, SEEK_SET) != zfh->data + pos)
+            return (-1);
+
+        if (pos == 0)
+        {
+            zfh->out_pos = 0;
+            zfh->crc = crc32 (0L, Z_NULL, 0);
+        }
+        else if (pos != zfh->out_pos)
+            zfh->out_pos = -1;  /* don't check CRC until member is read from the start */
+
+        n = mc_read (arch->fd, buf, count);
+        if (n > 0 && zfh->out_pos != -1)
+        {
+            zfh->crc = crc32 (zfh->crc, (const Bytef *) buf, (uInt) n);
+            zfh->out_pos += (off_t) n;
+        }
+    }
+    else
+    {
+        if (pos < zfh->out_pos)
+        {
+            inflateReset (&zfh->zs);
+            zfh->zs.avail_in = 0;
+            zfh->in_pos = 0;
+            zfh->out_pos = 0;
+            zfh->crc = crc32 (0L, Z_NULL, 0);
+        }
+
+        while (zfh->out_pos < pos)
+        {
+            char skip[BUF_8K];
+
+            n = zip_inflate (arch, zfh, skip,
+                             (size_t) MIN ((off_t) sizeof (skip), pos - zfh->out_pos));
+            if (n <= 0)
+                return (-1);
+        }
+
+        n = zip_inflate (arch, zfh, buf, count);
+    }
+
+    /* member is truncated or corrupted */
+    if (n == 0 || (n > 0 && zfh->out_pos == m->size && zfh->crc != m->crc))
+        return (-1);
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+zip_read_link (zip_super_t * arch, const zip_member_t * m)
+{
+    zip_fh_t *zfh;
+    char *link = NULL;
+
+    if (m->size <= 0 || m->size >= MC_MAXPATHLEN)
+        return NULL;
+
+    zfh = g_new0 (zip_fh_t, 1);
+
+    if (zip_member_open (arch, zfh, m) == 0)
+    {
+        link = g_malloc ((size_t) m->size + 1);
+        if (zip_member_read (arch, zfh, 0, link, (size_t) m->size) != (ssize_t) m->size)
+            MC_PTR_FREE (link);
+        else
+            link[m->size] = '\0';
+    }
+
+    zip_member_close (zfh);
+    g_free (zfh);
+
+    return link;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create entry from central directory record.
+ */
+
+static void
+zip_insert_member (struct vfs_class *me, struct vfs_s_super *super, const unsigned char *h)
+{
+    zip_super_t *arch = ZIP_SUPER (super);
+    size_t name_len;
+    guint32 attr;
+    zip_member_t m;
+    struct stat st;
+    gboolean is_dir;
+    char *name, *p, *tn;
+    struct vfs_s_inode *root;
+    struct vfs_s_entry *entry;
+
+    name_len = zip_get16 (h + 28);
+    attr = zip_get32 (h + 38);
+
+    m.flags = zip_get16 (h + 8);
+    m.method = zip_get16 (h + 10);
+    m.crc = zip_get32 (h + 16);
+    m.csize = (off_t) zip_get32 (h + 20);
+    m.size = (off_t) zip_get32 (h + 24);
+    m.offset = (off_t) zip_get32 (h + 42);
+
+    st = arch->st;
+    st.st_rdev = 0;
+    st.st_mtime = zip_dos_time (zip_get16 (h + 14), zip_get16 (h + 12));
+    st.st_atime = st.st_ctime = st.st_mtime;
+    zip_parse_extra (h + ZIP_CDIR_SIZE + name_len, zip_get16 (h + 30), &m, &st);
+    m.offset += arch->shift;
+
+    name = g_strndup ((const char *) h + ZIP_CDIR_SIZE, name_len);
+    is_dir = name_len != 0 && IS_PATH_SEP (name[name_len - 1]);
+
+    if ((zip_get16 (h + 4) >> 8) == ZIP_HOST_UNIX && (attr >> 16) != 0)
+    {
+        st.st_mode = (mode_t) (attr >> 16);
+        if (is_dir)
+            st.st_mode = (st.st_mode & 07777) | S_IFDIR;
+        else if ((st.st_mode & S_IFMT) == 0)
+            st.st_mode |= S_IFREG;
+    }
+    else
+    {
+        if ((attr & ZIP_ATTR_DIR) != 0)
+            is_dir = TRUE;
+        st.st_mode = is_dir ? (S_IFDIR | 0755) : (S_IFREG | 0644);
+        if ((attr & ZIP_ATTR_READONLY) != 0)
+            st.st_mode &= ~(S_IWUSR | S_IWGRP | S_IWOTH);
+    }
+
+    st.st_size = S_ISDIR (st.st_mode) ? 0 : m.size;
+    vfs_adjust_stat (&st);
+
+    /* remove trailing slashes and leading "/" and "./" */
+    for (tn = name + strlen (name) - 1; tn >= name && IS_PATH_SEP (*tn); tn--)
+        *tn = '\0';
+    for (p = name; IS_PATH_SEP (*p) || (p[0] == '.' && IS_PATH_SEP (p[1]));)
+        p += IS_PATH_SEP (*p) ? 1 : 2;
+
+    if (*p == '\0')
+    {
+        g_free (name);
+        return;
+    }
+
+    tn = strrchr (p, PATH_SEP);
+    if (tn == NULL)
+    {
+        root = super->root;
+        tn = p;
+    }
+    else
+    {
+        *tn = '\0';
+        root = vfs_s_find_inode (me, super, p, LINK_NO_FOLLOW, FL_MKDIR);
+        *tn = PATH_SEP;
+        tn++;
+    }
+
+    /* root == NULL if a parent of member is a file */
+    entry = root == NULL ? NULL
+        : VFS_SUBCLASS (me)->find_entry (me, root, tn, LINK_NO_FOLLOW, FL_NONE);
+
+    if (entry != NULL)
+    {
+        /* directory could be created for its members listed before it,
+           otherwise the first of duplicate entries is kept */
+        if (S_ISDIR (entry->ino->st.st_mode) && S_ISDIR (st.st_mode))
+        {
+            entry->ino->st.st_mode = st.st_mode;
+            entry->ino->st.st_uid = st.st_uid;
+            entry->ino->st.st_gid = st.st_gid;
+            entry->ino->st.st_atime = st.st_atime;
+            entry->ino->st.st_mtime = st.st_mtime;
+            entry->ino->st.st_ctime = st.st_ctime;
+        }
+    }
+    else if (root != NULL)
+    {
+        struct vfs_s_inode *inode;
+
+        if (S_ISLNK (st.st_mode))
+        {
+            char *link;
+
+            link = zip_read_link (arch, &m);
+            if (link == NULL)
+                st.st_mode = (st.st_mode & 07777) | S_IFREG;
+            inode = vfs_s_new_inode (me, super, &st);
+            inode->linkname = link;
+        }
+        else
+            inode = vfs_s_new_inode (me, super, &st);
+
+        if (S_ISDIR (st.st_mode))
+            inode->data_offset = -1;
+        else
+        {
+            g_array_append_val (arch->members, m);
+            inode->data_offset = (off_t) arch->members->len - 1;
+        }
+
+        entry = vfs_s_new_entry (me, tn, inode);
+        vfs_s_insert_entry (me, root, entry);
+    }
+
+    g_free (name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find central directory using the end of central directory record.
+ *
+ * @return TRUE on success
+ */
+
+static gboolean
+zip_find_central_directory (zip_super_t * arch, off_t * cd_offset, off_t * cd_size)
+{
+    unsigned char *buf;
+    unsigned char rec[ZIP_EOCD64_SIZE];
+    size_t len, i;
+    off_t start, eocd, cd_end;
+    guint64 disk, cd_disk, count, size, offset;
+    gboolean ok = FALSE;
+
+    if (arch->st.st_size < ZIP_EOCD_SIZE)
+        return FALSE;
+
+    len = (size_t) MIN (arch->st.st_size, (off_t) ZIP_EOCD_MAX_SEARCH);
+    start = arch->st.st_size - (off_t) len;
+    buf = g_malloc (len);
+
+    if (!zip_read_at (arch->fd, start, buf, len))
+        goto ret;
+
+    for (i = len - ZIP_EOCD_SIZE + 1; i-- != 0;)
+        if (zip_get32 (buf + i) == ZIP_EOCD_SIG
+            && i + ZIP_EOCD_SIZE + zip_get16 (buf + i + 20) <= len)
+            break;
+
+    if (i == (size_t) (-1))
+        goto ret;
+
+    eocd = start + (off_t) i;
+    cd_end = eocd;
+    disk = zip_get16 (buf + i + 4);
+    cd_disk = zip_get16 (buf + i + 6);
+    count = zip_get16 (buf + i + 10);
+    size = zip_get32 (buf + i + 12);
+    offset = zip_get32 (buf + i + 16);
+
+    if ((count == 0xffff || size == 0xffffffffU || offset == 0xffffffffU)
+        && eocd >= ZIP_EOCD64_LOC_SIZE + ZIP_EOCD64_SIZE
+        && zip_read_at (arch->fd, eocd - ZIP_EOCD64_LOC_SIZE, rec, ZIP_EOCD64_LOC_SIZE)
+        && zip_get32 (rec) == ZIP_EOCD64_LOC_SIG)
+    {
+        off_t eocd64;
+
+        /* ZIP64 end of central directory record: usually just before the locator */
+        eocd64 = (off_t) zip_get64 (rec + 8);
+        if (!zip_read_at (arch->fd, eocd64, rec, ZIP_EOCD64_SIZE)
+            || zip_get32 (rec) != ZIP_EOCD64_SIG)
+        {
+            eocd64 = eocd - ZIP_EOCD64_LOC_SIZE - ZIP_EOCD64_SIZE;
+            if (!zip_read_at (arch->fd, eocd64, rec, ZIP_EOCD64_SIZE)
+                || zip_get32 (rec) != ZIP_EOCD64_SIG)
+                goto ret;
+        }
+
+        cd_end = eocd64;
+        disk = zip_get32 (rec + 16);
+        cd_disk = zip_get32 (rec + 20);
+        size = zip_get64 (rec + 40);
+        offset = zip_get64 (rec + 48);
+    }
+
+    /* multi-volume archives are not supported */
+    if (disk != 0 || cd_disk != 0 || size > (guint64) cd_end || offset > (guint64) cd_end)
+        goto ret;
+
+    /* offsets are relative to the start of archive, not of file */
+    arch->shift = cd_end - (off_t) size - (off_t) offset;
+    if (arch->shift < 0)
+        goto ret;
+
+    *cd_offset = (off_t) offset + arch->shift;
+    *cd_size = (off_t) size;
+    ok = TRUE;
+
+  ret:
+    g_free (buf);
+    return ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+zip_read_central_directory (struct vfs_class *me, struct vfs_s_super *super)
+{
+    zip_super_t *arch = ZIP_SUPER (super);
+    off_t cd_offset, cd_size;
+    unsigned char *cd, *p;
+    size_t left;
+
+    if (!zip_find_central_directory (arch, &cd_offset, &cd_size))
+        return FALSE;
+
+    cd = g_try_malloc ((gsize) cd_size + 1);
+    if (cd == NULL || !zip_read_at (arch->fd, cd_offset, cd, (size_t) cd_size))
+    {
+        g_free (cd);
+        return FALSE;
+    }
+
+    for (p = cd, left = (size_t) cd_size;
+         left >= ZIP_CDIR_SIZE && zip_get32 (p) == ZIP_CDIR_SIG;)
+    {
+        size_t len;
+
+        len = ZIP_CDIR_SIZE + zip_get16 (p + 28) + zip_get16 (p + 30) + zip_get16 (p + 32);
+        if (len > left)
+            break;
+
+        zip_insert_member (me, super, p);
+
+        p += len;
+        left -= len;
+    }
+
+    g_free (cd);
+
+    return left == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+zip_open_archive (struct vfs_s_super *super, const vfs_path_t * vpath,
+                  const vfs_path_element_t * vpath_element)
+{
+    struct vfs_class *me = vpath_element->class;
+    zip_super_t *arch = ZIP_SUPER (super);
+    struct vfs_s_inode *root;
+    mode_t mode;
+
+    arch->fd = mc_open (vpath, O_RDONLY);
+    if (arch->fd == -1)
+    {
+        message (D_ERROR, MSG_ERROR, _("Cannot open zip archive\n%s"), vfs_path_as_str (vpath));
+        return -1;
+    }
+
+    super->name = g_strdup (vfs_path_as_str (vpath));
+    mc_stat (vpath, &arch->st);
+
+    mode = arch->st.st_mode & 07777;
+    mode |= (mode & 0444) >> 2; /* set eXec where Read is */
+    mode |= S_IFDIR;
+
+    root = vfs_s_new_inode (me, super, &arch->st);
+    root->st.st_mode = mode;
+    root->data_offset = -1;
+    root->st.st_nlink++;
+    root->st.st_dev = VFS_SUBCLASS (me)->rdev++;
+
+    super->root = root;
+
+    if (!zip_read_central_directory (me, super))
+    {
+        message (D_ERROR, MSG_ERROR, _("Inconsistent zip archive\n%s"), super->name);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void *
+zip_super_check (const vfs_path_t * vpath)
+{
+    static struct stat sb;
+    int stat_result;
+
+    stat_result = mc_stat (vpath, &sb);
+    return (stat_result == 0 ? &sb : NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+zip_super_same (const vfs_path_element_t * vpath_element, struct vfs_s_super *parc,
+                const vfs_path_t * vpath, void *cookie)
+{
+    struct stat *archive_stat = cookie; /* stat of main archive */
+
+    (void) vpath_element;
+
+    if (strcmp (parc->name, vfs_path_as_str (vpath)) != 0)
+        return 0;
+
+    /* Has the cached archive been changed on the disk? */
+    if (ZIP_SUPER (parc)->st.st_mtime < archive_stat->st_mtime)
+    {
+        /* Yes, reload! */
+        vfs_zipfs_ops->free ((vfsid) parc);
+        vfs_rmstamp (vfs_zipfs_ops, (vfsid) parc);
+        return 2;
+    }
+    /* Hasn't been modified, give it a new timeout */
+    vfs_stamp (vfs_zipfs_ops, (vfsid) parc);
+    return 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+zip_read (void *fh, char *buffer, size_t count)
+{
+    vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
+    struct vfs_s_super *super = VFS_FILE_HANDLER_SUPER (fh);
+    struct vfs_class *me = super->me;
+    zip_fh_t *zfh = ZIP_FILE_HANDLER (fh);
+    ssize_t res;
+
+    /* fh_open() is not called for files opened with O_LINEAR */
+    if (!zfh->opened && file->ino->data_offset >= 0)
+    {
+        int err;
+
+        err = zip_member_open (ZIP_SUPER (super), zfh,
+                               &g_array_index (ZIP_SUPER (super)->members, zip_member_t,
+                                               file->ino->data_offset));
+        if (err != 0)
+            ERRNOR (err, -1);
+    }
+
+    res = zip_member_read (ZIP_SUPER (super), zfh, file->pos, buffer, count);
+    if (res == -1)
+        ERRNOR (EIO, -1);
+
+    file->pos += res;
+    return res;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static vfs_file_handler_t *
+zip_fh_new (struct vfs_s_inode *ino, gboolean changed)
+{
+    zip_fh_t *fh;
+
+    fh = g_new0 (zip_fh_t, 1);
+    vfs_s_init_fh (VFS_FILE_HANDLER (fh), ino, changed);
+
+    return VFS_FILE_HANDLER (fh);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+zip_fh_open (struct vfs_class *me, vfs_file_handler_t * fh, int flags, mode_t mode)
+{
+    zip_super_t *arch = ZIP_SUPER (VFS_FILE_HANDLER_SUPER (fh));
+    int err;
+
+    (void) mode;
+
+    if ((flags & O_ACCMODE) != O_RDONLY)
+        ERRNOR (EROFS, -1);
+
+    if (fh->ino->data_offset < 0)
+        return 0;
+
+    err = zip_member_open (arch, ZIP_FILE_HANDLER (fh),
+                           &g_array_index (arch->members, zip_member_t, fh->ino->data_offset));
+    if (err != 0)
+        ERRNOR (err, -1);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zip_fh_free (vfs_file_handler_t * fh)
+{
+    zip_member_close (ZIP_FILE_HANDLER (fh));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_init_zipfs (void)
+{
+    vfs_init_subclass (&zip_subclass, "zipfs", VFS_READONLY, "zip");
+    vfs_zipfs_ops->read = zip_read;
+    vfs_zipfs_ops->setctl = NULL;
+    zip_subclass.archive_check = zip_super_check;
+    zip_subclass.archive_same = zip_super_same;
+    zip_subclass.new_archive = zip_new_archive;
+    zip_subclass.open_archive = zip_open_archive;
+    zip_subclass.free_archive = zip_free_archive;
+    zip_subclass.fh_new = zip_fh_new;
+    zip_subclass.fh_open = zip_fh_open;
+    zip_subclass.fh_free = zip_fh_free;
+    vfs_register_class (vfs_zipfs_ops);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -340,7 +340,7 @@ mcview_scan_for_file (WView * view, int direction)
             i = view->dir->len - 1;
         if (i == view->dir->len)
             i = 0;
-        if (!S_ISDIR (view->dir->list[i].st.st_mode))
+        if (!S_ISDIR (view->dir->list[i].st.mode))
             break;
     }
 
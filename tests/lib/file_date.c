@@ -0,0 +1,179 @@
+/*
+   lib - file_date() function testing
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "lib/timefmt.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    setenv ("TZ", "UTC", 1);
+    tzset ();
+
+    user_recent_timeformat = g_strdup ("%b %e %H:%M:%S");
+    user_old_timeformat = g_strdup ("%b %e  %Y");
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_free (user_recent_timeformat);
+    user_recent_timeformat = NULL;
+    g_free (user_old_timeformat);
+    user_old_timeformat = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_file_date_ds") */
+/* *INDENT-OFF* */
+static const struct test_file_date_ds
+{
+    time_t when;
+    const char *expected_result;
+} test_file_date_ds[] =
+{
+    { /* 0. */
+        0,
+        "Jan  1  1970"
+    },
+    { /* 1. the same cache slot as the previous one */
+        256,
+        "Jan  1  1970"
+    },
+    { /* 2. */
+        1000000000,
+        "Sep  9  2001"
+    },
+    { /* 3. again, from cache */
+        1000000000,
+        "Sep  9  2001"
+    },
+    { /* 4. the same cache slot as the previous one */
+        1000000256,
+        "Sep  9  2001"
+    },
+    { /* 5. */
+        86399,
+        "Jan  1  1970"
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_file_date_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_file_date, test_file_date_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    const char *actual_result;
+
+    /* when */
+    actual_result = file_date (data->when);
+
+    /* then */
+    mctest_assert_str_eq (actual_result, data->expected_result);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_file_date_recent)
+/* *INDENT-ON* */
+{
+    /* given */
+    time_t now;
+    char expected[BUF_SMALL];
+    const char *actual_result;
+    int i;
+
+    now = time (NULL) - 10;
+
+    for (i = 0; i < 3; i++)
+    {
+        time_t when = now + i * 256;
+
+        /* when */
+        actual_result = file_date (when);
+
+        /* then */
+        FMT_LOCALTIME (expected, sizeof (expected), user_recent_timeformat, when);
+        mctest_assert_str_eq (actual_result, expected);
+    }
+
+    /* when: format is replaced */
+    g_free (user_recent_timeformat);
+    user_recent_timeformat = g_strdup ("%H:%M");
+    actual_result = file_date (now);
+
+    /* then */
+    FMT_LOCALTIME (expected, sizeof (expected), user_recent_timeformat, now);
+    mctest_assert_str_eq (actual_result, expected);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_file_date, test_file_date_ds);
+    tcase_add_test (tc_core, test_file_date_recent);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "file_date.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
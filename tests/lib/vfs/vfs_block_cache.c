@@ -0,0 +1,318 @@
+/*
+   lib/vfs - test cache of blocks of remote file
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+
+#include "lib/vfs/blockcache.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+#define BLOCK_SIZE 16
+#define MAX_BLOCKS 8
+#define FILE_SIZE 1000
+
+static char file_data[FILE_SIZE];
+static off_t file_size;
+static int fetch_calls;
+static off_t fetch_offset;
+static size_t fetch_len;
+static gboolean fetch_fail;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+test_fetch (void *data, off_t offset, void *buf, size_t len)
+{
+    size_t n = 0;
+
+    (void) data;
+
+    fetch_calls++;
+    fetch_offset = offset;
+    fetch_len = len;
+
+    if (fetch_fail)
+        return (-1);
+
+    if (offset < file_size)
+        n = MIN (len, (size_t) (file_size - offset));
+    memcpy (buf, file_data + offset, n);
+    return (ssize_t) n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int i;
+
+    for (i = 0; i < FILE_SIZE; i++)
+        file_data[i] = (char) (i * 7 + i / 256);
+
+    file_size = FILE_SIZE;
+    fetch_calls = 0;
+    fetch_fail = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_sequential)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[10];
+    off_t pos = 0;
+    ssize_t n;
+
+    cache = vfs_block_cache_new (FILE_SIZE, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    while ((n = vfs_block_cache_read (cache, pos, buf, sizeof (buf))) > 0)
+    {
+        ck_assert_msg (memcmp (buf, file_data + pos, (size_t) n) == 0,
+                       "wrong data at offset %d", (int) pos);
+        pos += n;
+    }
+
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (pos, FILE_SIZE);
+    /* read-ahead: less requests than blocks */
+    ck_assert (fetch_calls < (FILE_SIZE + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_random)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[BLOCK_SIZE * 2];
+    ssize_t n;
+
+    cache = vfs_block_cache_new (FILE_SIZE, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    /* tail of file: only the last block is fetched */
+    n = vfs_block_cache_read (cache, FILE_SIZE - 5, buf, sizeof (buf));
+    mctest_assert_int_eq (n, 5);
+    ck_assert (memcmp (buf, file_data + FILE_SIZE - 5, 5) == 0);
+    mctest_assert_int_eq (fetch_calls, 1);
+    mctest_assert_int_eq (fetch_offset, (FILE_SIZE / BLOCK_SIZE) * BLOCK_SIZE);
+    mctest_assert_int_eq (fetch_len, BLOCK_SIZE);
+
+    /* cached block is not fetched again */
+    n = vfs_block_cache_read (cache, FILE_SIZE - 3, buf, 2);
+    mctest_assert_int_eq (n, 2);
+    mctest_assert_int_eq (fetch_calls, 1);
+
+    /* read across blocks */
+    n = vfs_block_cache_read (cache, 100, buf, sizeof (buf));
+    mctest_assert_int_eq (n, sizeof (buf));
+    ck_assert (memcmp (buf, file_data + 100, sizeof (buf)) == 0);
+
+    /* at end of file */
+    n = vfs_block_cache_read (cache, FILE_SIZE, buf, sizeof (buf));
+    mctest_assert_int_eq (n, 0);
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_eviction)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[1];
+    int i;
+
+    cache = vfs_block_cache_new (FILE_SIZE, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    /* non-sequential access of more blocks than cache can keep */
+    for (i = MAX_BLOCKS * 2; i >= 0; i -= 2)
+        vfs_block_cache_read (cache, i * BLOCK_SIZE, buf, 1);
+    mctest_assert_int_eq (g_hash_table_size (cache->blocks), MAX_BLOCKS);
+
+    /* the first block was dropped */
+    fetch_calls = 0;
+    vfs_block_cache_read (cache, MAX_BLOCKS * 2 * BLOCK_SIZE, buf, 1);
+    mctest_assert_int_eq (fetch_calls, 1);
+    mctest_assert_int_eq (buf[0], file_data[MAX_BLOCKS * 2 * BLOCK_SIZE]);
+
+    /* the recently used one is kept */
+    fetch_calls = 0;
+    vfs_block_cache_read (cache, 0, buf, 1);
+    mctest_assert_int_eq (fetch_calls, 0);
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_short_file)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[BLOCK_SIZE * 4];
+    ssize_t n;
+
+    /* file was shrunk after stat */
+    file_size = BLOCK_SIZE + 3;
+    cache = vfs_block_cache_new (FILE_SIZE, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    n = vfs_block_cache_read (cache, 0, buf, sizeof (buf));
+    mctest_assert_int_eq (n, BLOCK_SIZE + 3);
+    mctest_assert_int_eq (cache->size, BLOCK_SIZE + 3);
+
+    n = vfs_block_cache_read (cache, BLOCK_SIZE + 3, buf, sizeof (buf));
+    mctest_assert_int_eq (n, 0);
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_grown_file)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[FILE_SIZE];
+    off_t pos = 0;
+    ssize_t n;
+
+    /* file was grown after stat */
+    cache = vfs_block_cache_new (BLOCK_SIZE * 2, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    while ((n = vfs_block_cache_read (cache, pos, buf + pos, sizeof (buf) - pos)) > 0)
+        pos += n;
+
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (pos, FILE_SIZE);
+    ck_assert (memcmp (buf, file_data, FILE_SIZE) == 0);
+    mctest_assert_int_eq (vfs_block_cache_get_size (cache), FILE_SIZE);
+
+    vfs_block_cache_free (cache);
+
+    /* size is found without reading of whole file */
+    cache = vfs_block_cache_new (FILE_SIZE - BLOCK_SIZE * 2, BLOCK_SIZE, MAX_BLOCKS, test_fetch,
+                                 NULL);
+    fetch_calls = 0;
+    mctest_assert_int_eq (vfs_block_cache_get_size (cache), FILE_SIZE);
+    ck_assert (fetch_calls <= 3);
+
+    n = vfs_block_cache_read (cache, FILE_SIZE - 4, buf, sizeof (buf));
+    mctest_assert_int_eq (n, 4);
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_block_cache_error)
+/* *INDENT-ON* */
+{
+    vfs_block_cache_t *cache;
+    char buf[BLOCK_SIZE];
+    ssize_t n;
+
+    cache = vfs_block_cache_new (FILE_SIZE, BLOCK_SIZE, MAX_BLOCKS, test_fetch, NULL);
+
+    fetch_fail = TRUE;
+    n = vfs_block_cache_read (cache, 0, buf, sizeof (buf));
+    mctest_assert_int_eq (n, -1);
+
+    /* error is not cached */
+    fetch_fail = FALSE;
+    n = vfs_block_cache_read (cache, 0, buf, sizeof (buf));
+    mctest_assert_int_eq (n, sizeof (buf));
+
+    vfs_block_cache_free (cache);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, NULL);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_block_cache_sequential);
+    tcase_add_test (tc_core, test_block_cache_random);
+    tcase_add_test (tc_core, test_block_cache_eviction);
+    tcase_add_test (tc_core, test_block_cache_short_file);
+    tcase_add_test (tc_core, test_block_cache_grown_file);
+    tcase_add_test (tc_core, test_block_cache_error);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_block_cache.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,177 @@
+/*
+   lib/vfs - test vfs_parse_mlsd() functionality
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include "lib/vfs/utilvfs.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_vfs_parse_mlsd_ds") */
+/* *INDENT-OFF* */
+static const struct test_vfs_parse_mlsd_ds
+{
+    const char *input_string;
+    gboolean expected_result;
+    const char *expected_filename;
+    const char *expected_linkname;
+    mode_t expected_mode;
+    off_t expected_size;
+    time_t expected_mtime;
+    uid_t expected_uid;
+} test_vfs_parse_mlsd_ds[] =
+{
+    { /* 0. */
+        "type=file;size=1024;modify=20190102030405;UNIX.mode=0644;UNIX.uid=1000; file.txt",
+        TRUE,
+        "file.txt",
+        NULL,
+        S_IFREG | 0644,
+        1024,
+        1546398245,
+        1000
+    },
+    { /* 1. facts are case insensitive, fractions of second are ignored */
+        "Type=dir;Modify=19700101000001.123;Perm=flcdmpe;UNIX.mode=755; dir with spaces",
+        TRUE,
+        "dir with spaces",
+        NULL,
+        S_IFDIR | 0755,
+        0,
+        1,
+        0
+    },
+    { /* 2. symlink with target */
+        "type=OS.unix=slink:/etc/passwd;modify=20000229120000;UNIX.owner=0; link",
+        TRUE,
+        "link",
+        "/etc/passwd",
+        S_IFLNK | 0777,
+        0,
+        951825600,
+        0
+    },
+    { /* 3. no UNIX.mode: read-only file */
+        "type=file;perm=r;size=7; ro\r",
+        TRUE,
+        "ro",
+        NULL,
+        S_IFREG | 0444,
+        7,
+        0,
+        0
+    },
+    { /* 4. the listed directory itself */
+        "type=cdir;modify=20190102030405; .",
+        FALSE,
+        NULL,
+        NULL,
+        0,
+        0,
+        0,
+        0
+    },
+    { /* 5. no facts */
+        "name",
+        FALSE,
+        NULL,
+        NULL,
+        0,
+        0,
+        0,
+        0
+    },
+    { /* 6. no type */
+        "size=10; name",
+        FALSE,
+        NULL,
+        NULL,
+        0,
+        0,
+        0,
+        0
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_vfs_parse_mlsd_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_vfs_parse_mlsd, test_vfs_parse_mlsd_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct stat st;
+    char *filename = NULL;
+    char *linkname = NULL;
+    gboolean actual_result;
+
+    memset (&st, 0, sizeof (st));
+
+    /* when */
+    actual_result = vfs_parse_mlsd (data->input_string, &st, &filename, &linkname);
+
+    /* then */
+    mctest_assert_int_eq (actual_result, data->expected_result);
+    if (actual_result)
+    {
+        mctest_assert_str_eq (filename, data->expected_filename);
+        mctest_assert_str_eq (linkname, data->expected_linkname);
+        mctest_assert_int_eq (st.st_mode, data->expected_mode);
+        mctest_assert_int_eq (st.st_size, data->expected_size);
+        mctest_assert_int_eq (st.st_mtime, data->expected_mtime);
+        mctest_assert_int_eq (st.st_uid, data->expected_uid);
+    }
+
+    g_free (filename);
+    g_free (linkname);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_vfs_parse_mlsd, test_vfs_parse_mlsd_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_parse_mlsd.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,149 @@
+/*
+   src/editor - tests for the undo journal
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/vfs/vfs.h"
+
+#include "src/vfs/local/local.c"
+
+#include "src/editor/editundo.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_journal_ds") */
+/* *INDENT-OFF* */
+static const struct test_journal_ds
+{
+    gsize input_mem_limit;
+    off_t input_pushed;
+    off_t input_dropped;
+} test_journal_ds[] =
+{
+    { /* 0. in memory only */
+        1024 * 1024,
+        1000,
+        0
+    },
+    { /* 1. spilled to disk */
+        64 * 1024,
+        1000 * 1000,
+        0
+    },
+    { /* 2. head dropped from disk */
+        64 * 1024,
+        1000 * 1000,
+        300 * 1000
+    },
+    { /* 3. head dropped from disk and memory */
+        64 * 1024,
+        1000 * 1000,
+        990 * 1000
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_journal_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_journal, test_journal_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    edit_undo_journal_t journal;
+    off_t i;
+
+    edit_undo_journal_init (&journal, data->input_mem_limit);
+
+    /* when */
+    for (i = 0; i < data->input_pushed; i++)
+        edit_undo_journal_push (&journal, (int) (i % 251));
+    edit_undo_journal_drop (&journal, data->input_dropped);
+
+    /* then */
+    mctest_assert_int_eq (edit_undo_journal_length (&journal),
+                          data->input_pushed - data->input_dropped);
+    mctest_assert_true (journal.mem->len <= data->input_mem_limit);
+
+    for (i = data->input_pushed - 1; i >= data->input_dropped; i--)
+        mctest_assert_int_eq (edit_undo_journal_pop (&journal), (int) (i % 251));
+
+    mctest_assert_int_eq (edit_undo_journal_pop (&journal), -1);
+
+    edit_undo_journal_clean (&journal);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_journal, test_journal_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editundo__edit_undo_journal.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,200 @@
+/*
+   src/editor - tests for the word index
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "src/editor/edit-impl.h"
+#include "src/editor/editwords.h"
+
+static edit_buffer_t buf;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    edit_buffer_init (&buf, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    edit_buffer_clean (&buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+test_complete (const edit_word_index_t * index, const char *prefix)
+{
+    GString *compl[10];
+    GString *result;
+    gsize i, num;
+
+    num =
+        edit_word_index_complete (index, prefix, strlen (prefix), NULL, compl, G_N_ELEMENTS (compl));
+
+    result = g_string_new ("");
+    for (i = 0; i < num; i++)
+    {
+        if (i != 0)
+            g_string_append_c (result, ' ');
+        g_string_append (result, compl[i]->str);
+        g_string_free (compl[i], TRUE);
+    }
+
+    return g_string_free (result, FALSE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_word_index_ds") */
+/* *INDENT-OFF* */
+static const struct test_word_index_ds
+{
+    const char *input_text;
+    off_t input_position;
+    const char *input_inserted;
+    int input_deleted;
+    const char *input_prefix;
+    const char *expected_completions;
+} test_word_index_ds[] =
+{
+    { /* 0. no changes */
+        "foo(foobar, fo);\nfoobaz = foo;\n",
+        0,
+        "",
+        0,
+        "fo",
+        "foo foobar foobaz"
+    },
+    { /* 1. word is split by inserted char */
+        "foobar foo\n",
+        3,
+        " ",
+        0,
+        "fo",
+        "foo"
+    },
+    { /* 2. words are joined by deleted char */
+        "foo bar foo\n",
+        3,
+        "",
+        1,
+        "fo",
+        "foo foobar"
+    },
+    { /* 3. last occurrence is removed */
+        "foobar foo foobar\n",
+        0,
+        "",
+        7,
+        "foob",
+        "foobar"
+    },
+    { /* 4. all occurrences are removed */
+        "foobar foo\n",
+        0,
+        "",
+        7,
+        "foob",
+        ""
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_word_index_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_word_index, test_word_index_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    edit_word_index_t *index;
+    const char *p;
+    char *actual_completions;
+    int i;
+
+    for (p = data->input_text; *p != '\0'; p++)
+        edit_buffer_insert (&buf, *p);
+    while (buf.curs1 > data->input_position)
+        edit_buffer_insert_ahead (&buf, edit_buffer_backspace (&buf));
+
+    index = edit_word_index_new (&buf);
+
+    /* when */
+    for (p = data->input_inserted; *p != '\0'; p++)
+    {
+        edit_word_index_update (index, &buf, buf.curs1, buf.curs1, -1);
+        edit_buffer_insert (&buf, *p);
+        edit_word_index_update (index, &buf, buf.curs1 - 1, buf.curs1, 1);
+    }
+    for (i = 0; i < data->input_deleted; i++)
+    {
+        edit_word_index_update (index, &buf, buf.curs1, buf.curs1 + 1, -1);
+        edit_buffer_delete (&buf);
+        edit_word_index_update (index, &buf, buf.curs1, buf.curs1, 1);
+    }
+    actual_completions = test_complete (index, data->input_prefix);
+
+    /* then */
+    mctest_assert_str_eq (actual_completions, data->expected_completions);
+
+    g_free (actual_completions);
+    edit_word_index_free (index);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_word_index, test_word_index_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editwords__edit_word_index.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,277 @@
+/*
+   src/filemanager - tests for file_select_match() function
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+
+#include "src/filemanager/fileselect.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+#define NOW ((time_t) 1000000000)
+#define DAY (24 * 60 * 60)
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static file_entry_t *
+make_entry (const char *name, gboolean is_dir, off_t size, time_t mtime)
+{
+    file_entry_t *fe;
+
+    fe = g_new0 (file_entry_t, 1);
+    fe->fname = g_strdup (name);
+    fe->fnamelen = strlen (name);
+    fe->st.mode = is_dir ? S_IFDIR | 0755 : S_IFREG | 0644;
+    fe->st.size = size;
+    fe->st.mtime = mtime;
+
+    return fe;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+free_entry (file_entry_t * fe)
+{
+    g_free (fe->fname);
+    g_free (fe);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_file_select_match_ds") */
+/* *INDENT-OFF* */
+static const struct test_file_select_match_ds
+{
+    const char *input_pattern;
+    gboolean input_shell_patterns;
+    gboolean input_case_sensitive;
+    const char *input_name;
+    gboolean expected_result;
+} test_file_select_match_ds[] =
+{
+    { /* 0. any */
+        "*", TRUE, TRUE, "main.c", TRUE
+    },
+    { /* 1. suffix */
+        "*.c", TRUE, TRUE, "main.c", TRUE
+    },
+    { /* 2. suffix */
+        "*.c", TRUE, TRUE, "main.h", FALSE
+    },
+    { /* 3. suffix, case insensitive */
+        "*.C", TRUE, FALSE, "main.c", TRUE
+    },
+    { /* 4. suffix, case sensitive */
+        "*.C", TRUE, TRUE, "main.c", FALSE
+    },
+    { /* 5. prefix */
+        "core*", TRUE, TRUE, "core.1234", TRUE
+    },
+    { /* 6. prefix, name is shorter than literal */
+        "core*", TRUE, TRUE, "cor", FALSE
+    },
+    { /* 7. substring */
+        "*ain*", TRUE, TRUE, "main.c", TRUE
+    },
+    { /* 8. substring, case insensitive */
+        "*AIN*", TRUE, FALSE, "main.c", TRUE
+    },
+    { /* 9. exact */
+        "Makefile", TRUE, TRUE, "Makefile", TRUE
+    },
+    { /* 10. exact */
+        "Makefile", TRUE, TRUE, "Makefile.am", FALSE
+    },
+    { /* 11. glob */
+        "m?in.[ch]", TRUE, TRUE, "main.h", TRUE
+    },
+    { /* 12. glob */
+        "*.{c,h}", TRUE, TRUE, "main.o", FALSE
+    },
+    { /* 13. regular expression */
+        "ma.n\\.c", FALSE, TRUE, "main.c", TRUE
+    },
+    { /* 14. regular expression, entire name */
+        "ain", FALSE, TRUE, "main.c", FALSE
+    },
+    { /* 15. regular expression, literal */
+        "main", FALSE, TRUE, "main", TRUE
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_file_select_match_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_file_select_match, test_file_select_match_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    file_select_t *fs;
+    file_entry_t *fe;
+    gboolean actual;
+
+    fs = file_select_new (data->input_pattern, data->input_shell_patterns,
+                          data->input_case_sensitive, FALSE);
+    fe = make_entry (data->input_name, FALSE, 0, NOW);
+
+    /* when */
+    actual = file_select_match (fs, fe);
+
+    /* then */
+    mctest_assert_int_eq (actual, data->expected_result);
+
+    free_entry (fe);
+    file_select_free (fs);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_file_select_dirs)
+/* *INDENT-ON* */
+{
+    /* given */
+    file_select_t *fs;
+    file_entry_t *dotdot, *dir;
+
+    fs = file_select_new ("*", TRUE, TRUE, TRUE);
+    dotdot = make_entry ("..", TRUE, 0, NOW);
+    dir = make_entry ("src", TRUE, 0, NOW);
+
+    /* when */
+    /* then */
+    mctest_assert_false (file_select_match (fs, dotdot));
+    mctest_assert_false (file_select_match (fs, dir));
+
+    fs->files_only = FALSE;
+    mctest_assert_false (file_select_match (fs, dotdot));
+    mctest_assert_true (file_select_match (fs, dir));
+
+    free_entry (dir);
+    free_entry (dotdot);
+    file_select_free (fs);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_file_select_size_age)
+/* *INDENT-ON* */
+{
+    /* given */
+    file_select_t *fs;
+    file_entry_t *small_new, *big_old;
+
+    fs = file_select_new ("", TRUE, TRUE, FALSE);
+    small_new = make_entry ("a", FALSE, 100, NOW - DAY / 2);
+    big_old = make_entry ("b", FALSE, 2 * 1024 * 1024, NOW - 10 * DAY);
+
+    /* when */
+    /* then */
+    mctest_assert_true (file_select_set_size (fs, ">1M"));
+    mctest_assert_false (file_select_match (fs, small_new));
+    mctest_assert_true (file_select_match (fs, big_old));
+
+    mctest_assert_true (file_select_set_size (fs, "100"));
+    mctest_assert_true (file_select_match (fs, small_new));
+    mctest_assert_false (file_select_match (fs, big_old));
+
+    mctest_assert_true (file_select_set_size (fs, ""));
+    mctest_assert_true (file_select_set_age (fs, "1d", NOW));
+    mctest_assert_true (file_select_match (fs, small_new));
+    mctest_assert_false (file_select_match (fs, big_old));
+
+    mctest_assert_true (file_select_set_age (fs, "> 1w", NOW));
+    mctest_assert_false (file_select_match (fs, small_new));
+    mctest_assert_true (file_select_match (fs, big_old));
+
+    mctest_assert_false (file_select_set_size (fs, ">1Q"));
+    mctest_assert_false (file_select_set_age (fs, "=1d", NOW));
+    mctest_assert_false (file_select_set_age (fs, "1y", NOW));
+
+    free_entry (big_old);
+    free_entry (small_new);
+    file_select_free (fs);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_file_select_match, test_file_select_match_ds);
+    tcase_add_test (tc_core, test_file_select_dirs);
+    tcase_add_test (tc_core, test_file_select_size_age);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "file_select_match.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
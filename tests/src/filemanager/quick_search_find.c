@@ -0,0 +1,209 @@
+/*
+   src/filemanager - tests for quick_search_find() function
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+
+#include "src/filemanager/quicksearch.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *names[] = {
+    "..", "Makefile", "main.c", "main.h", "mc.ext", "README", "readme.txt", "src",
+    "my_awesome_file.c", "Mail", "xmain", NULL
+};
+
+static dir_list list;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int i;
+
+    str_init_strings (NULL);
+
+    memset (&list, 0, sizeof (list));
+    for (i = 0; names[i] != NULL; i++)
+    {
+        struct stat st;
+
+        memset (&st, 0, sizeof (st));
+        dir_list_append (&list, names[i], &st, FALSE, FALSE);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    dir_list_free_list (&list);
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_quick_search_find_ds") */
+/* *INDENT-OFF* */
+static const struct test_quick_search_find_ds
+{
+    gboolean input_case_sensitive;
+    gboolean input_fuzzy;
+    const char *input_pattern;
+    int input_current;
+    const char *expected_name;
+} test_quick_search_find_ds[] =
+{
+    { /* 0. prefix */
+        FALSE, FALSE, "m", 0, "Makefile"
+    },
+    { /* 1. prefix, from the cursor */
+        FALSE, FALSE, "m", 3, "main.h"
+    },
+    { /* 2. prefix, wrap around */
+        FALSE, FALSE, "mai", 10, "main.c"
+    },
+    { /* 3. prefix, not found */
+        FALSE, FALSE, "mx", 0, NULL
+    },
+    { /* 4. prefix, case insensitive */
+        FALSE, FALSE, "READ", 6, "readme.txt"
+    },
+    { /* 5. prefix, case sensitive */
+        TRUE, FALSE, "m", 0, "main.c"
+    },
+    { /* 6. prefix, case sensitive */
+        TRUE, FALSE, "READ", 6, "README"
+    },
+    { /* 7. wildcards */
+        FALSE, FALSE, "m*c", 3, "mc.ext"
+    },
+    { /* 8. wildcards */
+        FALSE, FALSE, "*.c", 0, "main.c"
+    },
+    { /* 9. wildcards */
+        FALSE, FALSE, "?ain", 3, "main.h"
+    },
+    { /* 10. fuzzy */
+        FALSE, TRUE, "mc", 0, "mc.ext"
+    },
+    { /* 11. fuzzy */
+        FALSE, TRUE, "rt", 0, "readme.txt"
+    },
+    { /* 12. fuzzy, not found */
+        FALSE, TRUE, "zz", 0, NULL
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_quick_search_find_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_quick_search_find, test_quick_search_find_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    quick_search_t *qs;
+    int actual;
+
+    qs = quick_search_new (&list, data->input_case_sensitive, data->input_fuzzy);
+
+    /* when */
+    actual = quick_search_find (qs, data->input_pattern, data->input_current, FALSE);
+
+    /* then */
+    if (data->expected_name == NULL)
+        mctest_assert_int_eq (actual, -1);
+    else
+    {
+        mctest_assert_true (actual >= 0);
+        mctest_assert_str_eq (list.list[actual].fname, data->expected_name);
+    }
+
+    quick_search_free (&qs);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_quick_search_incremental)
+/* *INDENT-ON* */
+{
+    /* given */
+    quick_search_t *qs;
+    int actual;
+
+    qs = quick_search_new (&list, FALSE, FALSE);
+
+    /* when */
+    (void) quick_search_find (qs, "m*", 0, FALSE);
+    (void) quick_search_find (qs, "m*e", 0, FALSE);
+    (void) quick_search_find (qs, "m*ex", 0, FALSE);
+    actual = quick_search_find (qs, "m*", 3, FALSE);
+
+    /* then */
+    mctest_assert_str_eq (list.list[actual].fname, "main.h");
+
+    quick_search_free (&qs);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_quick_search_find, test_quick_search_find_ds);
+    tcase_add_test (tc_core, test_quick_search_incremental);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "quick_search_find.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,302 @@
+/*
+   src/vfs/decompress - test random access to compressed files
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/decompress"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/util.h"
+#include "lib/vfs/xdirentry.h"
+#include "src/vfs/local/local.c"
+#include "src/vfs/decompress/decompress.c"
+
+/* size of data in one deflate block */
+#define CHUNK_SIZE 1024
+
+/* number of deflate blocks in one gzip member */
+#define CHUNKS 320
+
+/* file consists of two gzip members */
+#define DATA_SIZE (2 * CHUNKS * CHUNK_SIZE)
+
+static unsigned char data[DATA_SIZE];
+static char *gz_name = NULL;
+static vfs_path_t *gz_vpath = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Compress data to gzip member. Each chunk is put to its own deflate block, blocks aren't aligned
+ * to byte boundary.
+ */
+
+static void
+write_gzip_member (int fd, const unsigned char *buf, size_t len)
+{
+    z_stream zs;
+    unsigned char *out;
+    size_t out_size, pos;
+
+    memset (&zs, 0, sizeof (zs));
+    ck_assert (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8,
+                             Z_DEFAULT_STRATEGY) == Z_OK);
+
+    out_size = deflateBound (&zs, len) + len / CHUNK_SIZE * 16;
+    out = g_malloc (out_size);
+    zs.next_out = out;
+    zs.avail_out = (uInt) out_size;
+
+    for (pos = 0; pos < len; pos += CHUNK_SIZE)
+    {
+        zs.next_in = (unsigned char *) buf + pos;
+        zs.avail_in = (uInt) MIN (CHUNK_SIZE, len - pos);
+        ck_assert (deflate (&zs, pos + CHUNK_SIZE < len ? Z_BLOCK : Z_FINISH) != Z_STREAM_ERROR);
+    }
+
+    ck_assert (zs.avail_in == 0);
+    ck_assert (write (fd, out, out_size - zs.avail_out) == (ssize_t) (out_size - zs.avail_out));
+
+    deflateEnd (&zs);
+    g_free (out);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static decompress_fh_t *
+open_gzip (void)
+{
+    decompress_fh_t *fh;
+
+    fh = DECOMPRESS_FH (decompress_open (gz_vpath, O_RDONLY, 0));
+    ck_assert (fh != NULL);
+
+    /* put restart point at every deflate block to get more of them than allowed */
+    fh->span = CHUNK_SIZE;
+
+    return fh;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_read (decompress_fh_t * fh, off_t offset, size_t len)
+{
+    unsigned char buf[3 * CHUNK_SIZE];
+    ssize_t n;
+
+    mctest_assert_int_eq (decompress_lseek (fh, offset, SEEK_SET), offset);
+
+    n = decompress_read (fh, (char *) buf, len);
+    mctest_assert_int_eq (n, MIN ((off_t) len, DATA_SIZE - offset));
+    ck_assert_msg (memcmp (buf, data + offset, (size_t) n) == 0, "wrong data at %ld",
+                   (long) offset);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    guint32 r = 1;
+    size_t i;
+    int fd;
+    char *path;
+
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_init_decompressfs ();
+    vfs_setup_work_dir ();
+
+    /* compressible, but not too much */
+    for (i = 0; i < DATA_SIZE; i++)
+    {
+        r = r * 1103515245 + 12345;
+        data[i] = (unsigned char) ('a' + (r >> 16) % 16);
+    }
+
+    fd = g_file_open_tmp ("mctest-XXXXXX.gz", &gz_name, NULL);
+    ck_assert (fd != -1);
+    write_gzip_member (fd, data, DATA_SIZE / 2);
+    write_gzip_member (fd, data + DATA_SIZE / 2, DATA_SIZE / 2);
+    close (fd);
+
+    path = g_strconcat (gz_name, decompress_extension (COMPRESSION_GZIP), (char *) NULL);
+    gz_vpath = vfs_path_from_str (path);
+    g_free (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    vfs_path_free (gz_vpath);
+    unlink (gz_name);
+    g_free (gz_name);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_sequential)
+/* *INDENT-ON* */
+{
+    decompress_fh_t *fh;
+    unsigned char buf[CHUNK_SIZE + 17];
+    off_t pos = 0;
+    ssize_t n;
+    struct stat st;
+    guint i;
+    gboolean bits = FALSE;
+
+    fh = open_gzip ();
+
+    /* given */
+    while ((n = decompress_read (fh, (char *) buf, sizeof (buf))) > 0)
+    {
+        ck_assert_msg (memcmp (buf, data + pos, (size_t) n) == 0, "wrong data at %ld", (long) pos);
+        pos += n;
+    }
+
+    /* then */
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (pos, DATA_SIZE);
+
+    ck_assert (decompress_fstat (fh, &st) == 0);
+    mctest_assert_int_eq (st.st_size, DATA_SIZE);
+
+    /* restart points were thinned out */
+    ck_assert (fh->points->len <= DECOMPRESS_MAX_POINTS);
+    ck_assert (fh->points->len > DECOMPRESS_MAX_POINTS / 4);
+    ck_assert (fh->span > CHUNK_SIZE);
+
+    for (i = 0; i < fh->points->len; i++)
+        if (g_array_index (fh->points, decompress_point_t, i).bits != 0)
+            bits = TRUE;
+    ck_assert_msg (bits, "all restart points are byte aligned");
+
+    decompress_close (fh);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_seek_backward)
+/* *INDENT-ON* */
+{
+    decompress_fh_t *fh;
+    off_t offset;
+
+    fh = open_gzip ();
+
+    /* when */
+    mctest_assert_int_eq (decompress_lseek (fh, -100, SEEK_END), DATA_SIZE - 100);
+
+    /* then */
+    for (offset = DATA_SIZE - 100; offset > 0; offset -= 7 * CHUNK_SIZE + 333)
+        check_read (fh, offset, 2 * CHUNK_SIZE);
+    check_read (fh, 0, 2 * CHUNK_SIZE);
+
+    /* across the boundary of gzip members */
+    check_read (fh, DATA_SIZE / 2 - CHUNK_SIZE, 2 * CHUNK_SIZE);
+    check_read (fh, DATA_SIZE / 2 - 1, 2);
+
+    decompress_close (fh);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_seek_forward)
+/* *INDENT-ON* */
+{
+    decompress_fh_t *fh;
+    off_t offset;
+
+    fh = open_gzip ();
+
+    /* when: decode on demand */
+    for (offset = 5; offset < DATA_SIZE; offset += 11 * CHUNK_SIZE + 555)
+        check_read (fh, offset, CHUNK_SIZE);
+
+    check_read (fh, DATA_SIZE - 10, CHUNK_SIZE);
+
+    /* then: jump over restart points */
+    check_read (fh, 0, CHUNK_SIZE);
+    for (offset = 3 * CHUNK_SIZE + 1; offset < DATA_SIZE; offset += 13 * CHUNK_SIZE + 777)
+        check_read (fh, offset, 3 * CHUNK_SIZE);
+
+    decompress_close (fh);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_decompress_sequential);
+    tcase_add_test (tc_core, test_decompress_seek_backward);
+    tcase_add_test (tc_core, test_decompress_seek_forward);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "decompress_seek.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,520 @@
+/*
+   src/vfs/zip - test reading of zip archive structures
+
+   Copyright (C) 2019
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/zip"
+
+#include "tests/mctest.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "lib/strutil.h"
+#include "lib/vfs/xdirentry.h"
+#include "src/vfs/local/local.c"
+#include "src/vfs/zip/zip.c"
+
+#define MEMBER_DATA "hello, world"
+#define MEMBER_SIZE (sizeof (MEMBER_DATA) - 1)
+
+static GByteArray *archive = NULL;
+static char *zip_name = NULL;
+static zip_super_t arch;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+put16 (guint16 v)
+{
+    guint8 b[2] = { v & 0xff, v >> 8 };
+
+    g_byte_array_append (archive, b, sizeof (b));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+put32 (guint32 v)
+{
+    put16 (v & 0xffff);
+    put16 (v >> 16);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+put64 (guint64 v)
+{
+    put32 (v & 0xffffffffU);
+    put32 (v >> 32);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+put_str (const char *s)
+{
+    g_byte_array_append (archive, (const guint8 *) s, strlen (s));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Write archive to temporary file and open it.
+ */
+
+static void
+open_archive (void)
+{
+    vfs_path_t *vpath;
+    int fd;
+
+    fd = g_file_open_tmp ("mctest-XXXXXX.zip", &zip_name, NULL);
+    ck_assert (fd != -1);
+    ck_assert (write (fd, archive->data, archive->len) == (ssize_t) archive->len);
+    close (fd);
+
+    vpath = vfs_path_from_str (zip_name);
+    arch.fd = mc_open (vpath, O_RDONLY);
+    ck_assert (arch.fd != -1);
+    ck_assert (mc_fstat (arch.fd, &arch.st) == 0);
+    vfs_path_free (vpath);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create archive with one stored member and open it.
+ *
+ * @param prefix size of data before archive
+ * @param zip64  use ZIP64 end of central directory record
+ * @param crc    CRC-32 of member data written to archive
+ * @param cd_start offset of central directory relative to the start of archive
+ * @param cd_size  size of central directory
+ */
+
+static void
+make_archive (size_t prefix, gboolean zip64, guint32 crc, off_t * cd_start, off_t * cd_size)
+{
+    size_t i;
+    off_t eocd64;
+
+    for (i = 0; i < prefix; i++)
+        put_str ("x");
+
+    /* local header */
+    put32 (ZIP_LOCAL_SIG);
+    put16 (20);
+    put16 (0);
+    put16 (ZIP_METHOD_STORED);
+    put32 (0);
+    put32 (crc);
+    put32 (MEMBER_SIZE);
+    put32 (MEMBER_SIZE);
+    put16 (1);
+    put16 (0);
+    put_str ("a");
+    put_str (MEMBER_DATA);
+
+    /* central directory */
+    *cd_start = (off_t) (archive->len - prefix);
+    put32 (ZIP_CDIR_SIG);
+    put16 ((ZIP_HOST_UNIX << 8) | 30);
+    put16 (20);
+    put16 (0);
+    put16 (ZIP_METHOD_STORED);
+    put32 (0);
+    put32 (crc);
+    put32 (MEMBER_SIZE);
+    put32 (MEMBER_SIZE);
+    put16 (1);
+    put16 (0);
+    put16 (0);
+    put16 (0);
+    put16 (0);
+    put32 ((guint32) (S_IFREG | 0644) << 16);
+    put32 (0);
+    put_str ("a");
+    *cd_size = (off_t) (archive->len - prefix) - *cd_start;
+
+    if (zip64)
+    {
+        eocd64 = (off_t) (archive->len - prefix);
+        put32 (ZIP_EOCD64_SIG);
+        put64 (ZIP_EOCD64_SIZE - 12);
+        put16 (45);
+        put16 (45);
+        put32 (0);
+        put32 (0);
+        put64 (1);
+        put64 (1);
+        put64 ((guint64) * cd_size);
+        put64 ((guint64) * cd_start);
+
+        put32 (ZIP_EOCD64_LOC_SIG);
+        put32 (0);
+        put64 ((guint64) eocd64);
+        put32 (1);
+    }
+
+    put32 (ZIP_EOCD_SIG);
+    put16 (0);
+    put16 (0);
+    put16 (zip64 ? 0xffff : 1);
+    put16 (zip64 ? 0xffff : 1);
+    put32 (zip64 ? 0xffffffffU : (guint32) * cd_size);
+    put32 (zip64 ? 0xffffffffU : (guint32) * cd_start);
+    put16 (7);
+    put_str ("comment");
+
+    open_archive ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    archive = g_byte_array_new ();
+    memset (&arch, 0, sizeof (arch));
+    arch.fd = -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    if (arch.fd != -1)
+        mc_close (arch.fd);
+    if (zip_name != NULL)
+        unlink (zip_name);
+    g_free (zip_name);
+    zip_name = NULL;
+    g_byte_array_free (archive, TRUE);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_zip_find_central_directory_ds") */
+/* *INDENT-OFF* */
+static const struct test_zip_find_central_directory_ds
+{
+    size_t prefix;
+    gboolean zip64;
+} test_zip_find_central_directory_ds[] =
+{
+    { /* 0. */
+        0,
+        FALSE
+    },
+    { /* 1. self-extractor */
+        100,
+        FALSE
+    },
+    { /* 2. */
+        0,
+        TRUE
+    },
+    { /* 3. offset of ZIP64 record in locator is relative to the start of archive */
+        100,
+        TRUE
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_zip_find_central_directory_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_zip_find_central_directory, test_zip_find_central_directory_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t cd_start, cd_size;
+    off_t cd_offset = -1, size = -1;
+    gboolean ok;
+
+    make_archive (data->prefix, data->zip64, 0, &cd_start, &cd_size);
+
+    /* when */
+    ok = zip_find_central_directory (&arch, &cd_offset, &size);
+
+    /* then */
+    ck_assert (ok);
+    mctest_assert_int_eq (arch.shift, data->prefix);
+    mctest_assert_int_eq (cd_offset, (off_t) data->prefix + cd_start);
+    mctest_assert_int_eq (size, cd_size);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_zip_find_central_directory_truncated)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t cd_start, cd_size;
+    off_t cd_offset, size;
+
+    make_archive (0, FALSE, 0, &cd_start, &cd_size);
+
+    /* when: end of central directory record is cut */
+    arch.st.st_size -= 10;
+
+    /* then */
+    ck_assert (!zip_find_central_directory (&arch, &cd_offset, &size));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_zip_parse_extra)
+/* *INDENT-ON* */
+{
+    /* given */
+    zip_member_t m;
+    struct stat st;
+
+    m.size = ZIP_MAX32;
+    m.csize = 1000;
+    m.offset = ZIP_MAX32;
+    memset (&st, 0, sizeof (st));
+
+    /* ZIP64: only values which don't fit to the central directory record */
+    put16 (ZIP_EXTRA_ZIP64);
+    put16 (16);
+    put64 (G_GUINT64_CONSTANT (0x123456789));
+    put64 (G_GUINT64_CONSTANT (0x987654321));
+    /* extended timestamp: modification and access time */
+    put16 (ZIP_EXTRA_TIMESTAMP);
+    put16 (9);
+    g_byte_array_append (archive, (const guint8 *) "\x03", 1);
+    put32 (1500000000);
+    put32 (1);
+    /* Info-ZIP Unix: 2-byte uid and 4-byte gid */
+    put16 (ZIP_EXTRA_UNIX);
+    put16 (9);
+    g_byte_array_append (archive, (const guint8 *) "\x01\x02", 2);
+    put16 (1001);
+    g_byte_array_append (archive, (const guint8 *) "\x04", 1);
+    put32 (70000);
+    /* truncated field is ignored */
+    put16 (ZIP_EXTRA_UNIX);
+    put16 (100);
+    put16 (0);
+
+    /* when */
+    zip_parse_extra (archive->data, archive->len, &m, &st);
+
+    /* then */
+    mctest_assert_int_eq (m.size, G_GINT64_CONSTANT (0x123456789));
+    mctest_assert_int_eq (m.csize, 1000);
+    mctest_assert_int_eq (m.offset, G_GINT64_CONSTANT (0x987654321));
+    mctest_assert_int_eq (st.st_mtime, 1500000000);
+    mctest_assert_int_eq (st.st_uid, 1001);
+    mctest_assert_int_eq (st.st_gid, 70000);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_zip_stored_member_crc)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t cd_start, cd_size;
+    zip_member_t m;
+    zip_fh_t zfh;
+    char buf[MEMBER_SIZE];
+
+    make_archive (100, FALSE, 0xdeadbeef, &cd_start, &cd_size);
+    ck_assert (zip_find_central_directory (&arch, &cd_start, &cd_size));
+
+    m.method = ZIP_METHOD_STORED;
+    m.flags = 0;
+    m.crc = crc32 (0L, (const Bytef *) MEMBER_DATA, MEMBER_SIZE);
+    m.csize = MEMBER_SIZE;
+    m.size = MEMBER_SIZE;
+    m.offset = arch.shift;
+
+    memset (&zfh, 0, sizeof (zfh));
+    mctest_assert_int_eq (zip_member_open (&arch, &zfh, &m), 0);
+
+    /* when: read sequentially */
+    mctest_assert_int_eq (zip_member_read (&arch, &zfh, 0, buf, 5), 5);
+    mctest_assert_int_eq (zip_member_read (&arch, &zfh, 5, buf + 5, sizeof (buf)),
+                          MEMBER_SIZE - 5);
+
+    /* then */
+    ck_assert (memcmp (buf, MEMBER_DATA, MEMBER_SIZE) == 0);
+
+    /* when: CRC in archive is wrong */
+    zfh.member.crc = 0xdeadbeef;
+
+    /* then: error is detected at the end of member */
+    mctest_assert_int_eq (zip_member_read (&arch, &zfh, 0, buf, 5), 5);
+    mctest_assert_int_eq (zip_member_read (&arch, &zfh, 5, buf + 5, sizeof (buf)), -1);
+
+    /* random access: CRC isn't checked */
+    mctest_assert_int_eq (zip_member_read (&arch, &zfh, 7, buf, sizeof (buf)), MEMBER_SIZE - 7);
+
+    zip_member_close (&zfh);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_zip_deflated_member_read)
+/* *INDENT-ON* */
+{
+    /* given */
+    static unsigned char content[64 * 1024];
+    guint32 r = 1;
+    z_stream zs;
+    unsigned char *cdata;
+    size_t csize, i;
+    zip_member_t m;
+    zip_fh_t zfh;
+    char buf[16];
+    off_t pos = 0;
+    ssize_t n;
+
+    for (i = 0; i < sizeof (content); i++)
+    {
+        r = r * 1103515245 + 12345;
+        content[i] = (unsigned char) ('a' + (r >> 16) % 8);
+    }
+    /* last match is copied after the whole input is consumed */
+    memset (content + sizeof (content) - 38, 'a', 38);
+
+    memset (&zs, 0, sizeof (zs));
+    ck_assert (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                             Z_DEFAULT_STRATEGY) == Z_OK);
+    csize = deflateBound (&zs, sizeof (content));
+    cdata = g_malloc (csize);
+    zs.next_in = content;
+    zs.avail_in = sizeof (content);
+    zs.next_out = cdata;
+    zs.avail_out = (uInt) csize;
+    ck_assert (deflate (&zs, Z_FINISH) == Z_STREAM_END);
+    csize -= zs.avail_out;
+    deflateEnd (&zs);
+
+    put32 (ZIP_LOCAL_SIG);
+    put16 (20);
+    put16 (0);
+    put16 (ZIP_METHOD_DEFLATED);
+    put32 (0);
+    put32 (0);
+    put32 ((guint32) csize);
+    put32 (sizeof (content));
+    put16 (1);
+    put16 (0);
+    put_str ("a");
+    g_byte_array_append (archive, cdata, (guint) csize);
+    g_free (cdata);
+    open_archive ();
+
+    m.method = ZIP_METHOD_DEFLATED;
+    m.flags = 0;
+    m.crc = crc32 (0L, content, sizeof (content));
+    m.csize = (off_t) csize;
+    m.size = sizeof (content);
+    m.offset = 0;
+
+    memset (&zfh, 0, sizeof (zfh));
+    mctest_assert_int_eq (zip_member_open (&arch, &zfh, &m), 0);
+
+    /* when: read in small pieces, so output is pending in zlib when input is consumed */
+    for (i = 1; (n = zip_member_read (&arch, &zfh, pos, buf, i % sizeof (buf) + 1)) > 0; i++)
+    {
+        ck_assert_msg (memcmp (buf, content + pos, (size_t) n) == 0, "wrong data at %ld",
+                       (long) pos);
+        pos += n;
+    }
+
+    /* then */
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (pos, sizeof (content));
+
+    zip_member_close (&zfh);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_zip_find_central_directory,
+                                   test_zip_find_central_directory_ds);
+    tcase_add_test (tc_core, test_zip_find_central_directory_truncated);
+    tcase_add_test (tc_core, test_zip_parse_extra);
+    tcase_add_test (tc_core, test_zip_stored_member_crc);
+    tcase_add_test (tc_core, test_zip_deflated_member_read);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "zip_archive.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? 0 : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */